@@ -0,0 +1,369 @@
+/*!
+ * @file
+ * @brief Rules for builtin functions.
+ */
+
+#include "builtins.h"
+#include "../dsl/dsl.h"
+#include "../taylor/taylor.h"
+#include "../tree/token_specific.h"
+#include "../utilities/utilities.h"
+#include "../vecmath/vecmath.h"
+
+#include <assert.h>
+#include <math.h>
+
+
+
+
+/*!
+ * @brief Derivative of sine.
+ *
+ * @return cos(arg).
+ */
+static bintree_t sin_derivative
+(
+	bintree_t arg /*!< [in] function's argument.                             */
+)
+{
+	bintree_t root = BINTREE_NULL;
+	token_t   t;
+	D_NEW_FUNC(root, SYMBOL_COS, arg);
+	return root;
+}
+
+/*!
+ * @brief Derivative of cosine.
+ *
+ * @return -sin(arg).
+ */
+static bintree_t cos_derivative
+(
+	bintree_t arg /*!< [in] function's argument.                             */
+)
+{
+	bintree_t root = BINTREE_NULL;
+	token_t   t;
+	D_NEW_FUNC(root, SYMBOL_SIN, arg);
+	D_NEW_PREFUNOP(root, OP_MINUS, root);
+	return root;
+}
+
+/*!
+ * @brief Derivative of tangent.
+ *
+ * @return 1 / cos(arg)^2.
+ */
+static bintree_t tg_derivative
+(
+	bintree_t arg /*!< [in] function's argument.                             */
+)
+{
+	bintree_t root = BINTREE_NULL;
+	token_t   t;
+	D_NEW_FUNC(root, SYMBOL_COS, arg);
+	D_NEW_OP(root, OP_POW, root, create_number(2));
+	D_NEW_OP(root, OP_DIV, create_number(1), root);
+	return root;
+}
+
+/*!
+ * @brief Derivative of cotangent.
+ *
+ * @return 1 / -sin(arg)^2.
+ */
+static bintree_t ctg_derivative
+(
+	bintree_t arg /*!< [in] function's argument.                             */
+)
+{
+	bintree_t root = BINTREE_NULL;
+	token_t   t;
+	D_NEW_FUNC(root, SYMBOL_SIN, arg);
+	D_NEW_OP(root, OP_POW, root, create_number(2));
+	D_NEW_PREFUNOP(root, OP_MINUS, root);
+	D_NEW_OP(root, OP_DIV, create_number(1), root);
+	return root;
+}
+
+/*!
+ * @brief Derivative of natural logarithm.
+ *
+ * @return 1 / arg.
+ */
+static bintree_t ln_derivative
+(
+	bintree_t arg /*!< [in] function's argument.                             */
+)
+{
+	bintree_t root = BINTREE_NULL;
+	token_t   t;
+	D_NEW_OP(root, OP_DIV, create_number(1), arg);
+	return root;
+}
+
+/*!
+ * @brief Derivative of sine in the expression store.
+ *
+ * @return cos(arg).
+ */
+static dag_t sin_dag_derivative
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	dag_t       arg    /*!< [in]     function's argument.                    */
+)
+{
+	return dag_func(store, SYMBOL_COS, arg);
+}
+
+/*!
+ * @brief Derivative of cosine in the expression store.
+ *
+ * @return -sin(arg).
+ */
+static dag_t cos_dag_derivative
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	dag_t       arg    /*!< [in]     function's argument.                    */
+)
+{
+	return dag_prefunop(store, OP_MINUS, dag_func(store, SYMBOL_SIN, arg));
+}
+
+/*!
+ * @brief Derivative of tangent in the expression store.
+ *
+ * @return 1 / cos(arg)^2.
+ */
+static dag_t tg_dag_derivative
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	dag_t       arg    /*!< [in]     function's argument.                    */
+)
+{
+	dag_t root = dag_func(store, SYMBOL_COS, arg);
+	root = dag_binop(store, OP_POW, root, dag_number(store, 2));
+	return dag_binop(store, OP_DIV, dag_number(store, 1), root);
+}
+
+/*!
+ * @brief Derivative of cotangent in the expression store.
+ *
+ * @return 1 / -sin(arg)^2.
+ */
+static dag_t ctg_dag_derivative
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	dag_t       arg    /*!< [in]     function's argument.                    */
+)
+{
+	dag_t root = dag_func(store, SYMBOL_SIN, arg);
+	root = dag_binop(store, OP_POW, root, dag_number(store, 2));
+	root = dag_prefunop(store, OP_MINUS, root);
+	return dag_binop(store, OP_DIV, dag_number(store, 1), root);
+}
+
+/*!
+ * @brief Derivative of natural logarithm in the expression store.
+ *
+ * @return 1 / arg.
+ */
+static dag_t ln_dag_derivative
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	dag_t       arg    /*!< [in]     function's argument.                    */
+)
+{
+	return dag_binop(store, OP_DIV, dag_number(store, 1), arg);
+}
+
+/*!
+ * @brief Calculate cotangent.
+ *
+ * @return Cotangent of argument.
+ */
+static double ctg
+(
+	double arg /*!< [in] function's argument.                                */
+)
+{
+	return 1 / tan(arg);
+}
+
+/*!
+ * @brief Simplify sin(0) and tg(0).
+ *
+ * @return True if node was changed else false.
+ */
+static bool odd_simplify
+(
+	bintree_t expression /*!< [in,out] function node.                        */
+)
+{
+	if (D_ARG_TYPE == TOKEN_NUMBER && double_equal(D_ARG_NUMBER, 0))
+	{
+		D_CHANGE_TO_NUMBER(D_NODE, 0);
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+ * @brief Simplify cos(0).
+ *
+ * @return True if node was changed else false.
+ */
+static bool cos_simplify
+(
+	bintree_t expression /*!< [in,out] function node.                        */
+)
+{
+	if (D_ARG_TYPE == TOKEN_NUMBER && double_equal(D_ARG_NUMBER, 0))
+	{
+		D_CHANGE_TO_NUMBER(D_NODE, 1);
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+ * @brief Simplify ctg(x). There are no simple special points.
+ *
+ * @return False.
+ */
+static bool ctg_simplify
+(
+	bintree_t expression /*!< [in,out] function node.                        */
+)
+{
+	MAYBE_UNUSED(expression);
+	return false;
+}
+
+/*!
+ * @brief Simplify ln(1) and ln(e).
+ *
+ * @return True if node was changed else false.
+ */
+static bool ln_simplify
+(
+	bintree_t expression /*!< [in,out] function node.                        */
+)
+{
+	if (D_ARG_TYPE == TOKEN_NUMBER && double_equal(D_ARG_NUMBER, 1))
+	{
+		D_CHANGE_TO_NUMBER(D_NODE, 0);
+		return true;
+	}
+
+	if (D_ARG_TYPE == TOKEN_VAR && D_ARG_IDENT == SYMBOL_E)
+	{
+		D_CHANGE_TO_NUMBER(D_NODE, 1);
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+ * @brief Series of sine.
+ */
+static void sin_series
+(
+	double*       result,  /*!< [out] series of function.                    */
+	const double* arg,     /*!< [in]  series of argument.                    */
+	double*       scratch, /*!< [in]  scratch series.                        */
+	size_t        order    /*!< [in]  order of series.                       */
+)
+{
+	taylor_sincos(result, scratch, arg, order);
+}
+
+/*!
+ * @brief Series of cosine.
+ */
+static void cos_series
+(
+	double*       result,  /*!< [out] series of function.                    */
+	const double* arg,     /*!< [in]  series of argument.                    */
+	double*       scratch, /*!< [in]  scratch series.                        */
+	size_t        order    /*!< [in]  order of series.                       */
+)
+{
+	taylor_sincos(scratch, result, arg, order);
+}
+
+/*!
+ * @brief Series of tangent.
+ */
+static void tg_series
+(
+	double*       result,  /*!< [out] series of function.                    */
+	const double* arg,     /*!< [in]  series of argument.                    */
+	double*       scratch, /*!< [in]  scratch series.                        */
+	size_t        order    /*!< [in]  order of series.                       */
+)
+{
+	taylor_sincos(result, scratch, arg, order);
+	taylor_div(result, result, scratch, order);
+}
+
+/*!
+ * @brief Series of cotangent.
+ */
+static void ctg_series
+(
+	double*       result,  /*!< [out] series of function.                    */
+	const double* arg,     /*!< [in]  series of argument.                    */
+	double*       scratch, /*!< [in]  scratch series.                        */
+	size_t        order    /*!< [in]  order of series.                       */
+)
+{
+	taylor_sincos(scratch, result, arg, order);
+	taylor_div(result, result, scratch, order);
+}
+
+/*!
+ * @brief Series of natural logarithm.
+ */
+static void ln_series
+(
+	double*       result,  /*!< [out] series of function.                    */
+	const double* arg,     /*!< [in]  series of argument.                    */
+	double*       scratch, /*!< [in]  scratch series.                        */
+	size_t        order    /*!< [in]  order of series.                       */
+)
+{
+	MAYBE_UNUSED(scratch);
+	taylor_ln(result, arg, order);
+}
+
+/*!
+ * @brief Rules of builtin functions indexed by function id.
+ */
+static const builtin_rule_t BUILTIN_RULES[FUNCTIONS_BUILTIN_AMOUNT] =
+{
+	[FUNC_SIN] = {SYMBOL_SIN, "\\operatorname{sin}", "sin",     sin_derivative,
+	              sin_dag_derivative, sin, vecmath_sin, odd_simplify, sin_series},
+	[FUNC_COS] = {SYMBOL_COS, "\\operatorname{cos}", "cos",     cos_derivative,
+	              cos_dag_derivative, cos, vecmath_cos, cos_simplify, cos_series},
+	[FUNC_TG]  = {SYMBOL_TG,  "\\operatorname{tg}",  "tan",     tg_derivative,
+	              tg_dag_derivative,  tan, vecmath_tg,  odd_simplify, tg_series},
+	[FUNC_CTG] = {SYMBOL_CTG, "\\operatorname{ctg}", "1 / tan", ctg_derivative,
+	              ctg_dag_derivative, ctg, vecmath_ctg, ctg_simplify, ctg_series},
+	[FUNC_LN]  = {SYMBOL_LN,  "\\operatorname{ln}",  "log",     ln_derivative,
+	              ln_dag_derivative,  log, vecmath_ln,  ln_simplify,  ln_series},
+};
+
+
+
+
+const builtin_rule_t* builtin_rule (function_t func)
+{
+	if ((size_t) func >= FUNCTIONS_BUILTIN_AMOUNT)
+		return NULL;
+
+	return &BUILTIN_RULES[func];
+}
@@ -0,0 +1,85 @@
+/*!
+ * @file
+ * @brief Header of the table with rules for builtin functions.
+ */
+
+#ifndef BUILTINS_H_
+#define BUILTINS_H_
+
+#include "../tree/bintree.h"
+#include "../dag/dag.h"
+
+
+
+/*!
+ * @brief Rules of builtin function.
+ */
+typedef struct
+{
+	symbol_t    name;     /*!< name of function.                             */
+	const char* tex_name; /*!< name of function in tex format.               */
+	const char* c_name;   /*!< call of function in C without argument.       */
+
+	/*!
+	 * @brief Build derivative of function at given argument
+	 * without multiplication by derivative of the argument.
+	 *
+	 * @note Argument is owned by the derivative and freed if an error occurred.
+	 *
+	 * @return Derivative or NULL if an error occurred.
+	 */
+	bintree_t (*derivative) (bintree_t arg);
+
+	/*!
+	 * @brief The same as derivative() but in the hash-consed store.
+	 *
+	 * @return Derivative or DAG_NONE if an error occurred.
+	 */
+	dag_t (*dag_derivative) (dag_store_t store, dag_t arg);
+
+	/*!
+	 * @brief Calculate value of function.
+	 *
+	 * @return Function value.
+	 */
+	double (*evaluate) (double arg);
+
+	/*!
+	 * @brief Replace every number of array by function value.
+	 */
+	void (*evaluate_batch) (double* values, size_t amount);
+
+	/*!
+	 * @brief Replace function node by its value at special points.
+	 *
+	 * @return True if node was changed else false.
+	 */
+	bool (*simplify) (bintree_t node);
+
+	/*!
+	 * @brief Calculate truncated power series of function of given series.
+	 *
+	 * @note Result isn't the same array as argument. Scratch has room
+	 * for one series.
+	 */
+	void (*series) (double* result, const double* arg,
+	                double* scratch, size_t order);
+}
+builtin_rule_t;
+
+
+
+/*!
+ * @brief Get rules of builtin function.
+ *
+ * @return Rules of function or NULL if function isn't builtin.
+ */
+const builtin_rule_t* builtin_rule
+(
+	function_t func /*!< [in] function id.                                   */
+);
+
+
+
+
+#endif // not defined BUILTINS_H_
@@ -0,0 +1,634 @@
+/*!
+ * @file
+ * @brief Implementation of expression compiler to postfix bytecode.
+ */
+
+#include "bytecode.h"
+#include "../builtins/builtins.h"
+#include "../dag/dag.h"
+#include "../dsl/dsl.h"
+#include "../vecmath/vecmath.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Instructions of the stack machine.
+ */
+typedef enum
+{
+	OPCODE_CONST = 0, //!< push the next constant.
+	OPCODE_X     = 1, //!< push variable x.
+	OPCODE_NEG   = 2, //!< negate the top.
+	OPCODE_ADD   = 3, //!< add the top to the previous value.
+	OPCODE_SUB   = 4, //!< subtract the top from the previous value.
+	OPCODE_MUL   = 5, //!< multiply the previous value by the top.
+	OPCODE_DIV   = 6, //!< divide the previous value by the top.
+	OPCODE_POW   = 7, //!< raise the previous value to the power of the top.
+	OPCODE_FUNC  = 8, //!< apply builtin function whose id is the next byte.
+	OPCODE_LOAD  = 9, //!< push value of the next cell.
+	OPCODE_STORE = 10, //!< pop the top to the next cell.
+}
+opcode_t;
+
+/*!
+ * @brief Compiled expression.
+ */
+struct bytecode
+{
+	uint8_t* code;       /*!< instructions.                                  */
+	size_t   size;       /*!< amount of bytes of instructions.               */
+	size_t   capacity;   /*!< capacity of instructions array.                */
+	double*  constants;  /*!< constants in order of their usage.             */
+	size_t   const_size; /*!< amount of constants.                           */
+	size_t   const_cap;  /*!< capacity of constants array.                   */
+	size_t*  cells;      /*!< cells of loads and stores in order of usage.   */
+	size_t   cells_size; /*!< amount of loads and stores.                    */
+	size_t   cells_cap;  /*!< capacity of cells array.                       */
+	size_t   memory;     /*!< amount of cells with values of shared nodes.   */
+	double*  stack;      /*!< stack of the machine followed by cells.        */
+	size_t   depth;      /*!< depth of stack at the end of instructions.     */
+	size_t   max_depth;  /*!< maximal depth of stack.                        */
+};
+
+/*!
+ * @brief Value of e constant.
+ */
+static const double BYTECODE_E  = 2.71828182845904523536;
+
+/*!
+ * @brief Value of pi constant.
+ */
+static const double BYTECODE_PI = 3.14159265358979323846;
+
+/*!
+ * @brief Amount of points evaluated at once by bytecode_evaluate_batch().
+ */
+static const size_t BYTECODE_BLOCK = 256;
+
+
+
+
+/*!
+ * @brief Append byte to instructions.
+ *
+ * @return Success of appending.
+ */
+static bool bytecode_emit
+(
+	bytecode_t code, /*!< [in,out] compiled expression.                      */
+	uint8_t    byte  /*!< [in]     appended byte.                            */
+)
+{
+	if (code->size == code->capacity)
+	{
+		size_t capacity = (code->capacity) ? code->capacity * 2 : 64;
+		void*  check    = realloc(code->code, capacity * sizeof *code->code);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for bytecode.\n\n", stderr);
+			return false;
+		}
+
+		code->code     = (uint8_t*) check;
+		code->capacity = capacity;
+	}
+
+	code->code[code->size++] = byte;
+	return true;
+}
+
+/*!
+ * @brief Append instruction which pushes value to the stack.
+ *
+ * @return Success of appending.
+ */
+static bool bytecode_emit_push
+(
+	bytecode_t code,   /*!< [in,out] compiled expression.                    */
+	opcode_t   opcode, /*!< [in]     OPCODE_CONST or OPCODE_X.               */
+	double     num     /*!< [in]     pushed constant.                        */
+)
+{
+	if (opcode == OPCODE_CONST && code->const_size == code->const_cap)
+	{
+		size_t capacity = (code->const_cap) ? code->const_cap * 2 : 16;
+		void*  check    = realloc(code->constants,
+		                          capacity * sizeof *code->constants);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for bytecode.\n\n", stderr);
+			return false;
+		}
+
+		code->constants = (double*) check;
+		code->const_cap = capacity;
+	}
+
+	if (!bytecode_emit(code, (uint8_t) opcode))
+		return false;
+
+	if (opcode == OPCODE_CONST)
+		code->constants[code->const_size++] = num;
+
+	if (++code->depth > code->max_depth)
+		code->max_depth = code->depth;
+
+	return true;
+}
+
+/*!
+ * @brief Append instruction which loads or stores value of cell.
+ *
+ * @return Success of appending.
+ */
+static bool bytecode_emit_cell
+(
+	bytecode_t code,   /*!< [in,out] compiled expression.                    */
+	opcode_t   opcode, /*!< [in]     OPCODE_LOAD or OPCODE_STORE.            */
+	size_t     cell    /*!< [in]     number of cell.                         */
+)
+{
+	if (code->cells_size == code->cells_cap)
+	{
+		size_t capacity = (code->cells_cap) ? code->cells_cap * 2 : 16;
+		void*  check    = realloc(code->cells, capacity * sizeof *code->cells);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for bytecode.\n\n", stderr);
+			return false;
+		}
+
+		code->cells     = (size_t*) check;
+		code->cells_cap = capacity;
+	}
+
+	if (!bytecode_emit(code, (uint8_t) opcode))
+		return false;
+
+	code->cells[code->cells_size++] = cell;
+	if (opcode == OPCODE_STORE)
+		--code->depth;
+	else if (++code->depth > code->max_depth)
+		code->max_depth = code->depth;
+
+	return true;
+}
+
+/*!
+ * @brief Append instruction which pushes value of leaf.
+ *
+ * @return Success of compilation.
+ */
+static bool bytecode_leaf
+(
+	bytecode_t     code, /*!< [in,out] compiled expression.                  */
+	const token_t* value /*!< [in]     value of leaf.                        */
+)
+{
+	if (value->type == TOKEN_NUMBER)
+		return bytecode_emit_push(code, OPCODE_CONST, value->value.number);
+
+	if (value->type != TOKEN_VAR)
+		return false;
+
+	switch (value->value.ident)
+	{
+		case SYMBOL_X:
+			return bytecode_emit_push(code, OPCODE_X, 0);
+
+		case SYMBOL_E:
+			return bytecode_emit_push(code, OPCODE_CONST, BYTECODE_E);
+
+		case SYMBOL_PI:
+			return bytecode_emit_push(code, OPCODE_CONST, BYTECODE_PI);
+
+		default:
+			return false;
+	}
+}
+
+/*!
+ * @brief Append instruction of operation whose operands are on the stack.
+ *
+ * @return Success of compilation.
+ */
+static bool bytecode_operation
+(
+	bytecode_t     code,  /*!< [in,out] compiled expression.                 */
+	const token_t* value, /*!< [in]     value of node.                       */
+	bool           unary  /*!< [in]     node has only one operand.           */
+)
+{
+	if (value->type == TOKEN_FUNC)
+		return builtin_rule(value->func) && bytecode_emit(code, OPCODE_FUNC)
+		       && bytecode_emit(code, (uint8_t) value->func);
+
+	if (value->type != TOKEN_OP)
+		return false;
+
+	if (unary)
+	{
+		if (value->value.operation == OP_MINUS)
+			return bytecode_emit(code, OPCODE_NEG);
+
+		return value->value.operation == OP_PLUS;
+	}
+
+	--code->depth;
+	switch (value->value.operation)
+	{
+		case OP_PLUS:  return bytecode_emit(code, OPCODE_ADD);
+		case OP_MINUS: return bytecode_emit(code, OPCODE_SUB);
+		case OP_MUL:   return bytecode_emit(code, OPCODE_MUL);
+		case OP_DIV:   return bytecode_emit(code, OPCODE_DIV);
+		case OP_POW:   return bytecode_emit(code, OPCODE_POW);
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			return false;
+	}
+}
+
+/*!
+ * @brief Append instructions of node whose children are already compiled.
+ *
+ * @return Success of compilation.
+ */
+static bool bytecode_node
+(
+	bytecode_t      code,      /*!< [in,out] compiled expression.            */
+	const bintree_t expression /*!< [in]     compiled node.                  */
+)
+{
+	if (!D_LHS && !D_RHS)
+		return bytecode_leaf(code, &BINTREE_NODE_VALUE(expression));
+
+	// Derivative of function has only the right operand.
+	if (D_TYPE == TOKEN_OP && D_ISPOSTUNARY)
+		return false;
+
+	return bytecode_operation(code, &BINTREE_NODE_VALUE(expression),
+	                          D_TYPE == TOKEN_OP && D_ISPREFUNARY);
+}
+
+/*!
+ * @brief Append instruction which pushes value of operand of node
+ * from the store.
+ *
+ * @return Success of compilation.
+ */
+static bool bytecode_dag_operand
+(
+	bytecode_t        code,    /*!< [in,out] compiled expression.            */
+	const dag_store_t store,   /*!< [in]     expression store.               */
+	dag_t             operand, /*!< [in]     operand.                        */
+	const size_t*     cells    /*!< [in]     cells of nodes.                 */
+)
+{
+	if (operand == DAG_NONE)
+		return true;
+
+	// Leaves are pushed in place, other nodes are already in cells.
+	if (dag_left(store, operand) || dag_right(store, operand))
+		return bytecode_emit_cell(code, OPCODE_LOAD, cells[operand]);
+
+	return bytecode_leaf(code, dag_value(store, operand));
+}
+
+/*!
+ * @brief Append instructions of nodes of the store needed for root.
+ *
+ * @return Success of compilation.
+ */
+static bool bytecode_dag
+(
+	bytecode_t        code,  /*!< [in,out] compiled expression.              */
+	const dag_store_t store, /*!< [in]     expression store.                 */
+	dag_t             root,  /*!< [in]     compiled node.                    */
+	size_t*           cells  /*!< [in,out] zeros, then marks of used nodes
+	                                       and their cells.                  */
+)
+{
+	// Children are always added to the store before their parents,
+	// so every node is computed once in order of ids.
+	cells[root] = 1;
+	for (size_t node = root; node > 0; --node)
+		if (cells[node])
+		{
+			cells[dag_left(store,  (dag_t) node)] = 1;
+			cells[dag_right(store, (dag_t) node)] = 1;
+		}
+
+	for (size_t node = 1; node <= root; ++node)
+	{
+		dag_t left  = dag_left(store,  (dag_t) node);
+		dag_t right = dag_right(store, (dag_t) node);
+		if (!cells[node] || (!left && !right))
+			continue;
+
+		cells[node] = code->memory++;
+		if (!bytecode_dag_operand(code, store, left,  cells)
+		    || !bytecode_dag_operand(code, store, right, cells)
+		    || !bytecode_operation(code, dag_value(store, (dag_t) node),
+		                           !left || !right)
+		    || !bytecode_emit_cell(code, OPCODE_STORE, cells[node]))
+			return false;
+	}
+
+	return bytecode_dag_operand(code, store, root, cells);
+}
+
+/*!
+ * @brief Evaluate compiled expression at block of points.
+ *
+ * @note Arithmetic loops go over the whole block, so they are vectorized
+ * without remainder. Numbers after amount are garbage.
+ */
+VECMATH_DISPATCH
+static void bytecode_evaluate_block
+(
+	const bytecode_t code,   /*!< [in]  compiled expression.                 */
+	double*          stack,  /*!< [in]  stack of max_depth blocks.           */
+	const double*    x,      /*!< [in]  values of variable x.                */
+	double*          values, /*!< [out] values of expression.                */
+	size_t           amount  /*!< [in]  amount of points.                    */
+)
+{
+	// Every cell of the stack is a block of numbers
+	// and top points to the first free cell.
+	double*        top       = stack;
+	double*        memory    = stack + code->max_depth * BYTECODE_BLOCK;
+	const double*  constants = code->constants;
+	const size_t*  cells     = code->cells;
+	const uint8_t* ip        = code->code;
+	const uint8_t* end       = code->code + code->size;
+	while (ip < end)
+	{
+		opcode_t opcode = (opcode_t) *ip++;
+		if (opcode == OPCODE_LOAD || opcode == OPCODE_STORE)
+		{
+			double* cell = memory + *cells++ * BYTECODE_BLOCK;
+			if (opcode == OPCODE_STORE)
+				top -= BYTECODE_BLOCK;
+
+			memcpy((opcode == OPCODE_LOAD) ? top : cell,
+			       (opcode == OPCODE_LOAD) ? cell : top,
+			       BYTECODE_BLOCK * sizeof *top);
+			if (opcode == OPCODE_LOAD)
+				top += BYTECODE_BLOCK;
+
+			continue;
+		}
+
+		if (opcode == OPCODE_CONST)
+		{
+			double num = *constants++;
+			for (size_t i = 0; i < BYTECODE_BLOCK; ++i)
+				top[i] = num;
+
+			top += BYTECODE_BLOCK;
+			continue;
+		}
+
+		if (opcode == OPCODE_X)
+		{
+			memcpy(top, x, amount * sizeof *top);
+			top += BYTECODE_BLOCK;
+			continue;
+		}
+
+		if (opcode == OPCODE_NEG || opcode == OPCODE_FUNC)
+		{
+			double* restrict arg = top - BYTECODE_BLOCK;
+			if (opcode == OPCODE_FUNC)
+				builtin_rule((function_t) *ip++)->evaluate_batch(arg, amount);
+			else
+				for (size_t i = 0; i < BYTECODE_BLOCK; ++i)
+					arg[i] = -arg[i];
+
+			continue;
+		}
+
+		top -= BYTECODE_BLOCK;
+		double* restrict       lhs = top - BYTECODE_BLOCK;
+		const double* restrict rhs = top;
+		switch (opcode)
+		{
+			case OPCODE_ADD:
+				for (size_t i = 0; i < BYTECODE_BLOCK; ++i)
+					lhs[i] += rhs[i];
+				break;
+
+			case OPCODE_SUB:
+				for (size_t i = 0; i < BYTECODE_BLOCK; ++i)
+					lhs[i] -= rhs[i];
+				break;
+
+			case OPCODE_MUL:
+				for (size_t i = 0; i < BYTECODE_BLOCK; ++i)
+					lhs[i] *= rhs[i];
+				break;
+
+			case OPCODE_DIV:
+				for (size_t i = 0; i < BYTECODE_BLOCK; ++i)
+					lhs[i] /= rhs[i];
+				break;
+
+			case OPCODE_POW:
+				vecmath_pow(lhs, rhs, amount);
+				break;
+
+			case OPCODE_CONST:
+			case OPCODE_X:
+			case OPCODE_NEG:
+			case OPCODE_FUNC:
+			case OPCODE_LOAD:
+			case OPCODE_STORE:
+			default:
+				assert ("UNREACHABLE" && false);
+				return;
+		}
+	}
+
+	memcpy(values, stack, amount * sizeof *values);
+}
+
+
+
+
+bytecode_t bytecode_compile (const bintree_t expression)
+{
+	assert (expression);
+
+	bytecode_t code = (bytecode_t) calloc(1, sizeof *code);
+	if (!code)
+	{
+		fputs("Cannot allocate memory for bytecode.\n\n", stderr);
+		return NULL;
+	}
+
+	// Post-order of the tree is exactly postfix notation.
+	bintree_t node = bintree_postorder_first(expression);
+	while (bytecode_node(code, node))
+	{
+		if (node == expression)
+		{
+			code->stack = (double*) calloc(code->max_depth,
+			                               sizeof *code->stack);
+			return (code->stack) ? code : bytecode_destroy(code);
+		}
+
+		node = bintree_postorder_next(expression, node);
+	}
+
+	return bytecode_destroy(code);
+}
+
+
+bytecode_t bytecode_compile_dag (const dag_store_t store, dag_t root)
+{
+	assert (store);
+	assert (root != DAG_NONE);
+
+	bytecode_t code  = (bytecode_t) calloc(1, sizeof *code);
+	size_t*    cells = (size_t*) calloc(dag_store_size(store) + 1,
+	                                    sizeof *cells);
+	if (!code || !cells)
+	{
+		fputs("Cannot allocate memory for bytecode.\n\n", stderr);
+		free(cells);
+		return bytecode_destroy(code);
+	}
+
+	bool ret = bytecode_dag(code, store, root, cells);
+	free(cells);
+	if (ret)
+		code->stack = (double*) calloc(code->max_depth + code->memory,
+		                               sizeof *code->stack);
+
+	return (ret && code->stack) ? code : bytecode_destroy(code);
+}
+
+
+bytecode_t bytecode_destroy (bytecode_t code)
+{
+	if (!code)
+		return NULL;
+
+	free(code->code);
+	free(code->constants);
+	free(code->cells);
+	free(code->stack);
+	free(code);
+	return NULL;
+}
+
+
+double bytecode_evaluate (bytecode_t code, double x)
+{
+	assert (code);
+
+	// top points to the first free cell of the stack.
+	double*        top       = code->stack;
+	double*        memory    = code->stack + code->max_depth;
+	const double*  constants = code->constants;
+	const size_t*  cells     = code->cells;
+	const uint8_t* ip        = code->code;
+	const uint8_t* end       = code->code + code->size;
+	while (ip < end)
+	{
+		switch ((opcode_t) *ip++)
+		{
+			case OPCODE_CONST:
+				*top++ = *constants++;
+				break;
+
+			case OPCODE_X:
+				*top++ = x;
+				break;
+
+			case OPCODE_NEG:
+				top[-1] = -top[-1];
+				break;
+
+			case OPCODE_ADD:
+				--top;
+				top[-1] += top[0];
+				break;
+
+			case OPCODE_SUB:
+				--top;
+				top[-1] -= top[0];
+				break;
+
+			case OPCODE_MUL:
+				--top;
+				top[-1] *= top[0];
+				break;
+
+			case OPCODE_DIV:
+				--top;
+				top[-1] /= top[0];
+				break;
+
+			case OPCODE_POW:
+				--top;
+				top[-1] = pow(top[-1], top[0]);
+				break;
+
+			case OPCODE_FUNC:
+				top[-1] = builtin_rule((function_t) *ip++)->evaluate(top[-1]);
+				break;
+
+			case OPCODE_LOAD:
+				*top++ = memory[*cells++];
+				break;
+
+			case OPCODE_STORE:
+				memory[*cells++] = *--top;
+				break;
+
+			default:
+				assert ("UNREACHABLE" && false);
+				return NAN;
+		}
+	}
+
+	return top[-1];
+}
+
+
+bool bytecode_evaluate_batch (const bytecode_t code, const double* x,
+                              double* values, size_t amount)
+{
+	assert (code);
+	assert (x);
+	assert (values);
+
+	// Stack is zeroed so that garbage at the end of blocks is finite.
+	double* stack = (double*) calloc((code->max_depth + code->memory)
+	                                 * BYTECODE_BLOCK, sizeof *stack);
+	if (!stack)
+	{
+		fputs("Cannot allocate memory for stack of bytecode.\n\n", stderr);
+		return false;
+	}
+
+	for (size_t i = 0; i < amount; i += BYTECODE_BLOCK)
+	{
+		size_t block = (amount - i < BYTECODE_BLOCK) ? amount - i
+		                                             : BYTECODE_BLOCK;
+		bytecode_evaluate_block(code, stack, x + i, values + i, block);
+	}
+
+	free(stack);
+	return true;
+}
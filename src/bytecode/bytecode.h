@@ -0,0 +1,100 @@
+/*!
+ * @file
+ * @brief Header of expression compiler to postfix bytecode.
+ *
+ * Compiled expression is evaluated by a stack machine without any
+ * allocations, so it is much faster than substitution into the tree.
+ */
+
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+#include "../dag/dag.h"
+#include "../tree/bintree.h"
+
+
+
+/*!
+ * @brief Compiled expression.
+ */
+typedef struct bytecode* bytecode_t;
+
+
+
+/*!
+ * @brief Compile expression to bytecode.
+ *
+ * @note Expression can be compiled only if it contains variable x, numbers,
+ * constants e and pi, arithmetic operations and builtin functions.
+ *
+ * @note Don't forget to free memory using bytecode_destroy() function.
+ *
+ * @return Compiled expression or NULL if expression can't be evaluated
+ * numerically or an error occurred.
+ */
+bytecode_t bytecode_compile
+(
+	const bintree_t expression /*!< [in] expression.                         */
+);
+
+/*!
+ * @brief Compile expression from the hash-consed store to bytecode.
+ *
+ * Value of every shared node is computed once and kept in its own cell,
+ * so size of bytecode is proportional to the amount of nodes in the store.
+ *
+ * @note Requirements to expression are the same as in bytecode_compile().
+ *
+ * @return Compiled expression or NULL if expression can't be evaluated
+ * numerically or an error occurred.
+ */
+bytecode_t bytecode_compile_dag
+(
+	const dag_store_t store, /*!< [in] expression store.                     */
+	dag_t             root   /*!< [in] root of expression.                   */
+);
+
+/*!
+ * @brief Destroy compiled expression.
+ *
+ * @return NULL.
+ */
+bytecode_t bytecode_destroy
+(
+	bytecode_t code /*!< [in,out] compiled expression.                       */
+);
+
+/*!
+ * @brief Evaluate compiled expression at given point.
+ *
+ * @note Stack of the machine is a part of compiled expression, so the same
+ * compiled expression can't be evaluated by several threads at once.
+ *
+ * @return Value of expression.
+ */
+double bytecode_evaluate
+(
+	bytecode_t code, /*!< [in,out] compiled expression.                      */
+	double     x     /*!< [in]     value of variable x.                      */
+);
+
+/*!
+ * @brief Evaluate compiled expression at many points.
+ *
+ * @note Points are processed in blocks by SIMD instructions. It doesn't use
+ * the stack of compiled expression, so it can be called by several threads.
+ *
+ * @return Success of evaluation.
+ */
+bool bytecode_evaluate_batch
+(
+	const bytecode_t code,   /*!< [in]  compiled expression.                 */
+	const double*    x,      /*!< [in]  values of variable x.                */
+	double*          values, /*!< [out] values of expression.                */
+	size_t           amount  /*!< [in]  amount of points.                    */
+);
+
+
+
+
+#endif // not defined BYTECODE_H_
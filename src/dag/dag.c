@@ -0,0 +1,443 @@
+/*!
+ * @file
+ * @brief Hash-consed expression store implementation.
+ */
+
+#include "dag.h"
+#include "../utilities/utilities.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+
+
+
+/*!
+ * @brief Node of the expression store.
+ */
+struct dag_node
+{
+	token_t value;    /*!< value of node.                                    */
+	dag_t   left;     /*!< left child.                                       */
+	dag_t   right;    /*!< right child.                                      */
+	size_t  hash;     /*!< structural hash.                                  */
+	bool    constant; /*!< true if expression doesn't contain variable x.    */
+};
+
+/*!
+ * @brief Expression store.
+ */
+struct dag_store
+{
+	struct dag_node* nodes;     /*!< array of nodes. Node 0 isn't used.      */
+	size_t           size;      /*!< amount of used nodes including node 0.  */
+	size_t           capacity;  /*!< capacity of the nodes array.            */
+	dag_t*           table;     /*!< hash table of nodes.                    */
+	size_t           table_cap; /*!< capacity of hash table (power of 2).    */
+};
+
+/*!
+ * @brief Initial capacity of the store.
+ */
+static const size_t DAG_INIT_CAP = 1024;
+
+
+
+
+/*!
+ * @brief Calculate structural hash of node.
+ *
+ * @return Hash value.
+ */
+static size_t dag_node_hash
+(
+	const token_t* value, /*!< [in] value of node.                           */
+	dag_t          left,  /*!< [in] left child.                              */
+	dag_t          right  /*!< [in] right child.                             */
+)
+{
+	// Children are interned so their ids identify them.
+	size_t hash = token_hash(value);
+	hash = hash_combine(hash, (size_t) left);
+	return hash_combine(hash, (size_t) right);
+}
+
+/*!
+ * @brief Increase capacity of hash table twice and rehash all nodes.
+ *
+ * @return Success of growing.
+ */
+static bool dag_table_grow
+(
+	dag_store_t store /*!< [in,out] expression store.                        */
+)
+{
+	size_t capacity = store->table_cap * 2;
+	dag_t* table    = (dag_t*) calloc(capacity, sizeof *table);
+	if (!table)
+		return false;
+
+	for (size_t i = 1; i < store->size; ++i)
+	{
+		size_t index = store->nodes[i].hash & (capacity - 1);
+		while (table[index] != DAG_NONE)
+			index = (index + 1) & (capacity - 1);
+
+		table[index] = (dag_t) i;
+	}
+
+	free(store->table);
+	store->table     = table;
+	store->table_cap = capacity;
+	return true;
+}
+
+/*!
+ * @brief Append node to the store.
+ *
+ * @return New node or DAG_NONE if an error occurred.
+ */
+static dag_t dag_append
+(
+	dag_store_t    store, /*!< [in,out] expression store.                    */
+	const token_t* value, /*!< [in]     value of node.                       */
+	dag_t          left,  /*!< [in]     left child.                          */
+	dag_t          right, /*!< [in]     right child.                         */
+	size_t         hash   /*!< [in]     hash of node.                        */
+)
+{
+	if (store->size == store->capacity)
+	{
+		if (store->capacity >= UINT32_MAX)
+			return DAG_NONE;
+
+		size_t capacity = store->capacity * 2;
+		void*  check    = realloc(store->nodes, capacity * sizeof *store->nodes);
+		if (!check)
+			return DAG_NONE;
+
+		store->nodes    = (struct dag_node*) check;
+		store->capacity = capacity;
+	}
+
+	struct dag_node* node = &store->nodes[store->size];
+	node->value    = *value;
+	node->left     = left;
+	node->right    = right;
+	node->hash     = hash;
+	node->constant = (value->type != TOKEN_VAR
+	                  || value->value.ident != SYMBOL_X)
+	                 && (left  == DAG_NONE || store->nodes[left].constant)
+	                 && (right == DAG_NONE || store->nodes[right].constant);
+
+	return (dag_t) store->size++;
+}
+
+/*!
+ * @brief Push node to the growable stack.
+ *
+ * @return Success of pushing.
+ */
+static bool dag_stack_push
+(
+	dag_t**  stack, /*!< [in,out] stack.                                     */
+	size_t*  size,  /*!< [in,out] amount of elements in the stack.           */
+	size_t*  cap,   /*!< [in,out] capacity of the stack.                     */
+	dag_t    node   /*!< [in]     pushed node.                               */
+)
+{
+	if (*size == *cap)
+	{
+		size_t capacity = (*cap) ? *cap * 2 : 64;
+		void*  check    = realloc(*stack, capacity * sizeof **stack);
+		if (!check)
+			return false;
+
+		*stack = (dag_t*) check;
+		*cap   = capacity;
+	}
+
+	(*stack)[(*size)++] = node;
+	return true;
+}
+
+
+
+
+dag_store_t dag_store_create (void)
+{
+	dag_store_t store = (dag_store_t) calloc(1, sizeof *store);
+	if (!store)
+		return NULL;
+
+	store->nodes     = (struct dag_node*) calloc(DAG_INIT_CAP,
+	                                             sizeof *store->nodes);
+	store->table     = (dag_t*) calloc(DAG_INIT_CAP * 2, sizeof *store->table);
+	store->capacity  = DAG_INIT_CAP;
+	store->table_cap = DAG_INIT_CAP * 2;
+	store->size      = 1;
+	if (!store->nodes || !store->table)
+		return dag_store_destroy(store);
+
+	return store;
+}
+
+
+dag_store_t dag_store_destroy (dag_store_t store)
+{
+	if (!store)
+		return NULL;
+
+	free(store->nodes);
+	free(store->table);
+	free(store);
+	return NULL;
+}
+
+
+size_t dag_store_size (const dag_store_t store)
+{
+	assert (store);
+
+	return store->size - 1;
+}
+
+
+dag_t dag_intern (dag_store_t store, const token_t* value,
+                  dag_t left, dag_t right)
+{
+	assert (store);
+	assert (value);
+	assert (left  < store->size);
+	assert (right < store->size);
+
+	if (value->type == TOKEN_UNKNOWN)
+		return DAG_NONE;
+
+	size_t hash  = dag_node_hash(value, left, right);
+	size_t mask  = store->table_cap - 1;
+	size_t index = hash & mask;
+	dag_t  found = DAG_NONE;
+	while ((found = store->table[index]) != DAG_NONE)
+	{
+		const struct dag_node* node = &store->nodes[found];
+		if (node->hash == hash && node->left == left && node->right == right
+		    && token_equal(&node->value, value))
+			return found;
+
+		index = (index + 1) & mask;
+	}
+
+	// Table grows before the node is appended, so every node
+	// of the store can be found.
+	if ((store->size + 1) * 2 > store->table_cap)
+	{
+		if (!dag_table_grow(store))
+			return DAG_NONE;
+
+		index = hash & (store->table_cap - 1);
+		while (store->table[index] != DAG_NONE)
+			index = (index + 1) & (store->table_cap - 1);
+	}
+
+	dag_t node = dag_append(store, value, left, right, hash);
+	if (node != DAG_NONE)
+		store->table[index] = node;
+
+	return node;
+}
+
+
+dag_t dag_number (dag_store_t store, double num)
+{
+	token_t t = {.type = TOKEN_NUMBER, .value.number = num};
+	return dag_intern(store, &t, DAG_NONE, DAG_NONE);
+}
+
+
+dag_t dag_binop (dag_store_t store, operation_t op, dag_t lhs, dag_t rhs)
+{
+	if (lhs == DAG_NONE || rhs == DAG_NONE)
+		return DAG_NONE;
+
+	token_t t = {.type = TOKEN_OP, .value.operation = op};
+	return dag_intern(store, &t, lhs, rhs);
+}
+
+
+dag_t dag_prefunop (dag_store_t store, operation_t op, dag_t operand)
+{
+	if (operand == DAG_NONE)
+		return DAG_NONE;
+
+	token_t t = {.type = TOKEN_OP, .value.operation = op};
+	return dag_intern(store, &t, operand, DAG_NONE);
+}
+
+
+dag_t dag_postunop (dag_store_t store, operation_t op, dag_t operand)
+{
+	if (operand == DAG_NONE)
+		return DAG_NONE;
+
+	token_t t = {.type = TOKEN_OP, .value.operation = op};
+	return dag_intern(store, &t, DAG_NONE, operand);
+}
+
+
+dag_t dag_func (dag_store_t store, symbol_t name, dag_t arg)
+{
+	if (arg == DAG_NONE)
+		return DAG_NONE;
+
+	token_t t = {.type = TOKEN_FUNC, .func = token_function_id(name),
+	             .value.ident = name};
+	return dag_intern(store, &t, DAG_NONE, arg);
+}
+
+
+const token_t* dag_value (const dag_store_t store, dag_t node)
+{
+	assert (store);
+	assert (node != DAG_NONE && node < store->size);
+
+	return &store->nodes[node].value;
+}
+
+
+dag_t dag_left (const dag_store_t store, dag_t node)
+{
+	assert (store);
+	assert (node != DAG_NONE && node < store->size);
+
+	return store->nodes[node].left;
+}
+
+
+dag_t dag_right (const dag_store_t store, dag_t node)
+{
+	assert (store);
+	assert (node != DAG_NONE && node < store->size);
+
+	return store->nodes[node].right;
+}
+
+
+bool dag_is_constant (const dag_store_t store, dag_t node)
+{
+	assert (store);
+	assert (node != DAG_NONE && node < store->size);
+
+	return store->nodes[node].constant;
+}
+
+
+dag_t dag_from_bintree (dag_store_t store, const bintree_t tree)
+{
+	assert (store);
+	assert (tree);
+
+	dag_t* stack = NULL;
+	size_t size  = 0;
+	size_t cap   = 0;
+	dag_t  ret   = DAG_NONE;
+
+	// Post-order traversal using parent pointers.
+	bintree_t node = bintree_postorder_first(tree);
+
+	while (true)
+	{
+		dag_t right = (BINTREE_NODE_RIGHT(node)) ? stack[--size] : DAG_NONE;
+		dag_t left  = (BINTREE_NODE_LEFT(node))  ? stack[--size] : DAG_NONE;
+		dag_t id    = dag_intern(store, &BINTREE_NODE_VALUE(node), left, right);
+		if (id == DAG_NONE || !dag_stack_push(&stack, &size, &cap, id))
+			break;
+
+		if (node == tree)
+		{
+			ret = id;
+			break;
+		}
+
+		node = bintree_postorder_next(tree, node);
+	}
+
+	free(stack);
+	return ret;
+}
+
+
+bintree_t dag_to_bintree (const dag_store_t store, dag_t root)
+{
+	assert (store);
+	assert (root != DAG_NONE && root < store->size);
+
+	// Nodes are created in pre-order: stack keeps pairs of expression node
+	// and tree node whose children should be created.
+	dag_t* stack = NULL;
+	size_t size  = 0;
+	size_t cap   = 0;
+
+	bintree_t tree = bintree_create(store->nodes[root].value);
+	if (!tree)
+		return BINTREE_NULL;
+
+	bintree_t node = tree;
+	dag_t     id   = root;
+	while (true)
+	{
+		const struct dag_node* dag_node = &store->nodes[id];
+		if (dag_node->right != DAG_NONE)
+		{
+			bintree_t right = bintree_create(store->nodes[dag_node->right].value);
+			if (!right || !dag_stack_push(&stack, &size, &cap, dag_node->right))
+			{
+				bintree_destroy(right);
+				break;
+			}
+
+			bintree_hook_right(node, right);
+		}
+
+		if (dag_node->left != DAG_NONE)
+		{
+			bintree_t left = bintree_create(store->nodes[dag_node->left].value);
+			if (!left)
+				break;
+
+			bintree_hook_left(node, left);
+			node = left;
+			id   = dag_node->left;
+			continue;
+		}
+
+		if (dag_node->right != DAG_NONE)
+		{
+			node = BINTREE_NODE_RIGHT(node);
+			id   = stack[--size];
+			continue;
+		}
+
+		// Go to the nearest ancestor which has unprocessed right child.
+		while (node != tree)
+		{
+			bintree_t parent = BINTREE_NODE_PARENT(node);
+			if (BINTREE_NODE_RIGHT(parent) && BINTREE_NODE_RIGHT(parent) != node)
+				break;
+
+			node = parent;
+		}
+
+		if (node == tree)
+		{
+			free(stack);
+			return tree;
+		}
+
+		node = BINTREE_NODE_RIGHT(BINTREE_NODE_PARENT(node));
+		id   = stack[--size];
+	}
+
+	free(stack);
+	return bintree_destroy(tree);
+}
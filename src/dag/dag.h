@@ -0,0 +1,214 @@
+/*!
+ * @file
+ * @brief Header of hash-consed expression store.
+ *
+ * Every expression in the store is kept only once: identical subtrees are
+ * the same immutable node, so expressions form a directed acyclic graph.
+ * All nodes live as long as the store does.
+ */
+
+#ifndef DAG_H_
+#define DAG_H_
+
+#include "../tree/bintree.h"
+
+#include <stdint.h>
+
+
+
+/*!
+ * @brief Identifier of node in expression store.
+ */
+typedef uint32_t dag_t;
+
+/*!
+ * @brief Identifier which doesn't refer to any node.
+ */
+#define DAG_NONE ((dag_t) 0)
+
+/*!
+ * @brief Store of hash-consed expressions.
+ */
+typedef struct dag_store* dag_store_t;
+
+
+
+/*!
+ * @brief Create new expression store.
+ *
+ * @note Don't forget to free memory using dag_store_destroy() function.
+ *
+ * @return Created store. If error occurred it returns NULL.
+ */
+dag_store_t dag_store_create (void);
+
+/*!
+ * @brief Destroy expression store and all its nodes.
+ *
+ * @return NULL.
+ */
+dag_store_t dag_store_destroy
+(
+	dag_store_t store /*!< [in,out] expression store.                        */
+);
+
+/*!
+ * @brief Get amount of nodes in the store.
+ *
+ * @return Amount of nodes.
+ */
+size_t dag_store_size
+(
+	const dag_store_t store /*!< [in] expression store.                      */
+);
+
+/*!
+ * @brief Find node with given value and children or add it to the store.
+ *
+ * @return Node or DAG_NONE if an error occurred or one of given children
+ * is DAG_NONE where child is required.
+ */
+dag_t dag_intern
+(
+	dag_store_t    store, /*!< [in,out] expression store.                    */
+	const token_t* value, /*!< [in]     value of node.                       */
+	dag_t          left,  /*!< [in]     left child or DAG_NONE.              */
+	dag_t          right  /*!< [in]     right child or DAG_NONE.             */
+);
+
+/*!
+ * @brief Get node of number.
+ *
+ * @return Node or DAG_NONE if an error occurred.
+ */
+dag_t dag_number
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	double      num    /*!< [in]     number.                                 */
+);
+
+/*!
+ * @brief Get node of binary operation.
+ *
+ * @return Node or DAG_NONE if an error occurred.
+ */
+dag_t dag_binop
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	operation_t op,    /*!< [in]     operation.                              */
+	dag_t       lhs,   /*!< [in]     left operand.                           */
+	dag_t       rhs    /*!< [in]     right operand.                          */
+);
+
+/*!
+ * @brief Get node of prefix unary operation.
+ *
+ * @return Node or DAG_NONE if an error occurred.
+ */
+dag_t dag_prefunop
+(
+	dag_store_t store,  /*!< [in,out] expression store.                      */
+	operation_t op,     /*!< [in]     operation.                             */
+	dag_t       operand /*!< [in]     an operand.                            */
+);
+
+/*!
+ * @brief Get node of postfix unary operation.
+ *
+ * @return Node or DAG_NONE if an error occurred.
+ */
+dag_t dag_postunop
+(
+	dag_store_t store,  /*!< [in,out] expression store.                      */
+	operation_t op,     /*!< [in]     operation.                             */
+	dag_t       operand /*!< [in]     an operand.                            */
+);
+
+/*!
+ * @brief Get node of function.
+ *
+ * @return Node or DAG_NONE if an error occurred.
+ */
+dag_t dag_func
+(
+	dag_store_t store, /*!< [in,out] expression store.                       */
+	symbol_t    name,  /*!< [in]     function name.                          */
+	dag_t       arg    /*!< [in]     function's argument.                    */
+);
+
+/*!
+ * @brief Get value of node.
+ *
+ * @note Pointer is valid until the next node is added to the store.
+ *
+ * @return Value of node.
+ */
+const token_t* dag_value
+(
+	const dag_store_t store, /*!< [in] expression store.                     */
+	dag_t             node   /*!< [in] node.                                 */
+);
+
+/*!
+ * @brief Get left child of node.
+ *
+ * @return Left child or DAG_NONE.
+ */
+dag_t dag_left
+(
+	const dag_store_t store, /*!< [in] expression store.                     */
+	dag_t             node   /*!< [in] node.                                 */
+);
+
+/*!
+ * @brief Get right child of node.
+ *
+ * @return Right child or DAG_NONE.
+ */
+dag_t dag_right
+(
+	const dag_store_t store, /*!< [in] expression store.                     */
+	dag_t             node   /*!< [in] node.                                 */
+);
+
+/*!
+ * @brief Check expression to absence of variable x.
+ *
+ * @return Result of checking.
+ */
+bool dag_is_constant
+(
+	const dag_store_t store, /*!< [in] expression store.                     */
+	dag_t             node   /*!< [in] node.                                 */
+);
+
+/*!
+ * @brief Add binary tree to the store.
+ *
+ * @return Node of the tree root or DAG_NONE if an error occurred.
+ */
+dag_t dag_from_bintree
+(
+	dag_store_t     store, /*!< [in,out] expression store.                   */
+	const bintree_t tree   /*!< [in]     binary tree.                        */
+);
+
+/*!
+ * @brief Build binary tree from expression in the store.
+ *
+ * @note Shared nodes are copied, so tree can be much bigger than the store.
+ *
+ * @note Don't forget to free memory using bintree_destroy() function.
+ *
+ * @return Binary tree or NULL if an error occurred.
+ */
+bintree_t dag_to_bintree
+(
+	const dag_store_t store, /*!< [in] expression store.                     */
+	dag_t             node   /*!< [in] root of expression.                   */
+);
+
+
+
+
+#endif // not defined DAG_H_
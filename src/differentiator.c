@@ -4,6 +4,7 @@
  */
 
 #include "differentiator.h"
+#include "builtins/builtins.h"
 #include "dsl/dsl.h"
 #include "parser/token.h"
 #include "tree/bintree.h"
@@ -13,16 +14,39 @@
 #include "utilities/utilities.h"
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 
 
 
-static bintree_t differentiate_node   (const bintree_t expression, FILE* tex);
-static bintree_t differentiate_number (const bintree_t expression, FILE* tex);
-static bintree_t differentiate_var    (const bintree_t expression, FILE* tex);
-static bintree_t differentiate_func   (const bintree_t expression, FILE* tex);
-static bintree_t differentiate_op     (const bintree_t expression, FILE* tex);
+/*!
+ * @brief Node of the expression whose derivative is being found.
+ */
+struct diff_frame
+{
+	bintree_t node;     /*!< differentiated node.                            */
+	bintree_t deps[2];  /*!< children whose derivatives are needed.          */
+	bintree_t deriv[2]; /*!< found derivatives of the children.              */
+	size_t    amount;   /*!< amount of needed children.                      */
+	size_t    visited;  /*!< amount of children which were started.          */
+};
+
+/*!
+ * @brief Stack of nodes whose derivatives are being found.
+ */
+struct diff_stack
+{
+	struct diff_frame* frames;   /*!< frames of the stack.                   */
+	size_t             size;     /*!< amount of frames.                      */
+	size_t             capacity; /*!< capacity of the stack.                 */
+};
+
+/*!
+ * @brief Initial capacity of the differentiation stack.
+ */
+static const size_t DIFF_STACK_INIT_CAPACITY = 64;
+
 
 
 
@@ -35,15 +59,20 @@ static void print_step
 	const bintree_t     deriv,      /*!< [in]     derivate of
 	                                              given expression.          */
 	const bintree_t     expression, /*!< [in]     given expression.          */
-	FILE*               output      /*!< [in,out] tex file stream.           */
+	tex_t               tex         /*!< [in,out] article or NULL
+	                                              if step isn't written.     */
 )
 {
+	if (!tex)
+		return;
+
+	sink_t output = tex_sink(tex);
 	print_context(context, output);
-	fputs("\n\\begin{dmath*}\n(", output);
-	print_expression(expression, output);
-	fputs(")' = ", output);
-	print_expression(deriv, output);
-	fputs(".\n\\end{dmath*}\n", output);
+	sink_puts(output, "\n\\begin{dmath*}\n(");
+	print_labelled_expression(tex, expression);
+	sink_puts(output, ")' = ");
+	print_labelled_expression(tex, deriv);
+	sink_puts(output, ".\n\\end{dmath*}\n");
 }
 
 /*!
@@ -54,14 +83,14 @@ static void print_step
 static bintree_t differentiate_number
 (
 	const bintree_t expression, /*!< [in,out] given expression.              */
-	FILE*           output      /*!< [in,out] tex file stream.               */
+	tex_t           tex         /*!< [in,out] article.                       */
 )
 {
 	bintree_t root = create_number(0);
 	if (!root)
 		fputs("Cannot allocate memory for number node.\n\n", stderr);
 	else
-		print_step(CONTEXT_DIFF_NUMBER, root, expression, output);
+		print_step(CONTEXT_DIFF_NUMBER, root, expression, tex);
 
 	return root;
 }
@@ -74,14 +103,14 @@ static bintree_t differentiate_number
 static bintree_t differentiate_var
 (
 	const bintree_t expression, /*!< [in,out] given expression.              */
-	FILE*           output      /*!< [in,out] tex file stream.               */
+	tex_t           tex         /*!< [in,out] article.                       */
 )
 {
-	bintree_t root = create_number((strcmp(D_IDENT, "x")) ? 0 : 1);
+	bintree_t root = create_number((D_IDENT == SYMBOL_X) ? 1 : 0);
 	if (!root)
 		fputs("Cannot allocate memory for ident node.\n\n", stderr);
 	else
-		print_step(CONTEXT_DIFF_VAR, root, expression, output);
+		print_step(CONTEXT_DIFF_VAR, root, expression, tex);
 
 	return root;
 }
@@ -94,43 +123,24 @@ static bintree_t differentiate_var
 static bintree_t differentiate_func
 (
 	const bintree_t expression, /*!< [in,out] given expression.              */
-	FILE*           output      /*!< [in,out] tex file stream.               */
+	bintree_t       d_arg,      /*!< [in,out] derivative of argument.        */
+	tex_t           tex         /*!< [in,out] article.                       */
 )
 {
-	bintree_t root = NULL;
+	bintree_t root = BINTREE_NULL;
 	bintree_t arg  = bintree_copy(D_ARG);
 	if (!arg)
 	{
+		bintree_destroy(d_arg);
 		fputs("Cannot create copy of function argument.\n\n", stderr);
-		return NULL;
+		return BINTREE_NULL;
 	}
 
-	token_t t = {.type = TOKEN_FUNC, .value.ident = NULL};
-	if (strcmp(D_IDENT, "sin") == 0)
+	token_t               t;
+	const builtin_rule_t* rule = builtin_rule(D_FUNC);
+	if (rule)
 	{
-		D_NEW_FUNC(root, "cos", arg);
-	}
-	else if (strcmp(D_IDENT, "cos") == 0)
-	{
-		D_NEW_FUNC(root, "sin", arg);
-		D_NEW_PREFUNOP(root, OP_MINUS, root);
-	}
-	else if (strcmp(D_IDENT, "tg") == 0)
-	{
-		D_NEW_FUNC(root, "cos", arg);
-		D_NEW_OP(root, OP_POW, root, create_number(2));
-		D_NEW_OP(root, OP_DIV, create_number(1), root);
-	}
-	else if (strcmp(D_IDENT, "ctg") == 0)
-	{
-		D_NEW_FUNC(root, "sin", arg);
-		D_NEW_OP(root, OP_POW, root, create_number(2));
-		D_NEW_PREFUNOP(root, OP_MINUS, root);
-		D_NEW_OP(root, OP_DIV, create_number(1), root);
-	}
-	else if (strcmp(D_IDENT, "ln") == 0)
-	{
-		D_NEW_OP(root, OP_DIV, create_number(1), arg);
+		root = rule->derivative(arg);
 	}
 	else
 	{
@@ -140,15 +150,16 @@ static bintree_t differentiate_func
 
 	if (!root)
 	{
+		bintree_destroy(d_arg);
 		fputs("Cannot create node.\n\n", stderr);
-		return NULL;
+		return BINTREE_NULL;
 	}
 
-	D_NEW_OP(root, OP_MUL, root, differentiate_node(D_ARG, output));
+	D_NEW_OP(root, OP_MUL, root, d_arg);
 	if (!root)
 		fputs("Cannot allocate memory for function node.\n\n", stderr);
 	else
-		print_step(CONTEXT_DIFF_FUNC, root, expression, output);
+		print_step(CONTEXT_DIFF_FUNC, root, expression, tex);
 
 	return root;
 }
@@ -161,55 +172,49 @@ static bintree_t differentiate_func
 static bintree_t differentiate_op
 (
 	const bintree_t expression, /*!< [in,out] given expression.              */
-	FILE*           output      /*!< [in,out] tex file stream.               */
+	bintree_t       d_lhs,      /*!< [in,out] derivative of the left operand
+	                                          or NULL if it isn't needed.    */
+	bintree_t       d_rhs,      /*!< [in,out] derivative of the right operand
+	                                          or NULL if it isn't needed.    */
+	tex_t           tex         /*!< [in,out] article.                       */
 )
 {
-	bintree_t root = NULL;
-	bintree_t tmp1 = NULL;
-	bintree_t tmp2 = NULL;
+	bintree_t root = BINTREE_NULL;
+	bintree_t tmp1 = BINTREE_NULL;
+	bintree_t tmp2 = BINTREE_NULL;
 	token_t t;
 	if (D_ISPREFUNARY)
 	{
-		D_NEW_PREFUNOP(root, D_OP, differentiate_node(D_PREFARG, output));
+		D_NEW_PREFUNOP(root, D_OP, d_lhs);
 	}
 	else if (D_ISPOSTUNARY)
 	{
-		// There are no another postfix operations except OP_DERIV
-		bintree_t arg = D_POSTARG;
-		while (arg && arg->value.type == TOKEN_OP
-		       && arg->value.value.operation == OP_DERIV)
-			arg = arg->right;
-
-		if (!arg)
-		{
-			fputs("Function hasn't arguments.\n\n", stderr);
-			return NULL;
-		}
-
-		if (arg->value.type == TOKEN_FUNC && arg->right)
-		{
-			arg = arg->right;
-		}
-		else
+		// Derivative of the function argument is found before.
+		if (!d_rhs)
 		{
 			fputs("Tree has wrong format.\n\n", stderr);
-			return NULL;
+			return BINTREE_NULL;
 		}
-		
+
 		D_NEW_POSTUNOP(root, OP_DERIV, bintree_copy(D_POSTARG));
 		D_NEW_POSTUNOP(root, OP_DERIV, root);
-		D_NEW_OP(root, OP_MUL, root, differentiate_node(arg, output));
+		D_NEW_OP(root, OP_MUL, root, d_rhs);
 	}
 	else
 	{
-		bintree_t arg1 = bintree_copy(D_LHS);
-		bintree_t arg2 = bintree_copy(D_RHS);
-		if (!arg1 || !arg2)
+		// Operands are copied only by rules which use them,
+		// so sums of long chains aren't copied at every level.
+		bool      copy = D_OP == OP_MUL || D_OP == OP_DIV || D_OP == OP_POW;
+		bintree_t arg1 = (copy) ? bintree_copy(D_LHS) : BINTREE_NULL;
+		bintree_t arg2 = (copy) ? bintree_copy(D_RHS) : BINTREE_NULL;
+		if (copy && (!arg1 || !arg2))
 		{
 			bintree_destroy(arg1);
 			bintree_destroy(arg2);
+			bintree_destroy(d_lhs);
+			bintree_destroy(d_rhs);
 			fputs("Cannot copy operation arguments.\n\n", stderr);
-			return NULL;
+			return BINTREE_NULL;
 		}
 
 		switch (D_OP)
@@ -221,28 +226,22 @@ static bintree_t differentiate_op
 				break;
 
 			case OP_PLUS:
-				bintree_destroy(arg1);
-				bintree_destroy(arg2);
-				D_NEW_OP(root, OP_PLUS, differentiate_node(D_LHS, output),
-				         differentiate_node(D_RHS, output));
+				D_NEW_OP(root, OP_PLUS, d_lhs, d_rhs);
 				break;
 
 			case OP_MINUS:
-				bintree_destroy(arg1);
-				bintree_destroy(arg2);
-				D_NEW_OP(root, OP_MINUS, differentiate_node(D_LHS, output),
-				         differentiate_node(D_RHS, output));
+				D_NEW_OP(root, OP_MINUS, d_lhs, d_rhs);
 				break;
 
 			case OP_MUL:
-				D_NEW_OP(tmp1, OP_MUL, arg1, differentiate_node(D_RHS, output));
-				D_NEW_OP(tmp2, OP_MUL, differentiate_node(D_LHS, output), arg2);
+				D_NEW_OP(tmp1, OP_MUL, arg1, d_rhs);
+				D_NEW_OP(tmp2, OP_MUL, d_lhs, arg2);
 				D_NEW_OP(root, OP_PLUS, tmp1, tmp2);
 				break;
 
 			case OP_DIV:
-				D_NEW_OP(tmp1, OP_MUL, differentiate_node(D_LHS, output), arg2);
-				D_NEW_OP(tmp2, OP_MUL, arg1, differentiate_node(D_RHS, output));
+				D_NEW_OP(tmp1, OP_MUL, d_lhs, arg2);
+				D_NEW_OP(tmp2, OP_MUL, arg1, d_rhs);
 				D_NEW_OP(tmp1, OP_MINUS, tmp1, tmp2);
 				arg2 = bintree_copy(D_RHS);
 				D_NEW_OP(tmp2, OP_POW, arg2, create_number(2));
@@ -257,41 +256,45 @@ static bintree_t differentiate_op
 					{
 						bintree_destroy(arg1);
 						bintree_destroy(arg2);
+						bintree_destroy(d_lhs);
 						fputs("Cannot optimize subtree.\n\n", stderr);
-						return NULL;
+						return BINTREE_NULL;
 					}
 
-					if (root->value.type == TOKEN_NUMBER
-					    && double_equal(root->value.value.number, 0))
+					token_t value = BINTREE_NODE_VALUE(root);
+					if (value.type == TOKEN_NUMBER
+					    && double_equal(value.value.number, 0))
 					{
 						bintree_destroy(arg1);
 						bintree_destroy(root);
+						bintree_destroy(d_lhs);
 						root = create_number(0);
 						break;
 					}
 
-					D_NEW_OP(arg2, OP_MINUS, root, create_number(1));
+					tmp1 = root;
+					D_NEW_OP(arg2, OP_MINUS, bintree_copy(tmp1), create_number(1));
 					D_NEW_OP(root, OP_POW, arg1, arg2);
-					D_NEW_OP(root, OP_MUL, bintree_copy(arg2), root);
-					D_NEW_OP(root, OP_MUL, root, differentiate_node(D_LHS, output));
+					D_NEW_OP(root, OP_MUL, tmp1, root);
+					D_NEW_OP(root, OP_MUL, root, d_lhs);
 					break;
 				}
 
+				// Power node can be folded to a number freeing its operands,
+				// so the base is checked in the given expression.
 				D_NEW_OP(root, D_OP, arg1, arg2);
-				if (tree_is_constant(arg1))
+				if (tree_is_constant(D_LHS))
 				{
-					D_NEW_FUNC(tmp1, "ln", bintree_copy(D_LHS));
+					D_NEW_FUNC(tmp1, SYMBOL_LN, bintree_copy(D_LHS));
 					D_NEW_OP(root, OP_MUL, root, tmp1);
-					D_NEW_OP(root, OP_MUL, root,
-					         differentiate_node(D_RHS, output));
+					D_NEW_OP(root, OP_MUL, root, d_rhs);
 					break;
 				}
 
-				D_NEW_OP(tmp1, OP_MUL, differentiate_node(D_LHS, output),
-				         bintree_copy(D_RHS));
+				D_NEW_OP(tmp1, OP_MUL, d_lhs, bintree_copy(D_RHS));
 				D_NEW_OP(tmp1, OP_DIV, tmp1, bintree_copy(D_LHS));
-				D_NEW_FUNC(tmp2, "ln", bintree_copy(D_LHS));
-				D_NEW_OP(tmp2, OP_MUL, differentiate_node(D_RHS, output), tmp2);
+				D_NEW_FUNC(tmp2, SYMBOL_LN, bintree_copy(D_LHS));
+				D_NEW_OP(tmp2, OP_MUL, d_rhs, tmp2);
 				D_NEW_OP(tmp1, OP_PLUS, tmp1, tmp2);
 				D_NEW_OP(root, OP_MUL, root, tmp1);
 				break;
@@ -301,20 +304,24 @@ static bintree_t differentiate_op
 	if (!root)
 		fputs("Cannot allocate memory for operation node.\n\n", stderr);
 	else
-		print_step(CONTEXT_DIFF_OP, root, expression, output);
+		print_step(CONTEXT_DIFF_OP, root, expression, tex);
 
 	return root;
 }
 
 /*!
- * @brief Differentiate node.
+ * @brief Differentiate node using derivatives of its children.
  *
  * @return Derivative of given node.
  */
 static bintree_t differentiate_node
 (
-	const bintree_t expression, /*!< [in] node of the expression tree.       */
-	FILE*           tex         /*!< [in] tex file stream.                   */
+	const bintree_t expression, /*!< [in]     node of the expression tree.   */
+	bintree_t       d_lhs,      /*!< [in,out] derivative of the left child
+	                                          or NULL if it isn't needed.    */
+	bintree_t       d_rhs,      /*!< [in,out] derivative of the right child
+	                                          or NULL if it isn't needed.    */
+	tex_t           tex         /*!< [in,out] article.                       */
 )
 {
 	if (D_TYPE == TOKEN_NUMBER)
@@ -324,40 +331,507 @@ static bintree_t differentiate_node
 		return differentiate_var(expression, tex);
 
 	if (D_TYPE == TOKEN_FUNC)
-		return differentiate_func(expression, tex);
+		return differentiate_func(expression, d_rhs, tex);
 
 	if (D_TYPE == TOKEN_OP)
-		return differentiate_op(expression, tex);
+		return differentiate_op(expression, d_lhs, d_rhs, tex);
 
 	fputs("Token has unknown type.\n\n", stderr);
-	return NULL;
+	return BINTREE_NULL;
+}
+
+/*!
+ * @brief Find subexpressions whose derivatives are needed
+ * to differentiate node in order of their differentiation.
+ *
+ * @return Amount of found subexpressions.
+ */
+static size_t deriv_deps
+(
+	const bintree_t expression, /*!< [in]  differentiated node.              */
+	bintree_t       deps[2]     /*!< [out] needed subexpressions.            */
+)
+{
+	if (D_TYPE == TOKEN_FUNC)
+	{
+		deps[0] = D_ARG;
+		return 1;
+	}
+
+	if (D_TYPE != TOKEN_OP)
+		return 0;
+
+	if (D_ISPREFUNARY)
+	{
+		deps[0] = D_PREFARG;
+		return 1;
+	}
+
+	if (D_ISPOSTUNARY)
+	{
+		// There are no another postfix operations except OP_DERIV
+		bintree_t arg = D_POSTARG;
+		while (arg && BINTREE_NODE_VALUE(arg).type == TOKEN_OP
+		       && BINTREE_NODE_VALUE(arg).value.operation == OP_DERIV)
+			arg = BINTREE_NODE_RIGHT(arg);
+
+		if (!arg || BINTREE_NODE_VALUE(arg).type != TOKEN_FUNC
+		    || !BINTREE_NODE_RIGHT(arg))
+			return 0;
+
+		deps[0] = BINTREE_NODE_RIGHT(arg);
+		return 1;
+	}
+
+	switch (D_OP)
+	{
+		case OP_DIV:
+			deps[0] = D_LHS;
+			deps[1] = D_RHS;
+			return 2;
+
+		case OP_PLUS:
+		case OP_MINUS:
+		case OP_MUL:
+			deps[0] = D_RHS;
+			deps[1] = D_LHS;
+			return 2;
+
+		case OP_POW:
+			if (tree_is_constant(D_RHS))
+			{
+				deps[0] = D_LHS;
+				return 1;
+			}
+
+			if (tree_is_constant(D_LHS))
+			{
+				deps[0] = D_RHS;
+				return 1;
+			}
+
+			deps[0] = D_LHS;
+			deps[1] = D_RHS;
+			return 2;
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			return 0;
+	}
+}
+
+/*!
+ * @brief Push node to the differentiation stack.
+ *
+ * @return Success of pushing.
+ */
+static bool diff_stack_push
+(
+	struct diff_stack* stack,     /*!< [in,out] differentiation stack.       */
+	const bintree_t    expression /*!< [in]     differentiated node.         */
+)
+{
+	if (stack->size == stack->capacity)
+	{
+		size_t capacity = (stack->capacity) ? 2 * stack->capacity
+		                                    : DIFF_STACK_INIT_CAPACITY;
+		void* check = realloc(stack->frames, capacity * sizeof *stack->frames);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for differentiation.\n\n", stderr);
+			return false;
+		}
+
+		stack->frames   = (struct diff_frame*) check;
+		stack->capacity = capacity;
+	}
+
+	struct diff_frame* frame = &stack->frames[stack->size++];
+	frame->node     = expression;
+	frame->deriv[0] = BINTREE_NULL;
+	frame->deriv[1] = BINTREE_NULL;
+	frame->visited  = 0;
+	frame->amount   = deriv_deps(expression, frame->deps);
+	return true;
+}
+
+/*!
+ * @brief Differentiate expression tree in post-order.
+ *
+ * @note Children are differentiated in the same order as they are needed
+ * by differentiation rule, so steps in tex file keep their order.
+ *
+ * @return Derivative or NULL if an error occurred.
+ */
+static bintree_t differentiate_tree
+(
+	const bintree_t    expression, /*!< [in]     input expression.           */
+	struct diff_stack* stack,      /*!< [in,out] differentiation stack.      */
+	tex_t              tex,        /*!< [in,out] article.                    */
+	diff_verbosity_t   verbosity   /*!< [in]     what is written.            */
+)
+{
+	if (!diff_stack_push(stack, expression))
+		return BINTREE_NULL;
+
+	while (true)
+	{
+		struct diff_frame* frame = &stack->frames[stack->size - 1];
+		if (frame->visited < frame->amount)
+		{
+			if (!diff_stack_push(stack, frame->deps[frame->visited++]))
+				return BINTREE_NULL;
+
+			continue;
+		}
+
+		bintree_t d_lhs = BINTREE_NULL;
+		bintree_t d_rhs = BINTREE_NULL;
+		for (size_t i = 0; i < frame->amount; ++i)
+		{
+			if (frame->deps[i] == BINTREE_NODE_LEFT(frame->node))
+				d_lhs = frame->deriv[i];
+			else
+				d_rhs = frame->deriv[i];
+
+			frame->deriv[i] = BINTREE_NULL;
+		}
+
+		bool      step  = verbosity == DIFF_VERBOSITY_FULL
+		                  || (verbosity == DIFF_VERBOSITY_TOP
+		                      && stack->size == 1);
+		bintree_t deriv = differentiate_node(frame->node, d_lhs, d_rhs,
+		                                     (step) ? tex : NULL);
+		if (!deriv)
+			return BINTREE_NULL;
+
+		if (--stack->size == 0)
+			return deriv;
+
+		frame = &stack->frames[stack->size - 1];
+		frame->deriv[frame->visited - 1] = deriv;
+	}
+}
+
+/*!
+ * @brief Find nodes whose derivatives are needed to differentiate
+ * node of the expression store.
+ *
+ * @return Amount of found nodes.
+ */
+static size_t dag_deriv_deps
+(
+	const dag_store_t store, /*!< [in]  expression store.                    */
+	dag_t             node,  /*!< [in]  differentiated node.                 */
+	dag_t             deps[2] /*!< [out] needed nodes.                       */
+)
+{
+	token_t t   = *dag_value(store, node);
+	dag_t   lhs = dag_left(store, node);
+	dag_t   rhs = dag_right(store, node);
+	if (t.type == TOKEN_FUNC)
+	{
+		deps[0] = rhs;
+		return 1;
+	}
+
+	if (t.type != TOKEN_OP)
+		return 0;
+
+	if (lhs != DAG_NONE && rhs == DAG_NONE)
+	{
+		deps[0] = lhs;
+		return 1;
+	}
+
+	if (lhs == DAG_NONE)
+	{
+		// Derivative of function: argument of the function is needed.
+		dag_t arg = rhs;
+		while (dag_value(store, arg)->type == TOKEN_OP)
+			arg = dag_right(store, arg);
+
+		deps[0] = dag_right(store, arg);
+		return (deps[0] != DAG_NONE);
+	}
+
+	if (t.value.operation == OP_POW && dag_is_constant(store, rhs))
+	{
+		deps[0] = lhs;
+		return 1;
+	}
+
+	if (t.value.operation == OP_POW && dag_is_constant(store, lhs))
+	{
+		deps[0] = rhs;
+		return 1;
+	}
+
+	deps[0] = lhs;
+	deps[1] = rhs;
+	return 2;
 }
 
+/*!
+ * @brief Differentiate node of the expression store
+ * using derivatives of its children.
+ *
+ * @return Derivative or DAG_NONE if an error occurred.
+ */
+static dag_t differentiate_dag_node
+(
+	dag_store_t  store, /*!< [in,out] expression store.                      */
+	dag_t        node,  /*!< [in]     differentiated node.                   */
+	const dag_t* deriv  /*!< [in]     found derivatives of nodes.            */
+)
+{
+	token_t t    = *dag_value(store, node);
+	dag_t   lhs  = dag_left(store, node);
+	dag_t   rhs  = dag_right(store, node);
+	dag_t   root = DAG_NONE;
+	switch (t.type)
+	{
+		case TOKEN_NUMBER:
+			return dag_number(store, 0);
+
+		case TOKEN_VAR:
+			return dag_number(store, (t.value.ident == SYMBOL_X) ? 1 : 0);
+
+		case TOKEN_FUNC:
+		{
+			const builtin_rule_t* rule = builtin_rule(t.func);
+			if (rule)
+				root = rule->dag_derivative(store, rhs);
+			else
+				root = dag_postunop(store, OP_DERIV, node);
+
+			return dag_binop(store, OP_MUL, root, deriv[rhs]);
+		}
+
+		case TOKEN_OP:
+			break;
+
+		case TOKEN_UNKNOWN:
+		default:
+			return DAG_NONE;
+	}
+
+	dag_t deps[2] = {DAG_NONE, DAG_NONE};
+	if (lhs != DAG_NONE && rhs == DAG_NONE)
+		return dag_prefunop(store, t.value.operation, deriv[lhs]);
+
+	if (lhs == DAG_NONE)
+	{
+		if (!dag_deriv_deps(store, node, deps))
+			return DAG_NONE;
 
+		return dag_binop(store, OP_MUL, dag_postunop(store, OP_DERIV, node),
+		                 deriv[deps[0]]);
+	}
 
+	switch (t.value.operation)
+	{
+		case OP_PLUS:
+		case OP_MINUS:
+			return dag_binop(store, t.value.operation, deriv[lhs], deriv[rhs]);
+
+		case OP_MUL:
+			return dag_binop(store, OP_PLUS,
+			                 dag_binop(store, OP_MUL, lhs, deriv[rhs]),
+			                 dag_binop(store, OP_MUL, deriv[lhs], rhs));
+
+		case OP_DIV:
+			root = dag_binop(store, OP_MINUS,
+			                 dag_binop(store, OP_MUL, deriv[lhs], rhs),
+			                 dag_binop(store, OP_MUL, lhs, deriv[rhs]));
+			return dag_binop(store, OP_DIV, root,
+			                 dag_binop(store, OP_POW, rhs,
+			                           dag_number(store, 2)));
+
+		case OP_POW:
+			if (dag_is_constant(store, rhs))
+			{
+				const token_t* exp = dag_value(store, rhs);
+				if (exp->type == TOKEN_NUMBER
+				    && double_equal(exp->value.number, 0))
+					return dag_number(store, 0);
+
+				root = dag_binop(store, OP_POW, lhs,
+				                 dag_binop(store, OP_MINUS, rhs,
+				                           dag_number(store, 1)));
+				root = dag_binop(store, OP_MUL, rhs, root);
+				return dag_binop(store, OP_MUL, root, deriv[lhs]);
+			}
+
+			if (dag_is_constant(store, lhs))
+			{
+				root = dag_binop(store, OP_MUL, node,
+				                 dag_func(store, SYMBOL_LN, lhs));
+				return dag_binop(store, OP_MUL, root, deriv[rhs]);
+			}
+
+			root = dag_binop(store, OP_DIV,
+			                 dag_binop(store, OP_MUL, deriv[lhs], rhs), lhs);
+			root = dag_binop(store, OP_PLUS, root,
+			                 dag_binop(store, OP_MUL, deriv[rhs],
+			                           dag_func(store, SYMBOL_LN, lhs)));
+			return dag_binop(store, OP_MUL, node, root);
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			return DAG_NONE;
+	}
+}
 
-bintree_t differentiate (const bintree_t root, FILE* tex)
+/*!
+ * @brief Differentiate nodes of the expression store in post-order.
+ *
+ * @return Derivative or DAG_NONE if an error occurred.
+ */
+static dag_t differentiate_dag_postorder
+(
+	dag_store_t store,      /*!< [in,out] expression store.                  */
+	dag_t       expression, /*!< [in]     input expression.                  */
+	dag_t*      deriv,      /*!< [in,out] found derivatives of nodes.        */
+	dag_t*      stack       /*!< [in,out] stack of nodes.                    */
+)
+{
+	size_t top = 0;
+	stack[top++] = expression;
+	while (top)
+	{
+		dag_t node = stack[top - 1];
+		if (deriv[node] != DAG_NONE)
+		{
+			--top;
+			continue;
+		}
+
+		dag_t  deps[2] = {DAG_NONE, DAG_NONE};
+		size_t amount  = dag_deriv_deps(store, node, deps);
+		bool   ready   = true;
+		for (size_t i = 0; i < amount; ++i)
+		{
+			if (deriv[deps[i]] == DAG_NONE)
+			{
+				stack[top++] = deps[i];
+				ready        = false;
+			}
+		}
+
+		if (!ready)
+			continue;
+
+		deriv[node] = differentiate_dag_node(store, node, deriv);
+		if (deriv[node] == DAG_NONE)
+		{
+			fputs("Cannot differentiate expression.\n\n", stderr);
+			return DAG_NONE;
+		}
+
+		--top;
+	}
+
+	return deriv[expression];
+}
+
+
+
+
+bintree_t differentiate (const bintree_t root, tex_t tex,
+                         diff_verbosity_t verbosity)
 {
 	assert (root);
-	assert (tex);
+	assert (tex || verbosity == DIFF_VERBOSITY_NONE);
+
+	sink_t output = (tex) ? tex_sink(tex) : NULL;
+	if (verbosity != DIFF_VERBOSITY_NONE)
+	{
+		print_context(CONTEXT_BEGIN_DIFF, output);
+		print_labelled_expression(tex, root);
+		print_context(CONTEXT_BEGIN_DIFF_1, output);
+	}
+
+	struct diff_stack stack = {NULL, 0, 0};
+	bintree_t         deriv = differentiate_tree(root, &stack, tex, verbosity);
 
-	print_context(CONTEXT_BEGIN_DIFF, tex);
-	print_expression(root, tex);
-	print_context(CONTEXT_BEGIN_DIFF_1, tex);
-	bintree_t deriv = differentiate_node(root, tex);
+	// Derivatives of unfinished nodes are left only after an error.
+	for (size_t i = 0; i < stack.size; ++i)
+	{
+		bintree_destroy(stack.frames[i].deriv[0]);
+		bintree_destroy(stack.frames[i].deriv[1]);
+	}
+
+	free(stack.frames);
 	if (!deriv)
-		return NULL;
+		return BINTREE_NULL;
+
+	// Derivative is optimized in place, so its copy is kept
+	// to be printed before the result of optimization.
+	bintree_t unoptimized = (verbosity >= DIFF_VERBOSITY_TOP)
+	                        ? bintree_copy(deriv) : BINTREE_NULL;
+	if (verbosity >= DIFF_VERBOSITY_TOP && !unoptimized)
+	{
+		fputs("Cannot allocate memory for derivative.\n\n", stderr);
+		return bintree_destroy(deriv);
+	}
 
-	print_context(CONTEXT_OPTIMIZE, tex);
-	fputs(" \\begin{dmath*}\n", tex);
-	print_expression(deriv, tex);
-	fputs(" = ", tex);
-	bintree_t ret = tree_optimize(deriv);
+	size_t    rewrites = 0;
+	bintree_t ret      = tree_optimize_counted(deriv, &rewrites);
 	if (!ret)
+	{
+		bintree_destroy(unoptimized);
 		return bintree_destroy(deriv);
-	
-	print_expression(ret, tex);
-	fputs(" .\n\\end{dmath*}\n\n", tex);
-	print_context(CONTEXT_END_DIFF, tex);
+	}
+
+	// Derivative which hasn't been changed isn't printed again.
+	if (verbosity >= DIFF_VERBOSITY_TOP && rewrites)
+	{
+		print_context(CONTEXT_OPTIMIZE, output);
+		sink_puts(output, " \\begin{dmath*}\n");
+		print_labelled_expression(tex, unoptimized);
+		sink_puts(output, " = ");
+		print_labelled_expression(tex, ret);
+		sink_puts(output, " .\n\\end{dmath*}\n\n");
+	}
+	else if (verbosity == DIFF_VERBOSITY_RESULT)
+	{
+		sink_puts(output, "\n\\begin{dmath*}\n(");
+		print_labelled_expression(tex, root);
+		sink_puts(output, ")' = ");
+		print_labelled_expression(tex, ret);
+		sink_puts(output, " .\n\\end{dmath*}\n\n");
+	}
+
+	bintree_destroy(unoptimized);
+	if (verbosity != DIFF_VERBOSITY_NONE)
+		print_context(CONTEXT_END_DIFF, output);
+
+	return ret;
+}
+
+
+dag_t differentiate_dag (dag_store_t store, dag_t expression)
+{
+	assert (store);
+	assert (expression != DAG_NONE);
+
+	// Nodes created during differentiation are never differentiated here,
+	// so derivatives are stored only for the existing nodes.
+	// Every node expands its dependencies only once, so the stack never
+	// has more than 2 * size + 1 elements.
+	size_t size  = dag_store_size(store) + 1;
+	dag_t* deriv = (dag_t*) calloc(size, sizeof *deriv);
+	dag_t* stack = (dag_t*) calloc(2 * size + 1, sizeof *stack);
+	dag_t  ret   = DAG_NONE;
+	if (deriv && stack)
+		ret = differentiate_dag_postorder(store, expression, deriv, stack);
+	else
+		fputs("Cannot allocate memory for differentiation.\n\n", stderr);
+
+	free(deriv);
+	free(stack);
 	return ret;
 }
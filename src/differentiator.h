@@ -9,18 +9,54 @@
 
 #include "tree/bintree.h"
 #include "tree/token_specific.h"
+#include "dag/dag.h"
+#include "tex/tex.h"
+
+
+
+/*!
+ * @brief How much of differentiation is written to the tex file.
+ */
+typedef enum
+{
+	DIFF_VERBOSITY_NONE   = 0, //!< nothing is written.
+	DIFF_VERBOSITY_RESULT = 1, //!< only optimized derivative is written.
+	DIFF_VERBOSITY_TOP    = 2, //!< rule of the root and derivative are written.
+	DIFF_VERBOSITY_FULL   = 3, //!< derivative of every node is written.
+}
+diff_verbosity_t;
 
 
 
 /*!
  * @brief Differentiate expression and writing it to the tex file.
  *
+ * @note Subexpressions which have been written once are referenced
+ * by their labels, so the output grows linearly with size of expression.
+ *
  * @return Derivative. If an error has been occurred it returns NULL.
  */
 bintree_t differentiate
 (
-	 const bintree_t root, /*!< [in]     input expression.                   */
-	 FILE*           tex   /*!< [in,out] output tex file.                    */
+	 const bintree_t  root,     /*!< [in]     input expression.              */
+	 tex_t            tex,      /*!< [in,out] article, it can be NULL
+	                                          if nothing is written.         */
+	 diff_verbosity_t verbosity /*!< [in]     what is written.               */
+);
+
+/*!
+ * @brief Differentiate expression from the hash-consed store.
+ *
+ * Derivative references subexpressions of the given expression
+ * instead of copying them and derivative of every shared subexpression
+ * is found only once. Nothing is written to the tex file.
+ *
+ * @return Derivative. If an error has been occurred it returns DAG_NONE.
+ */
+dag_t differentiate_dag
+(
+	dag_store_t store,     /*!< [in,out] expression store.                   */
+	dag_t       expression /*!< [in]     input expression.                   */
 );
 
 
@@ -7,18 +7,18 @@
 #define DSL_H_
 
 #define D_NODE    (expression)
-#define D_LHS     (D_NODE->left)
-#define D_RHS     (D_NODE->right)
+#define D_LHS     (BINTREE_NODE_LEFT(D_NODE))
+#define D_RHS     (BINTREE_NODE_RIGHT(D_NODE))
 #define D_PREFARG (D_LHS)
 #define D_POSTARG (D_RHS)
 #define D_ARG     (D_RHS)
 
-#define D_TOKEN         (D_NODE->value)
-#define D_LHS_TOKEN     (D_LHS->value)
-#define D_RHS_TOKEN     (D_RHS->value)
-#define D_PREFARG_TOKEN (D_PREFARG->value)
-#define D_POSTARG_TOKEN (D_POSTARG->value)
-#define D_ARG_TOKEN     (D_ARG->value)
+#define D_TOKEN         (BINTREE_NODE_VALUE(D_NODE))
+#define D_LHS_TOKEN     (BINTREE_NODE_VALUE(D_LHS))
+#define D_RHS_TOKEN     (BINTREE_NODE_VALUE(D_RHS))
+#define D_PREFARG_TOKEN (BINTREE_NODE_VALUE(D_PREFARG))
+#define D_POSTARG_TOKEN (BINTREE_NODE_VALUE(D_POSTARG))
+#define D_ARG_TOKEN     (BINTREE_NODE_VALUE(D_ARG))
 
 #define D_TYPE         (D_TOKEN.type)
 #define D_LHS_TYPE     (D_LHS_TOKEN.type)
@@ -41,6 +41,8 @@
 #define D_POSTARG_IDENT (D_POSTARG_TOKEN.value.ident)
 #define D_ARG_IDENT     (D_ARG_TOKEN.value.ident)
 
+#define D_FUNC     (D_TOKEN.func)
+
 #define D_OP         (D_TOKEN.value.operation)
 #define D_LHS_OP     (D_LHS_TOKEN.value.operation)
 #define D_RHS_OP     (D_RHS_TOKEN.value.operation)
@@ -58,7 +60,8 @@ do \
 { \
 	t.type = TOKEN_FUNC; \
 	t.value.ident = (NAME_); \
-	(RET_) = create_func_node(bintree_create(t), ARG_); \
+	t.func = token_function_id(t.value.ident); \
+	(RET_) = make_func_node(bintree_create(t), ARG_); \
 } \
 while (false)
 
@@ -67,7 +70,7 @@ do \
 { \
 	t.type = TOKEN_OP; \
 	t.value.operation = (OP_); \
-	(RET_) = create_prefunop_node(ARG_, t); \
+	(RET_) = make_prefunop_node(ARG_, t); \
 } \
 while (false)
 
@@ -85,18 +88,19 @@ do \
 { \
 	t.type = TOKEN_OP; \
 	t.value.operation = (OP_); \
-	(RET_) = create_binop_node(LHS_, RHS_, t); \
+	(RET_) = make_binop_node(LHS_, RHS_, t); \
 } \
 while (false)
 #define D_CHANGE_TO_NUMBER(WHAT_, NUM_) \
 do \
 { \
 	double num = (NUM_); \
-	(WHAT_)->left  = bintree_destroy((WHAT_)->left); \
-	(WHAT_)->right = bintree_destroy((WHAT_)->right); \
-	token_destroy(&(WHAT_)->value); \
-	(WHAT_)->value.type         = TOKEN_NUMBER; \
-	(WHAT_)->value.value.number = num; \
+	BINTREE_NODE_LEFT(WHAT_)  = bintree_destroy(BINTREE_NODE_LEFT(WHAT_)); \
+	BINTREE_NODE_RIGHT(WHAT_) = bintree_destroy(BINTREE_NODE_RIGHT(WHAT_)); \
+	token_destroy(&BINTREE_NODE_VALUE(WHAT_)); \
+	BINTREE_NODE_VALUE(WHAT_).type         = TOKEN_NUMBER; \
+	BINTREE_NODE_VALUE(WHAT_).value.number = num; \
+	bintree_value_changed(WHAT_); \
 } \
 while (false)
 
@@ -0,0 +1,261 @@
+/*!
+ * @file
+ * @brief Implementation of numeric forward-mode differentiation.
+ */
+
+#include "dual.h"
+#include "../builtins/builtins.h"
+#include "../dsl/dsl.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+
+
+
+/*!
+ * @brief Stack of dual numbers of evaluated subexpressions.
+ */
+struct dual_stack
+{
+	dual_t* values;   /*!< values of subexpressions.                         */
+	size_t  size;     /*!< amount of values in the stack.                    */
+	size_t  capacity; /*!< capacity of the stack.                            */
+};
+
+/*!
+ * @brief Value of e constant.
+ */
+static const double DUAL_E  = 2.71828182845904523536;
+
+/*!
+ * @brief Value of pi constant.
+ */
+static const double DUAL_PI = 3.14159265358979323846;
+
+
+
+
+/*!
+ * @brief Check number to be exact zero.
+ *
+ * @return Result of checking.
+ */
+static bool is_zero
+(
+	double num /*!< [in] number.                                             */
+)
+{
+	return fpclassify(num) == FP_ZERO;
+}
+
+/*!
+ * @brief Push dual number to the stack.
+ *
+ * @return Success of pushing.
+ */
+static bool dual_push
+(
+	struct dual_stack* stack, /*!< [in,out] stack of values.                 */
+	dual_t             value  /*!< [in]     pushed value.                    */
+)
+{
+	if (stack->size == stack->capacity)
+	{
+		size_t capacity = (stack->capacity) ? stack->capacity * 2 : 16;
+		void*  check    = realloc(stack->values,
+		                          capacity * sizeof *stack->values);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for dual numbers.\n\n", stderr);
+			return false;
+		}
+
+		stack->values   = (dual_t*) check;
+		stack->capacity = capacity;
+	}
+
+	stack->values[stack->size++] = value;
+	return true;
+}
+
+/*!
+ * @brief Calculate derivative of binary operation.
+ *
+ * @return Derivative.
+ */
+static double dual_op_deriv
+(
+	operation_t op,   /*!< [in] operation.                                   */
+	dual_t      lhs,  /*!< [in] left operand.                                */
+	dual_t      rhs,  /*!< [in] right operand.                               */
+	double      value /*!< [in] value of operation.                          */
+)
+{
+	double deriv = 0;
+	switch (op)
+	{
+		case OP_PLUS:
+			return lhs.deriv + rhs.deriv;
+
+		case OP_MINUS:
+			return lhs.deriv - rhs.deriv;
+
+		case OP_MUL:
+			return lhs.deriv * rhs.value + lhs.value * rhs.deriv;
+
+		case OP_DIV:
+			return (lhs.deriv - value * rhs.deriv) / rhs.value;
+
+		case OP_POW:
+			// Terms with zero factor are skipped since the other factor
+			// can be infinite where the base is zero.
+			if (!is_zero(lhs.deriv))
+				deriv += rhs.value * pow(lhs.value, rhs.value - 1) * lhs.deriv;
+
+			if (!is_zero(rhs.deriv))
+				deriv += value * log(lhs.value) * rhs.deriv;
+
+			return deriv;
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			assert ("UNREACHABLE" && false);
+			return NAN;
+	}
+}
+
+/*!
+ * @brief Push value of leaf to the stack.
+ *
+ * @return Success of pushing.
+ */
+static bool dual_leaf
+(
+	struct dual_stack* stack,      /*!< [in,out] stack of values.            */
+	const bintree_t    expression, /*!< [in]     leaf.                       */
+	double             point       /*!< [in]     point of differentiation.   */
+)
+{
+	dual_t value = {0, 0};
+	if (D_TYPE == TOKEN_NUMBER)
+		value.value = D_NUMBER;
+	else if (D_TYPE == TOKEN_VAR && D_IDENT == SYMBOL_X)
+		value = (dual_t) {point, 1};
+	else if (D_TYPE == TOKEN_VAR && D_IDENT == SYMBOL_E)
+		value.value = DUAL_E;
+	else if (D_TYPE == TOKEN_VAR && D_IDENT == SYMBOL_PI)
+		value.value = DUAL_PI;
+	else
+	{
+		if (D_TYPE == TOKEN_VAR)
+			fprintf(stderr, "Cannot evaluate variable %s.\n\n",
+			        symbol_name(D_IDENT));
+		else
+			fputs("Cannot evaluate unknown token.\n\n", stderr);
+
+		return false;
+	}
+
+	return dual_push(stack, value);
+}
+
+/*!
+ * @brief Replace values of operands on the top of stack by value of node.
+ *
+ * @return Success of evaluation.
+ */
+static bool dual_node
+(
+	struct dual_stack* stack,      /*!< [in,out] stack of values.            */
+	const bintree_t    expression, /*!< [in]     evaluated node.             */
+	double             point       /*!< [in]     point of differentiation.   */
+)
+{
+	if (!D_LHS && !D_RHS)
+		return dual_leaf(stack, D_NODE, point);
+
+	if (D_TYPE == TOKEN_FUNC)
+	{
+		const builtin_rule_t* rule = builtin_rule(D_FUNC);
+		if (!rule)
+		{
+			fprintf(stderr, "Cannot evaluate function %s.\n\n",
+			        symbol_name(D_IDENT));
+			return false;
+		}
+
+		// Dual number is truncated power series of the first order.
+		dual_t* arg       = &stack->values[stack->size - 1];
+		double  series[2] = {arg->value, arg->deriv};
+		double  result[2] = {0, 0};
+		double  scratch[2];
+		rule->series(result, series, scratch, 1);
+		*arg = (dual_t) {result[0], result[1]};
+		return true;
+	}
+
+	if (D_TYPE != TOKEN_OP || D_OP == OP_DERIV || D_OP == OP_EMPTY)
+	{
+		fputs("Cannot evaluate operation.\n\n", stderr);
+		return false;
+	}
+
+	if (D_ISPREFUNARY)
+	{
+		dual_t* arg = &stack->values[stack->size - 1];
+		if (D_OP == OP_MINUS)
+			*arg = (dual_t) {-arg->value, -arg->deriv};
+
+		return true;
+	}
+
+	dual_t* lhs   = &stack->values[stack->size - 2];
+	dual_t  rhs   = stack->values[stack->size - 1];
+	double  value = operation_calculate(D_OP, lhs->value, rhs.value);
+	*lhs = (dual_t) {value, dual_op_deriv(D_OP, *lhs, rhs, value)};
+	--stack->size;
+	return true;
+}
+
+
+
+
+bool dual_evaluate (const bintree_t expression, double point, dual_t* result)
+{
+	return dual_evaluate_points(expression, &point, 1, result);
+}
+
+
+bool dual_evaluate_points (const bintree_t expression, const double* points,
+                           size_t amount, dual_t* results)
+{
+	assert (expression);
+	assert (points);
+	assert (results);
+
+	struct dual_stack stack = {NULL, 0, 0};
+
+	bool ret = true;
+	for (size_t i = 0; i < amount && ret; ++i)
+	{
+		stack.size = 0;
+		bintree_t node = bintree_postorder_first(expression);
+		while (ret)
+		{
+			ret = dual_node(&stack, node, points[i]);
+			if (node == expression)
+				break;
+
+			node = bintree_postorder_next(expression, node);
+		}
+
+		if (ret)
+			results[i] = stack.values[0];
+	}
+
+	free(stack.values);
+	return ret;
+}
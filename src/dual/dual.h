@@ -0,0 +1,62 @@
+/*!
+ * @file
+ * @brief Header of numeric forward-mode differentiation.
+ *
+ * Expression is evaluated over dual numbers f + f' * eps where eps^2 = 0,
+ * so value and first derivative are found in one pass over the tree
+ * without building the derivative.
+ */
+
+#ifndef DUAL_H_
+#define DUAL_H_
+
+#include "../tree/bintree.h"
+
+
+
+/*!
+ * @brief Dual number.
+ */
+typedef struct
+{
+	double value; /*!< value of function.                                    */
+	double deriv; /*!< value of the first derivative.                        */
+}
+dual_t;
+
+
+
+/*!
+ * @brief Calculate value and the first derivative of expression at point.
+ *
+ * @note Expression can contain only variable x, numbers, constants e and pi,
+ * arithmetic operations and builtin functions.
+ *
+ * @return Success of calculation.
+ */
+bool dual_evaluate
+(
+	const bintree_t expression, /*!< [in]  expression.                       */
+	double          point,      /*!< [in]  point of differentiation.         */
+	dual_t*         result      /*!< [out] value and derivative.             */
+);
+
+/*!
+ * @brief The same as dual_evaluate() but for many points at once.
+ *
+ * @note Memory is allocated once for all points.
+ *
+ * @return Success of calculation.
+ */
+bool dual_evaluate_points
+(
+	const bintree_t expression, /*!< [in]  expression.                       */
+	const double*   points,     /*!< [in]  points of differentiation.        */
+	size_t          amount,     /*!< [in]  amount of points.                 */
+	dual_t*         results     /*!< [out] array of amount elements.         */
+);
+
+
+
+
+#endif // not defined DUAL_H_
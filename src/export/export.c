@@ -0,0 +1,285 @@
+/*!
+ * @file
+ * @brief Implementation of export of derivatives to C source code.
+ */
+
+#include "export.h"
+#include "../builtins/builtins.h"
+#include "../dag/dag.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Value of e constant.
+ */
+static const double EXPORT_E  = 2.71828182845904523536;
+
+/*!
+ * @brief Value of pi constant.
+ */
+static const double EXPORT_PI = 3.14159265358979323846;
+
+
+
+
+/*!
+ * @brief Print number as C literal of double type.
+ */
+static void export_number
+(
+	double num,   /*!< [in]     printed number.                              */
+	FILE*  output /*!< [in,out] C source file stream.                        */
+)
+{
+	if (isnan(num))
+	{
+		fputs("NAN", output);
+		return;
+	}
+
+	if (isinf(num))
+	{
+		fputs((num < 0) ? "(-INFINITY)" : "INFINITY", output);
+		return;
+	}
+
+	// The shortest representation which is read back to the same number.
+	char str[32] = "";
+	snprintf(str, sizeof str, "%.15g", num);
+	double back = strtod(str, NULL);
+	if (back < num || back > num)
+		snprintf(str, sizeof str, "%.17g", num);
+
+	// Number without point or exponent would be an integer in C.
+	bool integer = !strpbrk(str, ".e");
+	fprintf(output, (num < 0) ? "(%s%s)" : "%s%s", str, (integer) ? ".0" : "");
+}
+
+/*!
+ * @brief Print operand of node.
+ *
+ * @return Success of printing.
+ */
+static bool export_operand
+(
+	const dag_store_t store,  /*!< [in]     expression store.                */
+	dag_t             node,   /*!< [in]     operand.                         */
+	FILE*             output  /*!< [in,out] C source file stream.            */
+)
+{
+	// Leaves are printed in place, other nodes are already in variables.
+	if (dag_left(store, node) || dag_right(store, node))
+	{
+		fprintf(output, "t%lu", (unsigned long) node);
+		return true;
+	}
+
+	const token_t* value = dag_value(store, node);
+	if (value->type == TOKEN_NUMBER)
+	{
+		export_number(value->value.number, output);
+		return true;
+	}
+
+	if (value->type != TOKEN_VAR)
+	{
+		fputs("Cannot export unknown token.\n\n", stderr);
+		return false;
+	}
+
+	switch (value->value.ident)
+	{
+		case SYMBOL_X:
+			fputc('x', output);
+			return true;
+
+		case SYMBOL_E:
+			export_number(EXPORT_E, output);
+			return true;
+
+		case SYMBOL_PI:
+			export_number(EXPORT_PI, output);
+			return true;
+
+		default:
+			fprintf(stderr, "Cannot export variable %s.\n\n",
+			        symbol_name(value->value.ident));
+			return false;
+	}
+}
+
+/*!
+ * @brief Print variable with value of node whose operands are printed.
+ *
+ * @return Success of printing.
+ */
+static bool export_node
+(
+	const dag_store_t store,  /*!< [in]     expression store.                */
+	dag_t             node,   /*!< [in]     printed node.                    */
+	FILE*             output  /*!< [in,out] C source file stream.            */
+)
+{
+	const token_t* value = dag_value(store, node);
+	dag_t          left  = dag_left(store, node);
+	dag_t          right = dag_right(store, node);
+
+	fprintf(output, "\tconst double t%lu = ", (unsigned long) node);
+	if (value->type == TOKEN_FUNC)
+	{
+		const builtin_rule_t* rule = builtin_rule(value->func);
+		if (!rule)
+		{
+			fprintf(stderr, "Cannot export function %s.\n\n",
+			        symbol_name(value->value.ident));
+			return false;
+		}
+
+		fprintf(output, "%s(", rule->c_name);
+		if (!export_operand(store, right, output))
+			return false;
+
+		fputs(");\n", output);
+		return true;
+	}
+
+	operation_t op = value->value.operation;
+	if (value->type != TOKEN_OP || !left
+	    || op == OP_DERIV || op == OP_EMPTY)
+	{
+		fputs("Cannot export operation.\n\n", stderr);
+		return false;
+	}
+
+	if (!right)
+	{
+		if (op == OP_MINUS)
+			fputc('-', output);
+
+		if (!export_operand(store, left, output))
+			return false;
+
+		fputs(";\n", output);
+		return true;
+	}
+
+	if (op == OP_POW)
+		fputs("pow(", output);
+
+	if (!export_operand(store, left, output))
+		return false;
+
+	fputs((op == OP_POW) ? ", " : " ", output);
+	if (op != OP_POW)
+		fprintf(output, "%c ", (char) op);
+
+	if (!export_operand(store, right, output))
+		return false;
+
+	fputs((op == OP_POW) ? ");\n" : ";\n", output);
+	return true;
+}
+
+/*!
+ * @brief Print body of function which calculates derivatives.
+ *
+ * @return Success of printing.
+ */
+static bool export_body
+(
+	const dag_store_t store,  /*!< [in]     expression store.                */
+	const dag_t*      roots,  /*!< [in]     derivatives in the store.        */
+	size_t            amount, /*!< [in]     amount of derivatives.           */
+	FILE*             output  /*!< [in,out] C source file stream.            */
+)
+{
+	// Children are always added to the store before their parents,
+	// so nodes are printed in order of their ids.
+	size_t size = dag_store_size(store);
+	bool*  used = (bool*) calloc(size + 1, sizeof *used);
+	if (!used)
+	{
+		fputs("Cannot allocate memory for export.\n\n", stderr);
+		return false;
+	}
+
+	for (size_t i = 0; i < amount; ++i)
+		used[roots[i]] = true;
+
+	for (size_t node = size; node > 0; --node)
+		if (used[node])
+		{
+			used[dag_left(store,  (dag_t) node)] = true;
+			used[dag_right(store, (dag_t) node)] = true;
+		}
+
+	bool ret = true;
+	for (size_t node = 1; node <= size && ret; ++node)
+		if (used[node] && (dag_left(store,  (dag_t) node)
+		                   || dag_right(store, (dag_t) node)))
+			ret = export_node(store, (dag_t) node, output);
+
+	if (ret)
+		fputc('\n', output);
+
+	for (size_t i = 0; i < amount && ret; ++i)
+	{
+		fprintf(output, "\tresult[%zu] = ", i);
+		ret = export_operand(store, roots[i], output);
+		fputs(";\n", output);
+	}
+
+	free(used);
+	return ret;
+}
+
+
+
+
+bool export_c (FILE* output, const bintree_t* derivatives, size_t max_deriv)
+{
+	assert (output);
+	assert (derivatives);
+
+	dag_store_t store = dag_store_create();
+	if (!store)
+	{
+		fputs("Cannot create expression store.\n\n", stderr);
+		return false;
+	}
+
+	dag_t roots[max_deriv + 1];
+	bool  ret = true;
+	for (size_t i = 0; i <= max_deriv && ret; ++i)
+	{
+		// Identical subexpressions of all derivatives become one node.
+		roots[i] = (derivatives[i]) ? dag_from_bintree(store, derivatives[i])
+		                            : DAG_NONE;
+		ret = roots[i] != DAG_NONE;
+	}
+
+	if (ret)
+	{
+		fprintf(output, "#include <math.h>\n\n\n"
+		                "/*\n"
+		                " * result[i] is the i-th derivative at x.\n"
+		                " */\n"
+		                "void derivatives (double x, double result[%zu]);\n\n\n"
+		                "void derivatives (double x, double result[%zu])\n"
+		                "{\n",
+		        max_deriv + 1, max_deriv + 1);
+		ret = export_body(store, roots, max_deriv + 1, output);
+		fputs("}\n", output);
+	}
+	else
+		fputs("Cannot export derivatives.\n\n", stderr);
+
+	dag_store_destroy(store);
+	return ret;
+}
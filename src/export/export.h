@@ -0,0 +1,41 @@
+/*!
+ * @file
+ * @brief Header of export of derivatives to C source code.
+ *
+ * All derivatives are written as one C function which calculates them
+ * at once. Subexpressions which are shared by several derivatives
+ * are calculated only once.
+ */
+
+#ifndef EXPORT_H_
+#define EXPORT_H_
+
+#include "../tree/bintree.h"
+
+#include <stdio.h>
+
+
+
+/*!
+ * @brief Write C source file with function which calculates derivatives.
+ *
+ * @note Written function has prototype
+ * void derivatives (double x, double result[max_deriv + 1]),
+ * where result[i] is the i-th derivative of expression at x.
+ *
+ * @note Derivatives can contain only variable x, numbers, constants e and pi,
+ * arithmetic operations and builtin functions.
+ *
+ * @return Success of writing.
+ */
+bool export_c
+(
+	FILE*            output,      /*!< [in,out] C source file stream.        */
+	const bintree_t* derivatives, /*!< [in]     array with derivatives.      */
+	size_t           max_deriv    /*!< [in]     amount of derivatives.       */
+);
+
+
+
+
+#endif // not defined EXPORT_H_
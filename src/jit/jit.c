@@ -0,0 +1,555 @@
+/*!
+ * @file
+ * @brief Implementation of expression compiler to native code.
+ */
+
+// MAP_ANONYMOUS isn't a part of strict C11 environment.
+#ifndef _DEFAULT_SOURCE
+#	define _DEFAULT_SOURCE
+#endif
+
+#include "jit.h"
+#include "../builtins/builtins.h"
+#include "../bytecode/bytecode.h"
+#include "../dsl/dsl.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__unix__)
+/*!
+ * @brief Expressions are compiled to x86-64 instructions.
+ */
+#	define JIT_NATIVE
+#	include <sys/mman.h>
+#endif
+
+
+
+
+/*!
+ * @brief Compiled expression.
+ */
+struct jit
+{
+	void*          memory;   /*!< executable memory with native code.        */
+	size_t         size;     /*!< size of executable memory.                 */
+	jit_function_t function; /*!< native function or NULL.                   */
+	bytecode_t     bytecode; /*!< bytecode used without native function.     */
+};
+
+#ifdef JIT_NATIVE
+/*!
+ * @brief Native code under construction.
+ *
+ * Code is a stack machine whose top is held in xmm0 register. The rest
+ * of the stack lies in the frame of function below saved value of x.
+ */
+struct jit_buffer
+{
+	uint8_t* code;       /*!< instructions.                                  */
+	size_t   size;       /*!< amount of bytes of instructions.               */
+	size_t   capacity;   /*!< capacity of instructions array.                */
+	double*  constants;  /*!< constants placed after instructions.           */
+	size_t*  fixups;     /*!< offsets of addresses of constants.             */
+	size_t   const_size; /*!< amount of constants.                           */
+	size_t   const_cap;  /*!< capacity of constants and fixups arrays.       */
+	size_t   depth;      /*!< depth of stack after emitted instructions.     */
+	size_t   max_depth;  /*!< maximal depth of stack.                        */
+};
+
+/*!
+ * @brief Value of e constant.
+ */
+static const double JIT_E  = 2.71828182845904523536;
+
+/*!
+ * @brief Value of pi constant.
+ */
+static const double JIT_PI = 3.14159265358979323846;
+
+/*!
+ * @brief Maximal depth of stack kept in the frame of native function.
+ * Deeper expressions are evaluated by bytecode whose stack is on the heap.
+ */
+static const size_t JIT_MAX_DEPTH = 4096;
+
+/*!
+ * @brief Offset of frame size in sub rsp instruction of prologue.
+ */
+static const size_t JIT_FRAME_OFFSET = 7;
+
+/*!
+ * @brief Offset of saved x relative to rbp.
+ */
+static const int32_t JIT_X_SLOT = -8;
+
+//! push rbp; mov rbp, rsp; sub rsp, imm32.
+static const uint8_t JIT_PROLOGUE[]   = {0x55, 0x48, 0x89, 0xE5,
+                                         0x48, 0x81, 0xEC, 0, 0, 0, 0};
+//! leave; ret.
+static const uint8_t JIT_EPILOGUE[]   = {0xC9, 0xC3};
+//! movsd [rbp + disp32], xmm0.
+static const uint8_t JIT_STORE[]      = {0xF2, 0x0F, 0x11, 0x85};
+//! movsd xmm0, [rbp + disp32].
+static const uint8_t JIT_LOAD[]       = {0xF2, 0x0F, 0x10, 0x85};
+//! movsd xmm1, [rbp + disp32].
+static const uint8_t JIT_LOAD_XMM1[]  = {0xF2, 0x0F, 0x10, 0x8D};
+//! movsd xmm0, [rip + disp32].
+static const uint8_t JIT_CONST[]      = {0xF2, 0x0F, 0x10, 0x05};
+//! movsd xmm1, [rip + disp32].
+static const uint8_t JIT_CONST_XMM1[] = {0xF2, 0x0F, 0x10, 0x0D};
+//! addsd xmm0, [rbp + disp32].
+static const uint8_t JIT_ADD[]        = {0xF2, 0x0F, 0x58, 0x85};
+//! mulsd xmm0, [rbp + disp32].
+static const uint8_t JIT_MUL[]        = {0xF2, 0x0F, 0x59, 0x85};
+//! subsd xmm1, xmm0; movapd xmm0, xmm1.
+static const uint8_t JIT_SUB[]        = {0xF2, 0x0F, 0x5C, 0xC8,
+                                         0x66, 0x0F, 0x28, 0xC1};
+//! divsd xmm1, xmm0; movapd xmm0, xmm1.
+static const uint8_t JIT_DIV[]        = {0xF2, 0x0F, 0x5E, 0xC8,
+                                         0x66, 0x0F, 0x28, 0xC1};
+//! xorpd xmm0, xmm1.
+static const uint8_t JIT_XOR[]        = {0x66, 0x0F, 0x57, 0xC1};
+//! movapd xmm1, xmm0.
+static const uint8_t JIT_MOVE_XMM1[]  = {0x66, 0x0F, 0x28, 0xC8};
+//! mov rax, imm64.
+static const uint8_t JIT_MOV_RAX[]    = {0x48, 0xB8};
+//! call rax.
+static const uint8_t JIT_CALL_RAX[]   = {0xFF, 0xD0};
+#endif
+
+
+
+
+#ifdef JIT_NATIVE
+/*!
+ * @brief Write 32-bit number in little-endian order.
+ */
+static void jit_write32
+(
+	uint8_t* dest, /*!< [out] destination.                                   */
+	uint32_t num   /*!< [in]  written number.                                */
+)
+{
+	for (size_t i = 0; i < 4; ++i)
+		dest[i] = (uint8_t) (num >> (8 * i));
+}
+
+/*!
+ * @brief Append bytes to instructions.
+ *
+ * @return Success of appending.
+ */
+static bool jit_emit
+(
+	struct jit_buffer* buf,   /*!< [in,out] native code.                     */
+	const uint8_t*     bytes, /*!< [in]     appended bytes.                  */
+	size_t             amount /*!< [in]     amount of bytes.                 */
+)
+{
+	if (buf->size + amount > buf->capacity)
+	{
+		size_t capacity = (buf->capacity) ? buf->capacity * 2 : 256;
+		while (capacity < buf->size + amount)
+			capacity *= 2;
+
+		void* check = realloc(buf->code, capacity * sizeof *buf->code);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for native code.\n\n", stderr);
+			return false;
+		}
+
+		buf->code     = (uint8_t*) check;
+		buf->capacity = capacity;
+	}
+
+	memcpy(buf->code + buf->size, bytes, amount);
+	buf->size += amount;
+	return true;
+}
+
+/*!
+ * @brief Append instruction with 32-bit displacement.
+ *
+ * @return Success of appending.
+ */
+static bool jit_emit_disp
+(
+	struct jit_buffer* buf,         /*!< [in,out] native code.               */
+	const uint8_t      instr[4],    /*!< [in]     instruction with ModRM.    */
+	int32_t            displacement /*!< [in]     displacement.              */
+)
+{
+	uint8_t disp[4];
+	jit_write32(disp, (uint32_t) displacement);
+	return jit_emit(buf, instr, 4) && jit_emit(buf, disp, sizeof disp);
+}
+
+/*!
+ * @brief Get offset of stack cell relative to rbp.
+ *
+ * @return Offset.
+ */
+static int32_t jit_slot
+(
+	size_t index /*!< [in] index of cell.                                    */
+)
+{
+	return JIT_X_SLOT - 8 * (int32_t) (index + 1);
+}
+
+/*!
+ * @brief Append loading of constant to register.
+ *
+ * @return Success of appending.
+ */
+static bool jit_emit_const
+(
+	struct jit_buffer* buf,      /*!< [in,out] native code.                  */
+	const uint8_t      instr[4], /*!< [in]     rip-relative load.            */
+	double             num       /*!< [in]     loaded constant.              */
+)
+{
+	if (buf->const_size == buf->const_cap)
+	{
+		size_t capacity = (buf->const_cap) ? buf->const_cap * 2 : 16;
+		void*  check    = realloc(buf->constants,
+		                          capacity * sizeof *buf->constants);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for native code.\n\n", stderr);
+			return false;
+		}
+
+		buf->constants = (double*) check;
+		check          = realloc(buf->fixups, capacity * sizeof *buf->fixups);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for native code.\n\n", stderr);
+			return false;
+		}
+
+		buf->fixups    = (size_t*) check;
+		buf->const_cap = capacity;
+	}
+
+	// Address of constant is known only after the last instruction.
+	if (!jit_emit_disp(buf, instr, 0))
+		return false;
+
+	buf->constants[buf->const_size] = num;
+	buf->fixups[buf->const_size++]  = buf->size - 4;
+	return true;
+}
+
+/*!
+ * @brief Append call of function whose argument and result are in xmm0.
+ *
+ * @return Success of appending.
+ */
+static bool jit_emit_call
+(
+	struct jit_buffer* buf,     /*!< [in,out] native code.                   */
+	uintptr_t          function /*!< [in]     address of function.           */
+)
+{
+	uint8_t address[8];
+	jit_write32(address,     (uint32_t) function);
+	jit_write32(address + 4, (uint32_t) ((uint64_t) function >> 32));
+	return jit_emit(buf, JIT_MOV_RAX, sizeof JIT_MOV_RAX)
+	       && jit_emit(buf, address, sizeof address)
+	       && jit_emit(buf, JIT_CALL_RAX, sizeof JIT_CALL_RAX);
+}
+
+/*!
+ * @brief Append instructions which push value to the stack.
+ *
+ * @return Success of appending.
+ */
+static bool jit_emit_push
+(
+	struct jit_buffer* buf, /*!< [in,out] native code.                       */
+	bool               x,   /*!< [in]     push variable x instead of num.    */
+	double             num  /*!< [in]     pushed constant.                   */
+)
+{
+	if (buf->depth == JIT_MAX_DEPTH)
+		return false;
+
+	// Previous top is moved from register to the frame.
+	if (buf->depth && !jit_emit_disp(buf, JIT_STORE, jit_slot(buf->depth - 1)))
+		return false;
+
+	if (++buf->depth > buf->max_depth)
+		buf->max_depth = buf->depth;
+
+	if (x)
+		return jit_emit_disp(buf, JIT_LOAD, JIT_X_SLOT);
+
+	return jit_emit_const(buf, JIT_CONST, num);
+}
+
+/*!
+ * @brief Append instructions of binary operation.
+ *
+ * @return Success of appending.
+ */
+static bool jit_emit_binary
+(
+	struct jit_buffer* buf, /*!< [in,out] native code.                       */
+	operation_t        op   /*!< [in]     operation.                         */
+)
+{
+	// Right operand is in xmm0 and left one is in the frame.
+	int32_t lhs = jit_slot(--buf->depth - 1);
+	switch (op)
+	{
+		case OP_PLUS:
+			return jit_emit_disp(buf, JIT_ADD, lhs);
+
+		case OP_MUL:
+			return jit_emit_disp(buf, JIT_MUL, lhs);
+
+		case OP_MINUS:
+			return jit_emit_disp(buf, JIT_LOAD_XMM1, lhs)
+			       && jit_emit(buf, JIT_SUB, sizeof JIT_SUB);
+
+		case OP_DIV:
+			return jit_emit_disp(buf, JIT_LOAD_XMM1, lhs)
+			       && jit_emit(buf, JIT_DIV, sizeof JIT_DIV);
+
+		case OP_POW:
+			return jit_emit(buf, JIT_MOVE_XMM1, sizeof JIT_MOVE_XMM1)
+			       && jit_emit_disp(buf, JIT_LOAD, lhs)
+			       && jit_emit_call(buf, (uintptr_t) pow);
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			return false;
+	}
+}
+
+/*!
+ * @brief Append instructions of node whose children are already compiled.
+ *
+ * @return Success of compilation.
+ */
+static bool jit_node
+(
+	struct jit_buffer* buf,       /*!< [in,out] native code.                 */
+	const bintree_t    expression /*!< [in]     compiled node.               */
+)
+{
+	if (!D_LHS && !D_RHS)
+	{
+		if (D_TYPE == TOKEN_NUMBER)
+			return jit_emit_push(buf, false, D_NUMBER);
+
+		if (D_TYPE != TOKEN_VAR)
+			return false;
+
+		switch (D_IDENT)
+		{
+			case SYMBOL_X:
+				return jit_emit_push(buf, true, 0);
+
+			case SYMBOL_E:
+				return jit_emit_push(buf, false, JIT_E);
+
+			case SYMBOL_PI:
+				return jit_emit_push(buf, false, JIT_PI);
+
+			default:
+				return false;
+		}
+	}
+
+	if (D_TYPE == TOKEN_FUNC)
+	{
+		const builtin_rule_t* rule = builtin_rule(D_FUNC);
+		return rule && jit_emit_call(buf, (uintptr_t) rule->evaluate);
+	}
+
+	if (D_TYPE != TOKEN_OP)
+		return false;
+
+	if (D_ISPREFUNARY)
+	{
+		if (D_OP == OP_MINUS)
+			return jit_emit_const(buf, JIT_CONST_XMM1, -0.0)
+			       && jit_emit(buf, JIT_XOR, sizeof JIT_XOR);
+
+		return D_OP == OP_PLUS;
+	}
+
+	if (D_ISPOSTUNARY)
+		return false;
+
+	return jit_emit_binary(buf, D_OP);
+}
+
+/*!
+ * @brief Translate expression to instructions.
+ *
+ * @return Success of translation.
+ */
+static bool jit_translate
+(
+	struct jit_buffer* buf,       /*!< [in,out] native code.                 */
+	const bintree_t    expression /*!< [in]     expression.                  */
+)
+{
+	if (!jit_emit(buf, JIT_PROLOGUE, sizeof JIT_PROLOGUE)
+	    || !jit_emit_disp(buf, JIT_STORE, JIT_X_SLOT))
+		return false;
+
+	// Post-order of the tree is exactly the order of stack machine.
+	bintree_t node = bintree_postorder_first(expression);
+	while (jit_node(buf, node))
+	{
+		if (node == expression)
+			return jit_emit(buf, JIT_EPILOGUE, sizeof JIT_EPILOGUE);
+
+		node = bintree_postorder_next(expression, node);
+	}
+
+	return false;
+}
+
+/*!
+ * @brief Place translated instructions and constants to executable memory.
+ *
+ * @return Success of placing.
+ */
+static bool jit_link
+(
+	jit_t              jit, /*!< [in,out] compiled expression.               */
+	struct jit_buffer* buf  /*!< [in,out] translated instructions.           */
+)
+{
+	// Frame keeps x and the stack, rsp stays aligned by 16 bytes for calls.
+	size_t frame = (8 + 8 * buf->max_depth + 15) & ~(size_t) 15;
+	jit_write32(buf->code + JIT_FRAME_OFFSET, (uint32_t) frame);
+
+	size_t pool = (buf->size + 7) & ~(size_t) 7;
+	for (size_t i = 0; i < buf->const_size; ++i)
+	{
+		size_t next = buf->fixups[i] + 4;
+		jit_write32(buf->code + buf->fixups[i],
+		            (uint32_t) (pool + 8 * i - next));
+	}
+
+	size_t size   = pool + buf->const_size * sizeof *buf->constants;
+	void*  memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+	                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return false;
+
+	memset(memory, 0xCC, pool);
+	memcpy(memory, buf->code, buf->size);
+	if (buf->const_size)
+		memcpy((uint8_t*) memory + pool, buf->constants,
+		       buf->const_size * sizeof *buf->constants);
+
+	// Memory is never writable and executable at the same time.
+	if (mprotect(memory, size, PROT_READ | PROT_EXEC))
+	{
+		munmap(memory, size);
+		return false;
+	}
+
+	jit->memory = memory;
+	jit->size   = size;
+	memcpy(&jit->function, &memory, sizeof jit->function);
+	return true;
+}
+
+/*!
+ * @brief Compile expression to native function.
+ *
+ * @return Success of compilation.
+ */
+static bool jit_native
+(
+	jit_t           jit,       /*!< [in,out] compiled expression.            */
+	const bintree_t expression /*!< [in]     expression.                     */
+)
+{
+	struct jit_buffer buf = {0};
+
+	bool ret = jit_translate(&buf, expression) && jit_link(jit, &buf);
+
+	free(buf.code);
+	free(buf.constants);
+	free(buf.fixups);
+	return ret;
+}
+#endif
+
+
+
+
+jit_t jit_compile (const bintree_t expression)
+{
+	assert (expression);
+
+	jit_t jit = (jit_t) calloc(1, sizeof *jit);
+	if (!jit)
+	{
+		fputs("Cannot allocate memory for compiled expression.\n\n", stderr);
+		return NULL;
+	}
+
+#ifdef JIT_NATIVE
+	if (jit_native(jit, expression))
+		return jit;
+#endif
+
+	// Everything which can't be compiled to native code is interpreted.
+	jit->bytecode = bytecode_compile(expression);
+	if (!jit->bytecode)
+		return jit_destroy(jit);
+
+	return jit;
+}
+
+
+jit_t jit_destroy (jit_t jit)
+{
+	if (!jit)
+		return NULL;
+
+#ifdef JIT_NATIVE
+	if (jit->memory)
+		munmap(jit->memory, jit->size);
+#endif
+
+	bytecode_destroy(jit->bytecode);
+	free(jit);
+	return NULL;
+}
+
+
+jit_function_t jit_function (const jit_t jit)
+{
+	assert (jit);
+
+	return jit->function;
+}
+
+
+double jit_evaluate (jit_t jit, double x)
+{
+	assert (jit);
+
+	if (jit->function)
+		return jit->function(x);
+
+	return bytecode_evaluate(jit->bytecode, x);
+}
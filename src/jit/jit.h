@@ -0,0 +1,86 @@
+/*!
+ * @file
+ * @brief Header of expression compiler to native code.
+ *
+ * On x86-64 expression is translated to SSE2 instructions placed to
+ * an executable memory. Builtin functions and powers become calls of
+ * functions of the standard library. On other platforms or if native code
+ * can't be produced compiled expression is evaluated by bytecode.
+ */
+
+#ifndef JIT_H_
+#define JIT_H_
+
+#include "../tree/bintree.h"
+
+
+
+/*!
+ * @brief Function which calculates value of expression.
+ */
+typedef double (*jit_function_t) (double x);
+
+/*!
+ * @brief Expression compiled to native code.
+ */
+typedef struct jit* jit_t;
+
+
+
+/*!
+ * @brief Compile expression to native code.
+ *
+ * @note Expression can be compiled only if it contains variable x, numbers,
+ * constants e and pi, arithmetic operations and builtin functions.
+ *
+ * @note Don't forget to free memory using jit_destroy() function.
+ *
+ * @return Compiled expression or NULL if expression can't be evaluated
+ * numerically or an error occurred.
+ */
+jit_t jit_compile
+(
+	const bintree_t expression /*!< [in] expression.                         */
+);
+
+/*!
+ * @brief Destroy compiled expression.
+ *
+ * @return NULL.
+ */
+jit_t jit_destroy
+(
+	jit_t jit /*!< [in,out] compiled expression.                             */
+);
+
+/*!
+ * @brief Get native function of compiled expression.
+ *
+ * @note Function is valid until jit_destroy() call. It doesn't use any
+ * shared state, so it can be called by several threads at once.
+ *
+ * @return Native function or NULL if expression is evaluated by bytecode.
+ */
+jit_function_t jit_function
+(
+	const jit_t jit /*!< [in] compiled expression.                           */
+);
+
+/*!
+ * @brief Evaluate compiled expression at given point.
+ *
+ * @note If there is no native function it has the same restrictions
+ * as bytecode_evaluate().
+ *
+ * @return Value of expression.
+ */
+double jit_evaluate
+(
+	jit_t  jit, /*!< [in,out] compiled expression.                           */
+	double x    /*!< [in]     value of variable x.                           */
+);
+
+
+
+
+#endif // not defined JIT_H_
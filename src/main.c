@@ -4,20 +4,261 @@
  */
 
 
+#include "dual/dual.h"
+#include "export/export.h"
 #include "parser/parser.h"
+#include "pdf/pdf.h"
+#include "tabulate/tabulate.h"
+#include "taylor/taylor.h"
 #include "tex/tex.h"
 #include "utilities/utilities.h"
 #include "differentiator.h"
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 
-int main (void)
+
+
+/*!
+ * @brief Amount of points which are evaluated at once in dual mode.
+ */
+static const size_t DUAL_CHUNK_SIZE = 1024;
+
+/*!
+ * @brief Names of verbosity levels of differentiation in order of their values.
+ */
+static const char* const VERBOSITY_NAMES[] = {"none", "result", "top", "full"};
+
+/*!
+ * @brief Processing of expression given in command line.
+ *
+ * @return Exit code.
+ */
+typedef int (*expression_mode_t) (const bintree_t expression,
+                                  const void*     params);
+
+
+
+
+/*!
+ * @brief Read points from stdin and write values and derivatives
+ * of expression at them to stdout.
+ *
+ * @return Exit code.
+ */
+static int dual_points
+(
+	const bintree_t expression, /*!< [in] expression.                        */
+	const void*     params      /*!< [in] unused.                            */
+)
+{
+	MAYBE_UNUSED(params);
+
+	while (true)
+	{
+		double points[DUAL_CHUNK_SIZE];
+		dual_t results[DUAL_CHUNK_SIZE];
+		size_t amount = 0;
+		while (amount < DUAL_CHUNK_SIZE && scanf("%lf", &points[amount]) == 1)
+			++amount;
+
+		if (!dual_evaluate_points(expression, points, amount, results))
+			return 1;
+
+		for (size_t i = 0; i < amount; ++i)
+			printf("%.17g %.17g %.17g\n",
+			       points[i], results[i].value, results[i].deriv);
+
+		if (amount < DUAL_CHUNK_SIZE)
+			return 0;
+	}
+}
+
+/*!
+ * @brief Write table of derivative of expression to stdout.
+ *
+ * @return Exit code.
+ */
+static int tabulate_table
+(
+	const bintree_t expression, /*!< [in] expression.                        */
+	const void*     params      /*!< [in] parameters of tabulation.          */
+)
+{
+	return (tabulate(expression, (const tabulate_params_t*) params, stdout))
+	       ? 0 : 1;
+}
+
+/*!
+ * @brief Parse expression given in command line and process it.
+ *
+ * @return Exit code.
+ */
+static int expression_mode
+(
+	const char*       expression, /*!< [in] expression in text format.       */
+	expression_mode_t mode,       /*!< [in] processing of expression.        */
+	const void*       params      /*!< [in] parameters of processing.        */
+)
+{
+	parser_t parser;
+	if (!parser_init(&parser, expression))
+		return 1;
+
+	bintree_arena_t arena = bintree_arena_create();
+	if (!arena)
+	{
+		fputs("Cannot create node arena.\n\n", stderr);
+		parser_deinit(&parser);
+		return 1;
+	}
+
+	bintree_arena_select(arena);
+	bintree_t tree = parse_expr(&parser);
+	int       ret  = (tree) ? mode(tree, params) : 1;
+
+	bintree_arena_destroy(arena);
+	parser_deinit(&parser);
+	symbol_table_destroy();
+	return ret;
+}
+
+/*!
+ * @brief Parse parameters of tabulation given in command line.
+ *
+ * @return Success of parsing.
+ */
+static bool tabulate_arguments
+(
+	tabulate_params_t* params, /*!< [out] parameters of tabulation.          */
+	char*              argv[]  /*!< [in]  from, to, steps and order.         */
+)
+{
+	return sscanf(argv[0], "%lf", &params->from)  == 1
+	       && sscanf(argv[1], "%lf", &params->to)    == 1
+	       && sscanf(argv[2], "%zu", &params->steps) == 1
+	       && sscanf(argv[3], "%zu", &params->order) == 1
+	       && params->steps < SIZE_MAX;
+}
+
+/*!
+ * @brief Parse verbosity of differentiation given in command line.
+ *
+ * @return Success of parsing.
+ */
+static bool verbosity_argument
+(
+	diff_verbosity_t* verbosity, /*!< [out] verbosity of differentiation.    */
+	const char*       name       /*!< [in]  name of verbosity.               */
+)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(VERBOSITY_NAMES); ++i)
+	{
+		if (!strcmp(name, VERBOSITY_NAMES[i]))
+		{
+			*verbosity = (diff_verbosity_t) i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * @brief Print usage of the program.
+ *
+ * @return Exit code.
+ */
+static int usage
+(
+	const char* program /*!< [in] name of the program.                       */
+)
+{
+	fprintf(stderr, "Usage: %s [--taylor] [--steps full|top|result|none] "
+	                "[--export <C file>]\n"
+	                "       %*s [--output <tex file>] [--pdf]\n"
+	                "       %s --dual <expression>\n"
+	                "       %s [--threads <amount>] [--binary] --tabulate "
+	                "<expression> <from> <to> <steps> <order>\n",
+	        program, (int) strlen(program), "", program, program);
+	return 1;
+}
+
+/*!
+ * @brief Write C source file with derivatives.
+ *
+ * @return Success of writing.
+ */
+static bool export_source
+(
+	const char*      path,        /*!< [in] path to C source file.           */
+	const bintree_t* derivatives, /*!< [in] array with derivatives.          */
+	size_t           max_deriv    /*!< [in] amount of derivatives.           */
+)
+{
+	FILE* output = fopen(path, "w");
+	if (!output)
+	{
+		perror("Cannot create C source file");
+		return false;
+	}
+
+	bool ret = export_c(output, derivatives, max_deriv);
+	return fclose(output) == 0 && ret;
+}
+
+
+
+
+int main (int argc, char* argv[])
 {
 	srand(time(NULL));
 
-	size_t len          = 0;
+	// With --taylor coefficients are calculated numerically
+	// instead of building derivatives.
+	bool              series     = false;
+	bool              pdf        = false;
+	diff_verbosity_t  verbosity  = DIFF_VERBOSITY_FULL;
+	const char*       source     = NULL;
+	const char*       article    = "Taylor.tex";
+	const char*       tabulation = NULL;
+	tabulate_params_t table      = {0, 0, 0, 0, 0, TABULATE_CSV};
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--taylor"))
+			series = true;
+		else if (!strcmp(argv[i], "--dual") && i + 1 < argc)
+			return expression_mode(argv[i + 1], dual_points, NULL);
+		else if (!strcmp(argv[i], "--steps") && i + 1 < argc
+		         && verbosity_argument(&verbosity, argv[i + 1]))
+			++i;
+		else if (!strcmp(argv[i], "--export") && i + 1 < argc)
+			source = argv[++i];
+		else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+			article = argv[++i];
+		else if (!strcmp(argv[i], "--pdf"))
+			pdf = true;
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc
+		         && sscanf(argv[i + 1], "%zu", &table.threads) == 1)
+			++i;
+		else if (!strcmp(argv[i], "--binary"))
+			table.format = TABULATE_BINARY;
+		else if (!strcmp(argv[i], "--tabulate") && i + 5 < argc
+		         && tabulate_arguments(&table, &argv[i + 2]))
+		{
+			tabulation = argv[i + 1];
+			i += 5;
+		}
+		else
+			return usage(argv[0]);
+	}
+
+	if (tabulation)
+		return expression_mode(tabulation, tabulate_table, &table);
+
 	size_t max_deriv    = 0;
 	double substitution = 0;
 	if (scanf("%zu %lf", &max_deriv, &substitution) != 2)
@@ -27,55 +268,115 @@ int main (void)
 		return 1;
 	}
 
-	char* input = read_string(stdin, &len);
-	if (!input)
+	parser_t parser;
+	if (!parser_init_file(&parser, stdin))
 		return 1;
 
-	parser_t parser;
-	if (!parser_init(&parser, input))
+	bintree_arena_t arena = bintree_arena_create();
+	if (!arena)
+	{
+		fputs("Cannot create node arena.\n\n", stderr);
+		parser_deinit(&parser);
 		return 1;
+	}
 
+	bintree_arena_select(arena);
 	bintree_t derivatives[max_deriv + 1];
 	for (size_t i = 0; i <= max_deriv; ++i)
-		derivatives[i] = NULL;
+		derivatives[i] = BINTREE_NULL;
 
 	derivatives[0] = parse_expr(&parser);
 	if (!derivatives[0])
 	{
+		bintree_arena_destroy(arena);
+		parser_deinit(&parser);
+		return 1;
+	}
+
+	sink_t output = sink_create_path(article);
+	if (!output)
+	{
+		perror("Cannot create tex file");
+		bintree_arena_destroy(arena);
 		parser_deinit(&parser);
-		free(input);
 		return 1;
 	}
 
-	FILE* tex = start_article(derivatives[0], max_deriv);
+	tex_t tex = start_article(output, derivatives[0], max_deriv);
 	if (!tex)
 	{
-		bintree_destroy(derivatives[0]);
-		free(input);
+		sink_destroy(output);
+		bintree_arena_destroy(arena);
+		parser_deinit(&parser);
 		return 1;
 	}
 
 	int ret = 0;
-	for (size_t i = 1; i <= max_deriv; ++i)
+	if (series)
+	{
+		double coefficients[max_deriv + 1];
+		series = taylor_coefficients(derivatives[0], substitution,
+		                             max_deriv, coefficients);
+		if (series)
+			ret = (finish_article_series(tex, derivatives[0], coefficients,
+			                             max_deriv, substitution)) ? 0 : 1;
+		else
+			fputs("Cannot expand expression to series numerically, "
+			      "derivatives will be found symbolically.\n\n", stderr);
+	}
+
+	if (!series)
 	{
-		derivatives[i] = differentiate(derivatives[i - 1], tex);
-		if (!derivatives[i])
+		for (size_t i = 1; i <= max_deriv; ++i)
 		{
-			break;
+			derivatives[i] = differentiate(derivatives[i - 1], tex, verbosity);
+			if (!derivatives[i])
+			{
+				ret = 1;
+				break;
+			}
+		}
+
+		if (ret == 0)
+			ret = (finish_article(tex, derivatives, max_deriv, substitution))
+			      ? 0 : 1;
+		else
+			abort_article(tex);
+	}
+	else if (source)
+		fputs("Cannot export derivatives which aren't built.\n\n", stderr);
+
+	// Tex file is closed before pdflatex reads it.
+	if (!sink_destroy(output) && ret == 0)
+	{
+		fputs("Cannot write tex file.\n\n", stderr);
+		ret = 1;
+	}
+
+	// Pdf file is built in background while derivatives are exported.
+	pdf_build_t build = (pdf && ret == 0) ? pdf_build_start(article) : NULL;
+	if (pdf && ret == 0 && !build)
+		ret = 1;
+
+	if (!series && source && ret == 0)
+		ret = (export_source(source, derivatives, max_deriv)) ? 0 : 1;
+
+	if (build)
+	{
+		int status = pdf_build_wait(build);
+		if (status != 0)
+		{
+			fprintf(stderr, "Cannot build pdf file, "
+			                "pdflatex exit status is %d.\n\n", status);
 			ret = 1;
 		}
 	}
-	
-	if (ret == 0)
-		finish_article(tex, derivatives, max_deriv, substitution);
-	else
-		fclose(tex);
 
 	parser_deinit(&parser);
-	free(input);
 	
-	for (size_t i = 0; i <= max_deriv; ++i)
-		derivatives[i] = bintree_destroy(derivatives[i]);
+	// All derivatives are released at once with their arena.
+	bintree_arena_destroy(arena);
+	symbol_table_destroy();
 	
 	return ret;
 }
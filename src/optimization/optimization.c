@@ -4,20 +4,19 @@
  */
 
 #include "optimization.h"
+#include "../builtins/builtins.h"
 #include "../tree/token_specific.h"
 #include "../dsl/dsl.h"
 #include "../utilities/utilities.h"
 #include "../tex/tex.h"
 
 #include <assert.h>
-#include <string.h>
-#include <math.h>
 
 
 
 
 /*!
- * @brief Use pre-calculation optimization.
+ * @brief Use pre-calculation optimization at the root of expression.
  *
  * @return True if optimization was used else false.
  */
@@ -26,12 +25,6 @@ static bool precalc_optimization
 	bintree_t expression /*!< [in,out] tree for optimization.                */
 )
 {
-	if (!D_NODE)
-		return false;
-
-	bool ret = false;
-	ret |= precalc_optimization(D_LHS);
-	ret |= precalc_optimization(D_RHS);
 	if (D_TYPE == TOKEN_OP)
 	{
 		if (D_ISPREFUNARY)
@@ -48,22 +41,41 @@ static bool precalc_optimization
 						D_CHANGE_TO_NUMBER(D_NODE, -D_PREFARG_NUMBER);
 						return true;
 					}
-					else if (D_PREFARG_TYPE == TOKEN_OP
-					         && D_PREFARG_OP == OP_PLUS)
+					else if (D_PREFARG_TYPE != TOKEN_OP)
+						return false;
+
+					if (!BINTREE_NODE_RIGHT(D_PREFARG))
+					{
+						// -(-u) = u.
+						if (D_PREFARG_OP != OP_MINUS)
+							return false;
+
+						D_NODE = bintree_replace(D_NODE,
+						                         BINTREE_NODE_LEFT(D_PREFARG));
+						return true;
+					}
+					else if (D_PREFARG_OP == OP_PLUS)
 					{
-						bintree_replace(D_NODE, D_PREFARG);
-						D_OP = OP_MINUS;
+						// -(p + q) = (-p) - q, the sum becomes negation of p.
+						bintree_t sum = D_PREFARG;
+						bintree_hook_right(D_NODE, BINTREE_NODE_RIGHT(sum));
+						BINTREE_NODE_VALUE(sum).value.operation = OP_MINUS;
+						bintree_value_changed(sum);
+						// New child isn't visited again, -p is simplified here.
+						precalc_optimization(sum);
 						return true;
 					}
-					else if (D_PREFARG_TYPE == TOKEN_OP
-					         && D_PREFARG_OP == OP_MINUS)
+					else if (D_PREFARG_OP == OP_MINUS)
 					{
-						bintree_replace(D_NODE, D_PREFARG);
-						D_OP = OP_PLUS;
+						// -(p - q) = q - p.
+						bintree_t diff = D_PREFARG;
+						bintree_t lhs  = bintree_unhook_left(diff);
+						bintree_hook_left(D_NODE, BINTREE_NODE_RIGHT(diff));
+						bintree_hook_right(D_NODE, lhs);
 						return true;
 					}
 
-					return ret;
+					return false;
 
 				case OP_EMPTY:
 				case OP_MUL:
@@ -72,7 +84,7 @@ static bool precalc_optimization
 				case OP_DERIV:
 				default:
 					assert ("UNREACHABLE" && false);
-					return ret;
+					return false;
 			}
 		}
 
@@ -102,7 +114,8 @@ static bool precalc_optimization
 				if (D_LHS_TYPE == TOKEN_NUMBER
 				    && double_equal(D_LHS_NUMBER, 0))
 				{
-					D_LHS = bintree_replace(D_LHS, D_RHS);
+					// 0 - u = -u.
+					bintree_hook_left(D_NODE, D_RHS);
 					return true;
 				}
 				else if (D_RHS_TYPE == TOKEN_NUMBER
@@ -197,38 +210,16 @@ static bool precalc_optimization
 	}
 	else if (D_TYPE == TOKEN_FUNC)
 	{
-		if (!strcmp(D_IDENT, "sin") || !strcmp(D_IDENT, "tg"))
-		{
-			if (D_ARG_TYPE == TOKEN_NUMBER && double_equal(D_ARG_NUMBER, 0))
-			{
-				D_CHANGE_TO_NUMBER(D_NODE, 0);
-			}
-		}
-		else if (!strcmp(D_IDENT, "cos"))
-		{
-			if (D_ARG_TYPE == TOKEN_NUMBER && double_equal(D_ARG_NUMBER, 0))
-			{
-				D_CHANGE_TO_NUMBER(D_NODE, 1);
-			}
-		}
-		else if (!strcmp(D_IDENT, "ln"))
-		{
-			if (D_ARG_TYPE == TOKEN_NUMBER && double_equal(D_ARG_NUMBER, 1))
-			{
-				D_CHANGE_TO_NUMBER(D_NODE, 0);
-			}
-			else if (D_ARG_TYPE == TOKEN_VAR && !strcmp(D_ARG_IDENT, "e"))
-			{
-				D_CHANGE_TO_NUMBER(D_NODE, 1);
-			}
-		}
+		const builtin_rule_t* rule = builtin_rule(D_FUNC);
+		if (rule)
+			return rule->simplify(D_NODE);
 	}
 
-	return ret;
+	return false;
 }
 
 /*!
- * @brief Use folding constants optimization.
+ * @brief Use folding constants optimization at the root of expression.
  *
  * @return True if optimization was used else false.
  */
@@ -237,70 +228,50 @@ static bool fold_const_optimization
 	bintree_t expression /*!< [in,out] tree for optimization.                */
 )
 {
-	if (!D_NODE)
-		return false;
-
-	bool ret = false;
-	ret |= fold_const_optimization(D_LHS);
-	ret |= fold_const_optimization(D_RHS);
 	if (D_TYPE != TOKEN_OP || !D_ISBINOP)
-		return ret;
+		return false;
 
 	if (D_LHS_TYPE == TOKEN_NUMBER && D_RHS_TYPE == TOKEN_NUMBER)
 	{
-		double val = 0;
-		switch (D_OP)
-		{
-			case OP_EMPTY:
-			case OP_DERIV:
-				break;
-
-			case OP_PLUS:
-				val = D_LHS_NUMBER + D_RHS_NUMBER;
-				break;
-
-			case OP_MINUS:
-				val = D_LHS_NUMBER - D_RHS_NUMBER;
-				break;
-
-			case OP_MUL:
-				val = D_LHS_NUMBER * D_RHS_NUMBER;
-				break;
-
-			case OP_DIV:
-				val = D_LHS_NUMBER / D_RHS_NUMBER;
-				break;
-
-			case OP_POW:
-				val = pow(D_LHS_NUMBER, D_RHS_NUMBER);
-				break;
-
-			default:
-				assert ("UNREACHABLE" && false);
-		}
-
-		D_CHANGE_TO_NUMBER(D_NODE, val);
+		D_CHANGE_TO_NUMBER(D_NODE, operation_calculate(D_OP, D_LHS_NUMBER,
+		                                               D_RHS_NUMBER));
 		return true;
 	}
 
-	return ret;
+	return false;
 }
 
 
 
 
 bintree_t tree_optimize (bintree_t root)
+{
+	return tree_optimize_counted(root, NULL);
+}
+
+
+bintree_t tree_optimize_counted (bintree_t root, size_t* rewrites)
 {
 	assert (root);
 
-	bool has_optimization = false;
-	do
+	// Optimizations only change the node they are applied to and take its
+	// children which are already optimized. So it is enough to visit nodes
+	// in post-order and optimize every node until nothing changes.
+	size_t    count = 0;
+	bintree_t node  = bintree_postorder_first(root);
+	while (true)
 	{
-		has_optimization = false;
-		has_optimization |= fold_const_optimization(root);
-		has_optimization |= precalc_optimization(root);
+		while (fold_const_optimization(node) || precalc_optimization(node))
+			++count;
+
+		if (node == root)
+			break;
+
+		node = bintree_postorder_next(root, node);
 	}
-	while (has_optimization);
+
+	if (rewrites)
+		*rewrites = count;
 
 	return root;
 }
@@ -311,9 +282,13 @@ bool tree_is_constant (const bintree_t expression)
 	if (!D_NODE)
 		return true;
 
-	bool ret  = D_TYPE != TOKEN_VAR || strcmp(D_IDENT, "x");
-	ret      &= tree_is_constant(D_LHS);
-	ret      &= tree_is_constant(D_RHS);
+	for (bintree_t node = D_NODE; node;
+	     node = bintree_preorder_next(D_NODE, node))
+	{
+		token_t t = BINTREE_NODE_VALUE(node);
+		if (t.type == TOKEN_VAR && t.value.ident == SYMBOL_X)
+			return false;
+	}
 
-	return ret;
+	return true;
 }
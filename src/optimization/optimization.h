@@ -22,6 +22,20 @@ bintree_t tree_optimize
 	bintree_t root /*!< [in,out] tree for optimization.                      */
 );
 
+/*!
+ * @brief Optimize expression tree and count applied rewrites.
+ *
+ * @note It changes the original expression.
+ *
+ * @return Optimized expression or NULL if an error occurred.
+ */
+bintree_t tree_optimize_counted
+(
+	bintree_t root,    /*!< [in,out] tree for optimization.                  */
+	size_t*   rewrites /*!< [out]    amount of applied rewrites. It can be
+	                                 NULL.                                   */
+);
+
 /*!
  * @brief Check tree to variables absence.
  *
@@ -1,9 +1,12 @@
 /*!
  * @file
- * @brief File with recursive descent parser implementation.
+ * @brief File with parser implementation.
  */
 
-#define GNU_SOURCE
+// mmap() isn't a part of strict C11 environment.
+#ifndef _DEFAULT_SOURCE
+#	define _DEFAULT_SOURCE
+#endif
 
 #include "../tree/token_specific.h"
 #include "../utilities/utilities.h"
@@ -12,19 +15,78 @@
 #include "token.h"
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 
 
 
-static bintree_t parse_number        (parser_t* parser);
-static bintree_t parse_ident         (parser_t* parser);
-static bintree_t parse_function      (parser_t* parser);
-static bintree_t parse_factor        (parser_t* parser);
-static bintree_t parse_term          (parser_t* parser);
-static bintree_t parse_expr_of_prior (parser_t* paraer, int prior);
+/*!
+ * @brief Kind of construction which is parsed, but isn't finished yet.
+ */
+typedef enum
+{
+	PARSER_FRAME_PAREN  = 0, //!< '(' expr_0 ')'.
+	PARSER_FRAME_FUNC   = 1, //!< function '(' expr_0 ')'.
+	PARSER_FRAME_PREFIX = 2, //!< prefix operation before factor.
+	PARSER_FRAME_BINOP  = 3, //!< binary operation before right operand.
+}
+parser_frame_kind_t;
+
+/*!
+ * @brief Unfinished construction of expression.
+ */
+struct parser_frame
+{
+	parser_frame_kind_t kind;  /*!< kind of construction.                    */
+	token_t             op;    /*!< prefix or binary operation.              */
+	int                 prior; /*!< priority of binary operation.            */
+	bintree_t           node;  /*!< left operand or function node.           */
+};
+
+/*!
+ * @brief Stack of unfinished constructions.
+ */
+struct parser_stack
+{
+	struct parser_frame* frames;   /*!< frames of the stack.                 */
+	size_t               size;     /*!< amount of frames.                    */
+	size_t               capacity; /*!< capacity of the stack.               */
+};
+
+/*!
+ * @brief Initial capacity of the parser stack.
+ */
+static const size_t PARSER_STACK_INIT_CAPACITY = 64;
+
+/*!
+ * @brief Size of chunk which input stream is read by.
+ */
+static const size_t PARSER_CHUNK_SIZE = 65536;
+
+/*!
+ * @brief Maximal amount of decimal digits which always fit to uint64_t.
+ */
+static const int NUMBER_MAX_DIGITS = 19;
+
+/*!
+ * @brief Maximal mantissa which is converted to double exactly.
+ */
+static const uint64_t NUMBER_MAX_EXACT = (uint64_t) 1 << 53;
+
+/*!
+ * @brief Powers of ten which are represented by double exactly.
+ */
+static const double EXACT_POWERS_OF_TEN[] =
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
 
 
 
@@ -66,6 +128,132 @@ static bool get_lexeme_op_or_key
 	}
 }
 
+/*!
+ * @brief Read decimal digits and add them to mantissa.
+ *
+ * @return The first character after digits.
+ */
+static const char* read_digits
+(
+	const char* str,      /*!< [in]     the first character.                 */
+	const char* end,      /*!< [in]     end of characters.                   */
+	uint64_t*   mantissa, /*!< [in,out] significant digits.                  */
+	int*        digits,   /*!< [in,out] amount of significant digits.        */
+	int*        shift,    /*!< [out]    amount of digits which aren't added,
+	                                    shift of mantissa is their
+	                                    difference.                          */
+	bool*       exact     /*!< [in,out] all non-zero digits are added.       */
+)
+{
+	const char* cur   = str;
+	int         added = 0;
+	for (; cur < end && isdigit(*cur); ++cur)
+	{
+		if (*digits >= NUMBER_MAX_DIGITS)
+		{
+			*exact = *exact && *cur == '0';
+			continue;
+		}
+
+		*mantissa = *mantissa * 10 + (uint64_t) (*cur - '0');
+		*digits  += (*mantissa) ? 1 : 0;
+		++added;
+	}
+
+	*shift = (int) (cur - str) - added;
+	return cur;
+}
+
+/*!
+ * @brief Read decimal number from the beginning of given characters.
+ *
+ * Number is rounded by one floating-point operation if both its mantissa
+ * and power of ten are exact, else it is converted by strtod() which
+ * rounds correctly.
+ *
+ * @note Characters aren't required to be terminated by '\0'.
+ *
+ * @return Amount of read characters.
+ */
+static unsigned read_number
+(
+	const char* str,   /*!< [in]  the first character.                       */
+	const char* end,   /*!< [in]  end of characters.                         */
+	double*     number /*!< [out] read number.                               */
+)
+{
+	uint64_t    mantissa = 0;
+	int         digits   = 0;
+	int         shift    = 0;
+	int         exponent = 0;
+	bool        exact    = true;
+	const char* cur      = read_digits(str, end, &mantissa, &digits,
+	                                   &shift, &exact);
+
+	// Skipped digits of integer part increase the number.
+	exponent = shift;
+	if (cur < end && *cur == '.')
+	{
+		const char* frac = cur + 1;
+		cur = read_digits(frac, end, &mantissa, &digits, &shift, &exact);
+		exponent -= (int) (cur - frac) - shift;
+	}
+
+	// Exponent without digits isn't a part of number.
+	if (cur < end && (*cur == 'e' || *cur == 'E'))
+	{
+		const char* exp      = cur + 1;
+		bool        negative = exp < end && *exp == '-';
+		if (exp < end && (*exp == '+' || *exp == '-'))
+			++exp;
+
+		if (exp < end && isdigit(*exp))
+		{
+			int value = 0;
+			for (; exp < end && isdigit(*exp); ++exp)
+				value = (value < 100000) ? value * 10 + (*exp - '0') : value;
+
+			exponent += (negative) ? -value : value;
+			cur       = exp;
+		}
+	}
+
+	unsigned length = (unsigned) (cur - str);
+	int      max    = (int) ARRAY_SIZE(EXACT_POWERS_OF_TEN) - 1;
+	if (!mantissa)
+	{
+		*number = 0;
+		return length;
+	}
+
+	if (exact && mantissa <= NUMBER_MAX_EXACT
+	    && exponent >= -max && exponent <= max)
+	{
+		*number = (exponent < 0)
+		          ? (double) mantissa / EXACT_POWERS_OF_TEN[-exponent]
+		          : (double) mantissa * EXACT_POWERS_OF_TEN[exponent];
+		return length;
+	}
+
+	char  local[64] = "";
+	char* copy      = (length < sizeof local) ? local
+	                                          : (char*) malloc(length + 1);
+	if (!copy)
+	{
+		fputs("Cannot allocate memory for number.\n\n", stderr);
+		*number = 0;
+		return length;
+	}
+
+	memcpy(copy, str, length);
+	copy[length] = '\0';
+	*number      = strtod(copy, NULL);
+	if (copy != local)
+		free(copy);
+
+	return length;
+}
+
 /*!
  * @brief Get identifier lexeme from given string.
  *
@@ -74,11 +262,12 @@ static bool get_lexeme_op_or_key
 static bool get_lexeme_ident
 (
 	lexeme_t*   lexeme, /*!< [out] parsed lexeme.                            */
-	const char* str     /*!< [in]  input string.                             */
+	const char* str,    /*!< [in]  input string.                             */
+	const char* end     /*!< [in]  end of input.                             */
 )
 {
 	unsigned length = 0;
-	while (isident(str[++length]))
+	while (str + ++length < end && isident(str[length]))
 		continue;
 
 	lexeme->type   = LEXEME_IDENT;
@@ -94,16 +283,15 @@ static bool get_lexeme_ident
 static bool get_lexeme_number
 (
 	lexeme_t*   lexeme, /*!< [out] parsed lexeme.                            */
-	const char* str     /*!< [in]  input string.                             */
+	const char* str,    /*!< [in]  input string.                             */
+	const char* end     /*!< [in]  end of input.                             */
 )
 {
-	unsigned length = 0;
-	double   tmp;
-	sscanf(str, "%lf%n", &tmp, (int*) &length);
+	unsigned length = read_number(str, end, &lexeme->number);
 
-	if (isident(str[length]))
+	if (str + length < end && isident(str[length]))
 	{
-		while (isident(str[++length]))
+		while (str + ++length < end && isident(str[length]))
 			continue;
 
 		lexeme->length = length;
@@ -142,106 +330,205 @@ static bool get_lexeme_eof
 static bool get_lexeme
 (
 	lexeme_t*   lexeme, /*!< [out] parsed lexeme.                            */
-	const char* str     /*!< [in]  input string.                             */
+	const char* str,    /*!< [in]  input string.                             */
+	const char* end     /*!< [in]  end of input.                             */
 )
 {
 	lexeme->ptr  = str;
 	lexeme->type = LEXEME_UNKNOWN;
-	if (*str == '\0')
+	if (str == end || *str == '\0')
 		return get_lexeme_eof(lexeme, str);
 
 	if (isdigit(*str))
-		return get_lexeme_number(lexeme, str);
+		return get_lexeme_number(lexeme, str, end);
 
 	if (iskey(*str))
 		return get_lexeme_op_or_key(lexeme, str);
 
 	if (isident(*str))
-		return get_lexeme_ident(lexeme, str);
+		return get_lexeme_ident(lexeme, str, end);
 
 	assert ("Unreachable" || false);
 	return false;
 }
 
 /*!
- * @brief Skip all white-space characters.
+ * @brief Read the next chunk of input stream to the buffer of parser.
+ *
+ * Characters before the kept lexemes aren't needed anymore, so they
+ * are dropped and the buffer grows only if it is filled by characters
+ * which are needed.
+ *
+ * @return False if input is over or an error occurred.
  */
-static void skip_spaces
+static bool parser_fill
 (
-	const char** lines, /*!< [in]     array of lines.                        */
-	unsigned*    line,  /*!< [in,out] number of current line.                */
-	unsigned*    pos    /*!< [in,out] current position in line.              */
+	parser_t* parser /*!< [in,out] parser state.                             */
 )
 {
-	unsigned l  = *line;
-	unsigned p  = *pos;
-	char     ch = '\0';
-	while (isspace(ch = lines[l][p]))
+	if (!parser->stream)
+		return false;
+
+	// Kept lexemes refer to the buffer, so they are moved with it.
+	const char* keep = parser->cur;
+	for (size_t i = 0; i < PARSER_WINDOW && i < parser->lexed; ++i)
+		if (parser->window[i].ptr < keep)
+			keep = parser->window[i].ptr;
+
+	size_t drop = (size_t) (keep - parser->buffer);
+	size_t kept = (size_t) (parser->end - keep);
+	size_t cur  = (size_t) (parser->cur - keep);
+	size_t ptrs[PARSER_WINDOW] = {0};
+	for (size_t i = 0; i < PARSER_WINDOW && i < parser->lexed; ++i)
+		ptrs[i] = (size_t) (parser->window[i].ptr - keep);
+
+	if (kept == parser->buffer_cap)
 	{
-		if (ch == '\n')
+		size_t capacity = parser->buffer_cap * 2;
+		void*  check    = realloc(parser->buffer, capacity);
+		if (!check)
 		{
-			++l;
-			p = 0;
+			fputs("Cannot allocate memory for input.\n\n", stderr);
+			parser->stream = NULL;
+			return false;
 		}
-		else
-			++p;
+
+		parser->buffer     = (char*) check;
+		parser->buffer_cap = capacity;
+	}
+
+	memmove(parser->buffer, parser->buffer + drop, kept);
+	parser->begin = parser->buffer;
+	parser->cur   = parser->buffer + cur;
+	parser->end   = parser->buffer + kept;
+	for (size_t i = 0; i < PARSER_WINDOW && i < parser->lexed; ++i)
+		parser->window[i].ptr = parser->buffer + ptrs[i];
+
+	size_t read = fread(parser->buffer + kept, 1,
+	                    parser->buffer_cap - kept, parser->stream);
+	if (!read)
+	{
+		if (ferror(parser->stream))
+			fputs("Cannot read input.\n\n", stderr);
+
+		parser->stream = NULL;
+		return false;
 	}
 
-	*line = l;
-	*pos  = p;
+	parser->end += read;
+	return true;
 }
 
 /*!
- * @brief Split lines to lexemes.
+ * @brief Read input stream until the next lexeme is in the buffer.
  *
- * @note Don't forget to free memory.
- *
- * @return Array of lexemes. If an error has been occurred it returns NULL.
+ * @note Lexeme ends before a space or a key character except sign
+ * of exponent. The next character is read too, lexer looks at it.
  */
-static lexeme_t* split_to_lexemes
+static void parser_read_lexeme
 (
-	const char** lines /*!< [in] array of lines.                             */
+	parser_t* parser /*!< [in,out] parser state.                             */
 )
 {
-	const size_t LEX_INCREASE_CAP = 1000;
-	size_t       index            = 0;
-	unsigned     line             = 0;
-	unsigned     pos              = 0;
-	lexeme_t*    lexemes          = NULL;
+	if (!parser->stream)
+		return;
 
+	size_t length = 0;
 	do
 	{
-		if (index % LEX_INCREASE_CAP == 0)
+		for (; parser->cur + length < parser->end; ++length)
 		{
-			void* check = realloc(lexemes,
-			                      (index + LEX_INCREASE_CAP)
-			                      * sizeof *lexemes);
-			if (!check)
+			char ch   = parser->cur[length];
+			bool sign = (ch == '+' || ch == '-') && length
+			            && (parser->cur[length - 1] == 'e'
+			                || parser->cur[length - 1] == 'E');
+			if (isspace(ch) || (iskey(ch) && !sign))
+				return;
+		}
+	}
+	while (parser_fill(parser));
+}
+
+/*!
+ * @brief Skip all white-space characters.
+ */
+static void skip_spaces
+(
+	parser_t* parser /*!< [in,out] parser state.                             */
+)
+{
+	do
+	{
+		const char* cur = parser->cur;
+		while (cur < parser->end && isspace(*cur))
+		{
+			if (*cur == '\n')
 			{
-				fputs("Cannot allocate memory for lexemes array.\n\n", stderr);
-				free(lexemes);
-				return NULL;
+				++parser->line;
+				parser->line_pos = 0;
 			}
+			else
+				++parser->line_pos;
 
-			lexemes = (lexeme_t*) check;
+			++cur;
 		}
 
-		skip_spaces(lines, &line, &pos);
-		lexemes[index].line = line;
-		lexemes[index].pos  = pos;
-		if (!get_lexeme(&lexemes[index], lines[line] + pos))
-		{
-			// The first part of error report was printed in get_lexeme()
-			fprintf(stderr, "%s\n", lines[line]);
-			free(lexemes);
-			return NULL;
-		}
+		parser->cur = cur;
+	}
+	while (parser->cur == parser->end && parser_fill(parser));
+}
+
+/*!
+ * @brief Lex the next lexeme to the window of parser.
+ *
+ * @note Lexeme is unknown if an error has been occurred.
+ */
+static void parser_lex
+(
+	parser_t* parser /*!< [in,out] parser state.                             */
+)
+{
+	skip_spaces(parser);
+	parser_read_lexeme(parser);
 
-		pos += lexemes[index++].length;
+	lexeme_t* lexeme = &parser->window[parser->lexed++ % PARSER_WINDOW];
+	lexeme->line = parser->line;
+	lexeme->pos  = parser->line_pos;
+	if (!get_lexeme(lexeme, parser->cur, parser->end))
+	{
+		// The first part of error report was printed in get_lexeme()
+		parser_print_line(parser, lexeme);
+		lexeme->type   = LEXEME_UNKNOWN;
+		parser->failed = true;
 	}
-	while (*lines[line]);
 
-	return lexemes;
+	parser->cur      += lexeme->length;
+	parser->line_pos += lexeme->length;
+}
+
+/*!
+ * @brief Start parsing of given characters.
+ */
+static void parser_start
+(
+	parser_t*   parser, /*!< [out] parser.                                   */
+	const char* str,    /*!< [in]  the first character of input.             */
+	const char* end     /*!< [in]  end of input.                             */
+)
+{
+	parser->cur        = str;
+	parser->end        = end;
+	parser->line       = 0;
+	parser->line_pos   = 0;
+	parser->lexed      = 0;
+	parser->pos        = 0;
+	parser->failed     = false;
+	parser->begin      = str;
+	parser->buffer     = NULL;
+	parser->buffer_cap = 0;
+	parser->stream     = NULL;
+	parser->map        = NULL;
+	parser->map_size   = 0;
 }
 
 /*!
@@ -256,8 +543,7 @@ static token_t lexeme_to_number_token
 	const lexeme_t* lexeme /*!< [in]  lexeme which will be converted.        */
 )
 {
-	token_t token = {.type = TOKEN_NUMBER, .value.number = 0};
-	sscanf(lexeme->ptr, "%lf", &token.value.number);
+	token_t token = {.type = TOKEN_NUMBER, .value.number = lexeme->number};
 	return token;
 }
 
@@ -275,13 +561,8 @@ static token_t lexeme_to_ident_token
 {
 	token_t token;
 	token.type        = TOKEN_VAR;
-	token.value.ident = (char*) calloc(lexeme->length + 1,
-	                                   sizeof *token.value.ident);
-	if (token.value.ident)
-	{
-		strncpy(token.value.ident, lexeme->ptr, lexeme->length);
-	}
-	else
+	token.value.ident = symbol_intern(lexeme->ptr, lexeme->length);
+	if (token.value.ident == SYMBOL_NONE)
 	{
 		token.type = TOKEN_UNKNOWN;
 		fputs("Cannot allocate memory for ident token.\n\n", stderr);
@@ -344,7 +625,7 @@ static token_t lexeme_to_token
 		case LEXEME_LPAREN:
 		case LEXEME_RPAREN:
 		default:
-			return (token_t) {.type = TOKEN_UNKNOWN, .value.ident = NULL};
+			return (token_t) {.type = TOKEN_UNKNOWN, .value.number = 0};
 	}
 }
 
@@ -374,221 +655,299 @@ static int get_priority
 }
 
 /*!
- * @brief Parse number.
+ * @brief Create number node from number lexeme.
  *
- * @return Parsed tree.
+ * @return Number node or NULL if an error occurred.
  */
 static bintree_t parse_number
 (
-	parser_t* parser /*!< [in,out] parser state.                             */
+	const lexeme_t* lexeme /*!< [in] number lexeme.                          */
 )
 {
-	size_t          pos    = parser_get_pos(parser);
-	const lexeme_t* lexeme = parser_next(parser);
-	if (lexeme->type == LEXEME_NUMBER)
-	{
-		bintree_t root = bintree_create(lexeme_to_token(lexeme));
-		if (root)
-			return root;
-
+	bintree_t root = bintree_create(lexeme_to_token(lexeme));
+	if (!root)
 		fputs("Cannot allocate memory for number node.\n\n", stderr);
-	}
 
-	parser_restore(parser, pos);
-	return NULL;
+	return root;
 }
 
 /*!
- * @brief Parse identifier.
+ * @brief Create variable or function node from identifier lexeme.
  *
- * @return Parsed tree.
+ * @return Identifier node or NULL if an error occurred.
  */
 static bintree_t parse_ident
 (
-	parser_t* parser /*!< [in,out] parser state.                             */
+	const lexeme_t* lexeme, /*!< [in] identifier lexeme.                     */
+	bool            func    /*!< [in] identifier is name of function.        */
 )
 {
-	size_t          pos    = parser_get_pos(parser);
-	const lexeme_t* lexeme = parser_next(parser);
-	if (lexeme->type == LEXEME_IDENT)
+	token_t token = lexeme_to_token(lexeme);
+	if (token.type == TOKEN_UNKNOWN)
+		return BINTREE_NULL;
+
+	if (func)
 	{
-		token_t token = lexeme_to_token(lexeme);
-		if (token.value.ident)
-		{
-			bintree_t root = bintree_create_by_moving(token);
-			if (root)
-				return root;
-		}
+		token.type = TOKEN_FUNC;
+		token.func = token_function_id(token.value.ident);
+	}
 
+	bintree_t root = bintree_create_by_moving(token);
+	if (!root)
+	{
 		token_destroy(&token);
 		fputs("Cannot allocate memory for ident node.\n\n", stderr);
 	}
 
-	parser_restore(parser, pos);
-	return NULL;
+	return root;
 }
 
 /*!
- * @brief Parse function.
- *
- * function ::= ident '(' expression ')'
+ * @brief Push frame to the parser stack.
  *
- * @return Parsed tree.
+ * @return Success of pushing.
  */
-static bintree_t parse_function
+static bool parser_stack_push
 (
-	parser_t* parser /*!< [in,out] parsing state.                            */
+	struct parser_stack* stack, /*!< [in,out] parser stack.                  */
+	struct parser_frame  frame  /*!< [in]     pushed frame.                  */
 )
 {
-	size_t    pos    = parser_get_pos(parser);
-	bintree_t func   = parse_ident(parser);
-	if (func && lexeme_equals(parser_next(parser), LEX_LPAREN))
+	if (stack->size == stack->capacity)
 	{
-		func->value.type = TOKEN_FUNC;
-		bintree_t arg = parse_expr_of_prior(parser, 0);
-		if (arg)
+		size_t capacity = (stack->capacity) ? 2 * stack->capacity
+		                                    : PARSER_STACK_INIT_CAPACITY;
+		void* check = realloc(stack->frames, capacity * sizeof *stack->frames);
+		if (!check)
 		{
-			if (lexeme_equals(parser_next(parser), LEX_RPAREN))
-			{
-				bintree_t root = create_func_node(func, arg);
-				if (root)
-					return root;
-			}
-
-			parser_error(parser, "Expected ')'");
+			fputs("Cannot allocate memory for parser stack.\n\n", stderr);
+			return false;
 		}
 
-		bintree_destroy(arg);
+		stack->frames   = (struct parser_frame*) check;
+		stack->capacity = capacity;
 	}
 
-	bintree_destroy(func);
-	parser_restore(parser, pos);
-	return NULL;
+	stack->frames[stack->size++] = frame;
+	return true;
 }
 
 /*!
- * @brief Parse factor.
- *
- * factor ::= {'(' expr_0 ')'} | function | ident | number
- *
- * @return Parsed tree.
+ * @brief Destroy unfinished constructions and free the parser stack.
  */
-bintree_t parse_factor
+static void parser_stack_destroy
 (
-	parser_t* parser /*!< [in,out] parser state.                             */
+	struct parser_stack* stack /*!< [in,out] parser stack.                   */
 )
 {
-	size_t          pos    = parser_get_pos(parser);
-	const lexeme_t* lexeme = parser_next(parser);
-	if (lexeme_equals(lexeme, LEX_LPAREN))
+	for (size_t i = 0; i < stack->size; ++i)
 	{
-		bintree_t root = parse_expr_of_prior(parser, 0);
-		if (root)
-		{
-			lexeme = parser_next(parser);
-			if (lexeme_equals(lexeme, LEX_RPAREN))
-				return root;
+		bintree_destroy(stack->frames[i].node);
+		token_destroy(&stack->frames[i].op);
+	}
 
-			parser_error(parser, "Expected ')'");
-		}
+	free(stack->frames);
+	stack->frames   = NULL;
+	stack->size     = 0;
+	stack->capacity = 0;
+}
 
-		bintree_destroy(root);
-		parser_restore(parser, pos);
-		return NULL;
-	}
+/*!
+ * @brief Finish binary operations on the top of the stack
+ * whose priority isn't lower than given one.
+ *
+ * @return Tree with finished operations or NULL if an error occurred.
+ */
+static bintree_t parser_reduce
+(
+	struct parser_stack* stack, /*!< [in,out] parser stack.                  */
+	bintree_t            root,  /*!< [in,out] right operand of the last
+	                                          operation.                     */
+	int                  prior  /*!< [in]     the lowest finished priority.  */
+)
+{
+	while (root && stack->size)
+	{
+		struct parser_frame* top = &stack->frames[stack->size - 1];
+		if (top->kind != PARSER_FRAME_BINOP || top->prior < prior)
+			break;
 
-	parser_restore(parser, pos);
-	bintree_t root = parse_function(parser);
-	if (root)
-		return root;
+		--stack->size;
+		root = create_binop_node(top->node, root, top->op);
+	}
 
-	parser_restore(parser, pos);
-	root = parse_ident(parser);
-	if (root)
-		return root;
+	return root;
+}
 
-	parser_restore(parser, pos);
-	root = parse_number(parser);
-	if (root)
+/*!
+ * @brief Finish factor applying prefix operation which is before it.
+ *
+ * @return Finished term or NULL if an error occurred.
+ */
+static bintree_t parser_finish_factor
+(
+	struct parser_stack* stack, /*!< [in,out] parser stack.                  */
+	bintree_t            root   /*!< [in,out] parsed factor.                 */
+)
+{
+	if (!root || !stack->size
+	    || stack->frames[stack->size - 1].kind != PARSER_FRAME_PREFIX)
 		return root;
 
-	parser_error(parser, "Invalid sequence %.*s",
-	             (int) lexeme->length, lexeme->ptr);
-	parser_restore(parser, pos);
-	return NULL;
+	--stack->size;
+	return create_prefunop_node(root, stack->frames[stack->size].op);
 }
 
 /*!
- * @brief Parse term.
+ * @brief Parse the beginning of term.
  *
- * term ::= ['+' '-']? factor
+ * term     ::= ['+' '-']? factor
+ * factor   ::= {'(' expr_0 ')'} | function | ident | number
+ * function ::= ident '(' expr_0 ')'
  *
- * @return Parsed tree.
+ * Prefix operations, brackets and functions are pushed to the stack
+ * until their operands are parsed. Kind of operand is known by its first
+ * lexeme and the next one, so nothing is parsed twice.
+ *
+ * @return Success of parsing.
  */
-static bintree_t parse_term
+static bool parse_operand
 (
-	parser_t* parser /*!< [in,out] parsing state.                            */
+	parser_t*            parser, /*!< [in,out] parser state.                 */
+	struct parser_stack* stack,  /*!< [in,out] parser stack.                 */
+	bintree_t*           leaf    /*!< [out]    parsed identifier or number,
+	                                           NULL if frame was pushed.     */
 )
 {
-	size_t          pos        = parser_get_pos(parser);
-	const lexeme_t* lexeme     = parser_next(parser);
-	bool            has_prefix = false;
-	if (lexeme_equals(lexeme, LEX_PLUS)
-	    || lexeme_equals(lexeme, LEX_MINUS))
-		has_prefix = true;
-	else
-		parser_restore(parser, pos);
+	struct parser_frame frame  = {PARSER_FRAME_PAREN,
+	                              {.type = TOKEN_UNKNOWN, .value.number = 0},
+	                              0, BINTREE_NULL};
+	bool                prefix = stack->size && stack->frames[stack->size - 1]
+	                             .kind == PARSER_FRAME_PREFIX;
+	size_t              pos    = parser_get_pos(parser);
+	const lexeme_t*     lexeme = parser_next(parser);
+
+	*leaf = BINTREE_NULL;
+	switch (lexeme->type)
+	{
+		case LEXEME_LPAREN:
+			return parser_stack_push(stack, frame);
 
-	bintree_t root = parse_factor(parser);
-	if (has_prefix)
-		root = create_prefunop_node(root, lexeme_to_token(lexeme));
+		case LEXEME_NUMBER:
+			*leaf = parse_number(lexeme);
+			return *leaf;
 
-	if (!root)
-		parser_restore(parser, pos);
+		case LEXEME_IDENT:
+			if (parser_peek(parser)->type != LEXEME_LPAREN)
+			{
+				*leaf = parse_ident(lexeme, false);
+				return *leaf;
+			}
 
-	return root;
+			parser_next(parser);
+			frame.kind = PARSER_FRAME_FUNC;
+			frame.node = parse_ident(lexeme, true);
+			if (frame.node && parser_stack_push(stack, frame))
+				return true;
+
+			bintree_destroy(frame.node);
+			return false;
+
+		case LEXEME_OP:
+			// Only one prefix operation can be before factor.
+			if (!prefix && (lexeme_equals(lexeme, LEX_PLUS)
+			                || lexeme_equals(lexeme, LEX_MINUS)))
+			{
+				frame.kind = PARSER_FRAME_PREFIX;
+				frame.op   = lexeme_to_token(lexeme);
+				return parser_stack_push(stack, frame);
+			}
+
+			break;
+
+		case LEXEME_RPAREN:
+		case LEXEME_EOF:
+		case LEXEME_UNKNOWN:
+		default:
+			break;
+	}
+
+	parser_error_at(parser, pos, "Invalid sequence %.*s",
+	                (int) lexeme->length, lexeme->ptr);
+	return false;
 }
 
 /*!
- * @brief Parse expr_<prior> where <prior> is the priority of operation
- * and move string pointer.
+ * @brief Parse expr_0 and move string pointer.
  *
  * expr_0 ::= expr_1 {['+' '-'] expr_1}*
  * expr_1 ::= expr_2 {['*' '/'] expr_2}*
  * expr_2 ::= term {'^' term}*
  *
+ * Unfinished constructions are kept in the stack instead of recursion,
+ * so depth of nesting is limited only by memory.
+ *
  * @return Parsed tree.
  */
-static bintree_t parse_expr_of_prior
+static bintree_t parse_expr_0
 (
-	parser_t* parser, /*!< [in,out] parser state.                            */
-	int       prior   /*!< [in]     priority of current parsed operations.   */
+	parser_t*            parser, /*!< [in,out] parser state.                 */
+	struct parser_stack* stack   /*!< [in,out] empty parser stack.           */
 )
 {
-	if (prior >= PARSER_MAX_PRIOR)
-		return parse_term(parser);
+	bintree_t root = BINTREE_NULL;
+	while (true)
+	{
+		if (!root)
+		{
+			bintree_t leaf = BINTREE_NULL;
+			if (!parse_operand(parser, stack, &leaf))
+				return BINTREE_NULL;
 
-	bintree_t root = parse_expr_of_prior(parser, prior + 1);
-	if (!root)
-		return NULL;
+			if (leaf && !(root = parser_finish_factor(stack, leaf)))
+				return BINTREE_NULL;
 
-	size_t          pos    = parser_get_pos(parser);
-	const lexeme_t* lexeme;
-	while (get_priority(lexeme = parser_next(parser)) == prior)
-	{
-		root = create_binop_node(root, parse_expr_of_prior(parser, prior + 1),
-		                         lexeme_to_token(lexeme));
+			continue;
+		}
+
+		const lexeme_t* lexeme = parser_peek(parser);
+		int             prior  = get_priority(lexeme);
+		if (prior >= 0)
+		{
+			parser_next(parser);
+
+			// All operations are left-associative.
+			root = parser_reduce(stack, root, prior);
+			struct parser_frame frame = {PARSER_FRAME_BINOP,
+			                             lexeme_to_token(lexeme), prior, root};
+			if (!root || !parser_stack_push(stack, frame))
+				return bintree_destroy(root);
+
+			root = BINTREE_NULL;
+			continue;
+		}
+
+		root = parser_reduce(stack, root, 0);
 		if (!root)
+			return BINTREE_NULL;
+
+		if (!stack->size)
+			return root;
+
+		// Only brackets and functions are left on the top of the stack.
+		if (parser_next(parser)->type != LEXEME_RPAREN)
 		{
-			parser_restore(parser, pos);
-			return NULL;
+			parser_error(parser, "Expected ')'");
+			return bintree_destroy(root);
 		}
 
-		pos = parser_get_pos(parser);
-	}
+		struct parser_frame top = stack->frames[--stack->size];
+		if (top.kind == PARSER_FRAME_FUNC)
+			root = create_func_node(top.node, root);
 
-	parser_restore(parser, pos);
-	return root;
+		if (!(root = parser_finish_factor(stack, root)))
+			return BINTREE_NULL;
+	}
 }
 
 
@@ -598,9 +957,11 @@ bintree_t parse_expr (parser_t* parser)
 {
 	assert (parser);
 
-	bintree_t root = parse_expr_of_prior(parser, 0);
+	struct parser_stack stack = {NULL, 0, 0};
+	bintree_t           root  = parse_expr_0(parser, &stack);
+	parser_stack_destroy(&stack);
 	if (!root)
-		return NULL;
+		return BINTREE_NULL;
 
 	if (lexeme_equals(parser_next(parser), LEX_EOF))
 		return root;
@@ -615,21 +976,48 @@ bool parser_init (parser_t* parser, const char* str)
 	assert (parser);
 	assert (str);
 
-	parser->pos   = 0;
-	parser->lines = (const char**) split_by_delim(str, '\n');
-	if (!parser->lines)
+	parser_start(parser, str, str + strlen(str));
+	return true;
+}
+
+
+bool parser_init_file (parser_t* parser, FILE* stream)
+{
+	assert (parser);
+	assert (stream);
+
+	// Stream could be read partially, so its position is taken into account.
+	struct stat info   = {0};
+	off_t       offset = ftello(stream);
+	int         fd     = fileno(stream);
+	if (fd >= 0 && offset >= 0 && !fstat(fd, &info)
+	    && S_ISREG(info.st_mode) && info.st_size > offset)
 	{
-		fputs("Cannot create list of strings.\n\n", stderr);
-		return false;
+		size_t size = (size_t) info.st_size;
+		void*  map  = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED)
+		{
+			madvise(map, size, MADV_SEQUENTIAL);
+			parser_start(parser, (const char*) map + offset,
+			             (const char*) map + size);
+			parser->map      = map;
+			parser->map_size = size;
+			return true;
+		}
 	}
 
-	parser->lexemes = split_to_lexemes(parser->lines);
-	if (!parser->lexemes)
+	// Other streams are read when lexer reaches the end of buffer.
+	char* buffer = (char*) malloc(PARSER_CHUNK_SIZE);
+	if (!buffer)
 	{
-		free(parser->lines);
+		fputs("Cannot allocate memory for input.\n\n", stderr);
 		return false;
 	}
 
+	parser_start(parser, buffer, buffer);
+	parser->buffer     = buffer;
+	parser->buffer_cap = PARSER_CHUNK_SIZE;
+	parser->stream     = stream;
 	return true;
 }
 
@@ -638,11 +1026,11 @@ void parser_deinit (parser_t* parser)
 {
 	assert (parser);
 
-	free(parser->lines);
-	free(parser->lexemes);
-	parser->lines   = NULL;
-	parser->lexemes = NULL;
-	parser->pos     = 0;
+	if (parser->map)
+		munmap(parser->map, parser->map_size);
+
+	free(parser->buffer);
+	parser_start(parser, NULL, NULL);
 }
 
 
@@ -650,7 +1038,7 @@ const lexeme_t* parser_next (parser_t* parser)
 {
 	assert (parser);
 	
-	lexeme_t* ret = &parser->lexemes[parser->pos];
+	const lexeme_t* ret = parser_lexeme(parser, parser->pos);
 	if (ret->type != LEXEME_EOF)
 		++parser->pos;
 
@@ -658,12 +1046,41 @@ const lexeme_t* parser_next (parser_t* parser)
 }
 
 
-const lexeme_t* parser_restore (parser_t* parser, size_t pos)
+const lexeme_t* parser_peek (parser_t* parser)
+{
+	assert (parser);
+
+	return parser_lexeme(parser, parser->pos);
+}
+
+
+const lexeme_t* parser_lexeme (parser_t* parser, size_t pos)
 {
 	assert (parser);
+	assert (pos + PARSER_WINDOW >= parser->lexed);
+
+	while (parser->lexed <= pos)
+		parser_lex(parser);
+
+	return &parser->window[pos % PARSER_WINDOW];
+}
+
+
+void parser_print_line (const parser_t* parser, const lexeme_t* lexeme)
+{
+	assert (parser);
+	assert (lexeme);
 
-	parser->pos = (pos <= parser->pos) ? pos : parser->pos;
-	return &parser->lexemes[parser->pos];
+	// The new line character is printed too if line has it.
+	// Beginning of line could be dropped from the buffer already.
+	size_t      before = (size_t) (lexeme->ptr - parser->begin);
+	const char* line   = lexeme->ptr - ((lexeme->pos < before)
+	                                    ? lexeme->pos : before);
+	const char* finish = (const char*) memchr(line, '\n', (size_t)
+	                                          (parser->end - line));
+	int         length = (finish) ? (int) (finish - line) + 1
+	                              : (int) (parser->end - line);
+	fprintf(stderr, "%.*s\n", length, line);
 }
 
 
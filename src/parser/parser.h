@@ -10,6 +10,8 @@
 
 #include "../tree/bintree.h"
 
+#include <stdio.h>
+
 
 
 /*!
@@ -37,27 +39,58 @@ typedef struct
 	unsigned      length; /*!< length of the lexeme..                        */
 	unsigned      line;   /*!< number of line where lexeme locates.          */
 	unsigned      pos;    /*!< position in line where lexeme locates.        */
+	double        number; /*!< value of number lexeme.                       */
 }
 lexeme_t;
 
+/*!
+ * @brief Amount of the last lexemes which parser keeps.
+ */
+#define PARSER_WINDOW 2
+
 /*!
  * @brief Structure which shows parsing state.
+ *
+ * Lexemes are produced when parser needs them and only the last
+ * PARSER_WINDOW of them are kept, so parser takes constant memory
+ * in addition to its input. Stream which can't be mapped is read
+ * by chunks, only characters of the kept lexemes and of the lexeme
+ * being lexed stay in the buffer.
  */
 typedef struct
 {
-	lexeme_t*    lexemes; /*!< array of lexemes                              */
-	const char** lines;   /*!< array of lines.                               */
-	size_t             pos;     /*!< last parsed lexeme.                     */
+	const char* cur;                   /*!< the first character which isn't
+	                                        lexed.                           */
+	const char* end;                   /*!< end of input.                    */
+	unsigned    line;                  /*!< line of current character.       */
+	unsigned    line_pos;              /*!< position of current character
+	                                        in line.                         */
+	lexeme_t    window[PARSER_WINDOW]; /*!< the last lexemes.                */
+	size_t      lexed;                 /*!< amount of lexed lexemes.         */
+	size_t      pos;                   /*!< last parsed lexeme.              */
+	bool        failed;                /*!< lexical error was reported.      */
+	const char* begin;                 /*!< the first character which is
+	                                        still available.                 */
+	char*       buffer;                /*!< input which was read or NULL.    */
+	size_t      buffer_cap;            /*!< capacity of buffer.              */
+	FILE*       stream;                /*!< stream which is read by chunks
+	                                        or NULL if it is over.           */
+	void*       map;                   /*!< mapped input file or NULL.       */
+	size_t      map_size;              /*!< size of mapped input file.       */
 }
 parser_t;
 
 
 
 /*!
- * @brief Parse an expression using recursive descent parsing.
+ * @brief Parse an expression using operator precedence parsing.
  *
  * expression ::= expr_0 '\0'
  *
+ * @note Tree doesn't refer to the input, identifiers are interned in the
+ * symbol table. So the tree stays valid after parser_deinit() until
+ * symbol_table_destroy() is called.
+ *
  * @return Expression tree or NULL if an error was occurred.
  */
 bintree_t parse_expr
@@ -68,7 +101,7 @@ bintree_t parse_expr
 /*!
  * @brief Initialize parser using input string.
  *
- * @note Don't forget to free memory using parser_deinit().
+ * @note String should live until parser_deinit() is called.
  *
  * @return Success of initialization.
  */
@@ -78,6 +111,24 @@ bool parser_init
 	const char* str     /*!< [in]  initial string.                           */
 );
 
+/*!
+ * @brief Initialize parser using the rest of input stream.
+ *
+ * Regular files are mapped to memory instead of reading, other streams
+ * are read by chunks while they are lexed.
+ *
+ * @note Stream should live until parser_deinit() is called.
+ *
+ * @note Don't forget to free memory using parser_deinit().
+ *
+ * @return Success of initialization.
+ */
+bool parser_init_file
+(
+	parser_t* parser, /*!< [out]    parser of initialization.                */
+	FILE*     stream  /*!< [in,out] input stream.                            */
+);
+
 /*!
  * @brief Free memory that parser uses.
  */
@@ -95,12 +146,31 @@ const lexeme_t* parser_next
 );
 
 /*!
- * @brief Get prev lexeme.
+ * @brief Get next lexeme without moving to it.
  */
-const lexeme_t* parser_restore
+const lexeme_t* parser_peek
+(
+	parser_t* parser /*!< [in,out] parser state.                             */
+);
+
+/*!
+ * @brief Get lexeme by its position.
+ *
+ * @note Only the last PARSER_WINDOW lexemes are available.
+ */
+const lexeme_t* parser_lexeme
 (
 	parser_t* parser, /*!< [in,out] parser state.                            */
-	size_t    pos     /*!< [in] restored position.                           */
+	size_t    pos     /*!< [in]     lexeme position.                         */
+);
+
+/*!
+ * @brief Print line which contains given lexeme to stderr.
+ */
+void parser_print_line
+(
+	const parser_t* parser, /*!< [in] parser state.                          */
+	const lexeme_t* lexeme  /*!< [in] lexeme.                                */
 );
 
 /*!
@@ -146,16 +216,20 @@ bool iskey
 
 /*!
  * @brief Print syntax error using given format string and lexeme position.
+ *
+ * @note Nothing is printed after a lexical error, it is already reported.
  */
 #define parser_error_at(PARSER_, POS_, ...) \
 do \
 { \
-	const lexeme_t* LEX_ = (PARSER_)->lexemes + (POS_); \
-	fprintf(stderr, "%u:%u: ", LEX_->line, LEX_->pos); \
-	fprintf(stderr, __VA_ARGS__); \
-	fputc('\n', stderr); \
-	fputs((PARSER_)->lines[LEX_->line], stderr); \
-	fputc('\n', stderr); \
+	const lexeme_t* LEX_ = parser_lexeme(PARSER_, POS_); \
+	if (!(PARSER_)->failed) \
+	{ \
+		fprintf(stderr, "%u:%u: ", LEX_->line, LEX_->pos); \
+		fprintf(stderr, __VA_ARGS__); \
+		fputc('\n', stderr); \
+		parser_print_line(PARSER_, LEX_); \
+	} \
 } \
 while (false)
 
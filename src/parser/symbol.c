@@ -0,0 +1,227 @@
+/*!
+ * @file
+ * @brief Implementation of the table of interned identifiers.
+ */
+
+#include "symbol.h"
+#include "../utilities/utilities.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Names of predefined symbols in order of their ids.
+ */
+static const char* const PREDEFINED_SYMBOLS[SYMBOLS_PREDEFINED_AMOUNT] =
+{
+	"x",
+	"e",
+	"pi",
+	"sin",
+	"cos",
+	"tg",
+	"ctg",
+	"ln",
+};
+
+/*!
+ * @brief Table of interned symbols.
+ *
+ * @note Symbols are interned by parsers of several threads,
+ * so the table is used only under the lock.
+ */
+static struct
+{
+	char**    names;     /*!< names of symbols by their ids.                 */
+	size_t    size;      /*!< amount of symbols.                             */
+	size_t    capacity;  /*!< capacity of names array.                       */
+	symbol_t* table;     /*!< hash table of symbols.                         */
+	size_t    table_cap; /*!< capacity of hash table (power of 2).           */
+}
+symbols = {NULL, 0, 0, NULL, 0};
+
+/*!
+ * @brief Lock of the symbol table.
+ */
+static pthread_mutex_t symbols_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+
+/*!
+ * @brief Find place of symbol in hash table.
+ *
+ * @return Index of the symbol or of the empty cell where it should be placed.
+ */
+static size_t symbol_find
+(
+	const char* name, /*!< [in] name of symbol.                              */
+	size_t      len   /*!< [in] length of name.                              */
+)
+{
+	size_t mask  = symbols.table_cap - 1;
+	size_t index = hash_bytes(name, len) & mask;
+	while (symbols.table[index] != SYMBOL_NONE)
+	{
+		const char* curr = symbols.names[symbols.table[index]];
+		if (!strncmp(curr, name, len) && !curr[len])
+			return index;
+
+		index = (index + 1) & mask;
+	}
+
+	return index;
+}
+
+/*!
+ * @brief Increase capacity of hash table twice and rehash all symbols.
+ *
+ * @return Success of growing.
+ */
+static bool symbol_table_grow (void)
+{
+	size_t    capacity = (symbols.table_cap) ? symbols.table_cap * 2 : 64;
+	symbol_t* table    = (symbol_t*) malloc(capacity * sizeof *table);
+	if (!table)
+		return false;
+
+	memset(table, 0xFF, capacity * sizeof *table);
+	free(symbols.table);
+	symbols.table     = table;
+	symbols.table_cap = capacity;
+	for (size_t i = 0; i < symbols.size; ++i)
+	{
+		const char* name = symbols.names[i];
+		size_t      len  = strlen(name);
+		symbols.table[symbol_find(name, len)] = (symbol_t) i;
+	}
+
+	return true;
+}
+
+/*!
+ * @brief Add new symbol to the table.
+ *
+ * @return Added symbol or SYMBOL_NONE if an error occurred.
+ */
+static symbol_t symbol_add
+(
+	const char* name, /*!< [in] name of symbol.                              */
+	size_t      len   /*!< [in] length of name.                              */
+)
+{
+	if ((symbols.size + 1) * 2 > symbols.table_cap && !symbol_table_grow())
+		return SYMBOL_NONE;
+
+	if (symbols.size == symbols.capacity)
+	{
+		size_t capacity = (symbols.capacity) ? symbols.capacity * 2 : 64;
+		void*  check    = realloc(symbols.names,
+		                          capacity * sizeof *symbols.names);
+		if (!check)
+			return SYMBOL_NONE;
+
+		symbols.names    = (char**) check;
+		symbols.capacity = capacity;
+	}
+
+	char* copy = (char*) malloc(len + 1);
+	if (!copy)
+		return SYMBOL_NONE;
+
+	memcpy(copy, name, len);
+	copy[len] = '\0';
+
+	symbol_t symbol = (symbol_t) symbols.size++;
+	symbols.names[symbol] = copy;
+	symbols.table[symbol_find(name, len)] = symbol;
+	return symbol;
+}
+
+/*!
+ * @brief Free memory of the symbol table without locking it.
+ */
+static void symbol_table_free (void)
+{
+	for (size_t i = 0; i < symbols.size; ++i)
+		free(symbols.names[i]);
+
+	free(symbols.names);
+	free(symbols.table);
+	symbols.names     = NULL;
+	symbols.size      = 0;
+	symbols.capacity  = 0;
+	symbols.table     = NULL;
+	symbols.table_cap = 0;
+}
+
+/*!
+ * @brief Intern predefined symbols if it wasn't done.
+ *
+ * @return Success of initialization.
+ */
+static bool symbol_table_init (void)
+{
+	if (symbols.size)
+		return true;
+
+	for (size_t i = 0; i < SYMBOLS_PREDEFINED_AMOUNT; ++i)
+	{
+		const char* name = PREDEFINED_SYMBOLS[i];
+		if (symbol_add(name, strlen(name)) == SYMBOL_NONE)
+		{
+			symbol_table_free();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+
+symbol_t symbol_intern (const char* name, size_t len)
+{
+	assert (name);
+
+	pthread_mutex_lock(&symbols_lock);
+	symbol_t symbol = SYMBOL_NONE;
+	if (symbol_table_init())
+	{
+		symbol = symbols.table[symbol_find(name, len)];
+		if (symbol == SYMBOL_NONE)
+			symbol = symbol_add(name, len);
+	}
+
+	pthread_mutex_unlock(&symbols_lock);
+	return symbol;
+}
+
+
+const char* symbol_name (symbol_t symbol)
+{
+	if (symbol < SYMBOLS_PREDEFINED_AMOUNT)
+		return PREDEFINED_SYMBOLS[symbol];
+
+	// Names array is moved when the table grows, names themselves aren't.
+	pthread_mutex_lock(&symbols_lock);
+	assert (symbol < symbols.size);
+	const char* name = symbols.names[symbol];
+	pthread_mutex_unlock(&symbols_lock);
+	return name;
+}
+
+
+void symbol_table_destroy (void)
+{
+	pthread_mutex_lock(&symbols_lock);
+	symbol_table_free();
+	pthread_mutex_unlock(&symbols_lock);
+}
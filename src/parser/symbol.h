@@ -0,0 +1,79 @@
+/*!
+ * @file
+ * @brief Header of the table of interned identifiers.
+ *
+ * Every identifier is kept once and tokens refer to it by small integer id,
+ * so copying of identifiers is free and comparison is an integer compare.
+ */
+
+#ifndef SYMBOL_H_
+#define SYMBOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+
+/*!
+ * @brief Identifier of interned symbol.
+ */
+typedef uint32_t symbol_t;
+
+/*!
+ * @brief Symbols which are always interned.
+ */
+enum predefined_symbols
+{
+	SYMBOL_X   = 0, //!< variable of differentiation.
+	SYMBOL_E   = 1, //!< base of natural logarithm.
+	SYMBOL_PI  = 2, //!< pi number.
+	SYMBOL_SIN = 3, //!< sine.
+	SYMBOL_COS = 4, //!< cosine.
+	SYMBOL_TG  = 5, //!< tangent.
+	SYMBOL_CTG = 6, //!< cotangent.
+	SYMBOL_LN  = 7, //!< natural logarithm.
+	SYMBOLS_PREDEFINED_AMOUNT
+};
+
+/*!
+ * @brief Value which doesn't refer to any symbol.
+ */
+#define SYMBOL_NONE ((symbol_t) UINT32_MAX)
+
+
+
+/*!
+ * @brief Find symbol with given name or add it to the table.
+ *
+ * @note Table is shared by all threads and locked while it is used.
+ *
+ * @return Symbol or SYMBOL_NONE if an error occurred.
+ */
+symbol_t symbol_intern
+(
+	const char* name, /*!< [in] name of symbol, it may be not null-terminated.*/
+	size_t      len   /*!< [in] length of name.                              */
+);
+
+/*!
+ * @brief Get name of symbol.
+ *
+ * @return Null-terminated name of symbol.
+ */
+const char* symbol_name
+(
+	symbol_t symbol /*!< [in] symbol.                                        */
+);
+
+/*!
+ * @brief Free memory of the symbol table.
+ *
+ * @note All symbols except predefined ones become invalid, so it is called
+ * when no other thread uses symbols.
+ */
+void symbol_table_destroy (void);
+
+
+
+
+#endif // not defined SYMBOL_H_
@@ -4,8 +4,10 @@
  */
 
 #include "token.h"
+#include "../utilities/utilities.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -36,8 +38,6 @@ static const size_t TOKEN_TYPES_LEN[] =
 
 /*!
  * @brief Parse value of token type.
- 
- @note Function may use memory allocation.
  *
  * @return Success of the parsing process.
  */
@@ -59,12 +59,9 @@ static bool token_parse_value
 
 		case TOKEN_VAR:
 		case TOKEN_FUNC:
-			token->value.ident = (char*) calloc(len + 1, 1);
-			if (!token->value.ident)
-				return false;
-
-			memcpy(token->value.ident, str, len);
-			return true;
+			token->value.ident = symbol_intern(str, len);
+			token->func        = token_function_id(token->value.ident);
+			return token->value.ident != SYMBOL_NONE;
 
 		case TOKEN_UNKNOWN:
 		default:
@@ -75,6 +72,34 @@ static bool token_parse_value
 
 
 
+function_t token_function_id (symbol_t name)
+{
+	// Builtin functions are predefined symbols in the same order.
+	if (name >= SYMBOL_SIN && name < SYMBOL_SIN + FUNCTIONS_BUILTIN_AMOUNT)
+		return (function_t) (name - SYMBOL_SIN);
+
+	return FUNC_USER;
+}
+
+
+double operation_calculate (operation_t op, double lhs, double rhs)
+{
+	switch (op)
+	{
+		case OP_PLUS:  return lhs + rhs;
+		case OP_MINUS: return lhs - rhs;
+		case OP_MUL:   return lhs * rhs;
+		case OP_DIV:   return lhs / rhs;
+		case OP_POW:   return pow(lhs, rhs);
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			return NAN;
+	}
+}
+
+
 bool token_parse (token_t* token, const char* str, size_t len)
 {
 	assert (token);
@@ -119,7 +144,7 @@ bool token_equal (const token_t* t1, const token_t* t2)
 
 		case TOKEN_FUNC:
 		case TOKEN_VAR:
-			return strcmp(t1->value.ident, t2->value.ident) == 0;
+			return t1->value.ident == t2->value.ident;
 
 		case TOKEN_UNKNOWN:
 		default:
@@ -128,6 +153,37 @@ bool token_equal (const token_t* t1, const token_t* t2)
 }
 
 
+size_t token_hash (const token_t* t)
+{
+	assert (t);
+
+	size_t hash = (size_t) t->type;
+	switch (t->type)
+	{
+		case TOKEN_NUMBER:
+		{
+			// 0.0 and -0.0 are equal so they must have the same hash.
+			double number = t->value.number;
+			if (!(number < 0) && !(number > 0))
+				number = 0;
+
+			return hash_combine(hash, hash_bytes(&number, sizeof number));
+		}
+
+		case TOKEN_OP:
+			return hash_combine(hash, (size_t) t->value.operation);
+
+		case TOKEN_FUNC:
+		case TOKEN_VAR:
+			return hash_combine(hash, (size_t) t->value.ident);
+
+		case TOKEN_UNKNOWN:
+		default:
+			return hash;
+	}
+}
+
+
 void token_print (const token_t* t, FILE* output)
 {
 	assert (t);
@@ -148,7 +204,7 @@ void token_print (const token_t* t, FILE* output)
 
 		case TOKEN_FUNC:
 		case TOKEN_VAR:
-			fputs(t->value.ident, output);
+			fputs(symbol_name(t->value.ident), output);
 			break;
 
 		case TOKEN_UNKNOWN:
@@ -165,21 +221,8 @@ void token_destroy (token_t* t)
 	if (!t)
 		return;
 
-	switch (t->type)
-	{
-		case TOKEN_FUNC:
-		case TOKEN_VAR:
-			free(t->value.ident);
-			break;
-
-		case TOKEN_NUMBER:
-		case TOKEN_OP:
-		case TOKEN_UNKNOWN:
-		default:
-			break;
-	}
-
-	t->value.ident = NULL;
+	t->type         = TOKEN_UNKNOWN;
+	t->value.number = 0;
 }
 
 
@@ -188,30 +231,8 @@ bool token_copy (token_t* dest, const token_t* src)
 	assert (dest);
 	assert (src);
 
-	switch (dest->type = src->type)
-	{
-		case TOKEN_NUMBER:
-			dest->value.number = src->value.number;
-			return true;
-
-		case TOKEN_OP:
-			dest->value.operation = src->value.operation;
-			return true;
-
-		case TOKEN_FUNC:
-		case TOKEN_VAR:
-			dest->value.ident = (char*) realloc(dest->value.ident,
-			                                    strlen(src->value.ident) + 1);
-			if (!dest->value.ident)
-				return false;
-
-			strcpy(dest->value.ident, src->value.ident);
-			return true;
-
-		case TOKEN_UNKNOWN:
-		default:
-			return true;
-	}
+	*dest = *src;
+	return true;
 }
 
 
@@ -220,11 +241,8 @@ bool token_move (token_t* dest, token_t* src)
 	assert (dest);
 	assert (src);
 
-	token_destroy(dest);
-	dest->type       = src->type;
-	dest->value      = src->value;
-	src->type        = TOKEN_UNKNOWN;
-	src->value.ident = NULL;
+	*dest = *src;
+	token_destroy(src);
 
 	return true;
 }
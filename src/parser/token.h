@@ -9,6 +9,8 @@
 
 
 
+#include "symbol.h"
+
 #include <stdio.h>
 #include <stdbool.h>
 
@@ -42,13 +44,32 @@ typedef enum
 }
 operation_t;
 
+/*!
+ * @brief List of functions.
+ */
+typedef enum
+{
+	FUNC_SIN  = 0, //!< sine.
+	FUNC_COS  = 1, //!< cosine.
+	FUNC_TG   = 2, //!< tangent.
+	FUNC_CTG  = 3, //!< cotangent.
+	FUNC_LN   = 4, //!< natural logarithm.
+	FUNC_USER = 5, //!< function which isn't builtin.
+}
+function_t;
+
+/*!
+ * @brief Amount of builtin functions.
+ */
+#define FUNCTIONS_BUILTIN_AMOUNT ((size_t) FUNC_USER)
+
 /*!
  * @brief Possible values of token.
  */
 typedef union
 {
 	double      number;    //!< number field.
-	char*       ident;     //!< identifier field.
+	symbol_t    ident;     //!< identifier field.
 	operation_t operation; //!< operation field.
 }
 token_value_t;
@@ -59,12 +80,35 @@ token_value_t;
 typedef struct
 {
 	token_type_t  type;  /*!< type of the token.                             */
+	function_t    func;  /*!< function id if the token is a function.        */
 	token_value_t value; /*!< value of the token.                            */
 }
 token_t;
 
 
 
+/*!
+ * @brief Find function id by function name.
+ *
+ * @return Function id or FUNC_USER if function isn't builtin.
+ */
+function_t token_function_id
+(
+	symbol_t name /*!< [in] function name.                                   */
+);
+
+/*!
+ * @brief Calculate result of binary operation.
+ *
+ * @return Result or NaN if operation can't be calculated.
+ */
+double operation_calculate
+(
+	operation_t op,  /*!< [in] operation.                                    */
+	double      lhs, /*!< [in] left operand.                                 */
+	double      rhs  /*!< [in] right operand.                                */
+);
+
 /*!
  * @brief Parse token from string which has format TYPE(VALUE)
  *
@@ -88,6 +132,16 @@ bool token_equal
 	const token_t* t2  /*!< [in] second token.                               */
 );
 
+/*!
+ * @brief Calculate hash of token which is consistent with token_equal().
+ *
+ * @return Hash value.
+ */
+size_t token_hash
+(
+	const token_t* t /*!< [in] token.                                        */
+);
+
 /*!
  * @brief Print token.
  */
@@ -99,6 +153,9 @@ void token_print
 
 /*!
  * @brief Destroy token and free memory.
+ *
+ * @note Tokens don't own memory since identifiers are interned,
+ * so it only makes token empty.
  */
 void token_destroy
 (
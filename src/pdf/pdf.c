@@ -0,0 +1,156 @@
+/*!
+ * @file
+ * @brief Implementation of building pdf file from tex file.
+ */
+
+// posix_spawn() and waitpid() aren't a part of strict C11 environment.
+#ifndef _DEFAULT_SOURCE
+#	define _DEFAULT_SOURCE
+#endif
+
+#include "pdf.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+
+
+
+extern char** environ;
+
+/*!
+ * @brief Running build of pdf file.
+ */
+struct pdf_build
+{
+	pid_t pid;      /*!< process of pdflatex.                                */
+	bool  finished; /*!< process has been waited for.                        */
+	int   status;   /*!< exit status of finished process.                    */
+};
+
+
+
+
+/*!
+ * @brief Wait for process of build and save its exit status.
+ */
+static void pdf_build_reap
+(
+	pdf_build_t build,  /*!< [in,out] running build.                         */
+	int         options /*!< [in]     options of waitpid().                  */
+)
+{
+	int   status = 0;
+	pid_t pid    = waitpid(build->pid, &status, options);
+	if (pid == 0 || (pid < 0 && errno == EINTR))
+		return;
+
+	build->finished = true;
+	build->status   = (pid == build->pid && WIFEXITED(status))
+	                  ? WEXITSTATUS(status) : -1;
+}
+
+
+
+
+pdf_build_t pdf_build_start (const char* path)
+{
+	assert (path);
+
+	pdf_build_t build = (pdf_build_t) calloc(1, sizeof *build);
+	if (!build)
+	{
+		fputs("Cannot allocate memory for pdf build.\n\n", stderr);
+		return NULL;
+	}
+
+	// Arguments of new process aren't constant. Pdf file is placed
+	// next to tex file instead of the current directory.
+	size_t length    = strlen(path);
+	char*  file      = (char*) malloc(length + 1);
+	char*  directory = (char*) malloc(length + sizeof "-output-directory=.");
+	if (!file || !directory)
+	{
+		fputs("Cannot allocate memory for pdf build.\n\n", stderr);
+		free(directory);
+		free(file);
+		free(build);
+		return NULL;
+	}
+
+	memcpy(file, path, length + 1);
+	const char* slash = strrchr(path, '/');
+	if (!slash)
+		strcpy(directory, "-output-directory=.");
+	else
+	{
+		size_t dir_length = (slash == path) ? 1 : (size_t) (slash - path);
+		strcpy(directory, "-output-directory=");
+		strncat(directory, path, dir_length);
+	}
+
+	// Log of pdflatex is written to its own file,
+	// so its output to terminal is dropped.
+	posix_spawn_file_actions_t actions;
+	int error = posix_spawn_file_actions_init(&actions);
+	if (!error)
+	{
+		error = posix_spawn_file_actions_addopen(&actions, 1, "/dev/null",
+		                                         O_WRONLY, 0);
+		if (!error)
+			error = posix_spawn_file_actions_adddup2(&actions, 1, 2);
+
+		char program[] = "pdflatex";
+		char mode[]    = "-interaction=nonstopmode";
+		char halt[]    = "-halt-on-error";
+
+		char* argv[] = {program, mode, halt, directory, file, NULL};
+		if (!error)
+			error = posix_spawnp(&build->pid, argv[0], &actions, NULL,
+			                     argv, environ);
+
+		posix_spawn_file_actions_destroy(&actions);
+	}
+
+	free(directory);
+	free(file);
+	if (error)
+	{
+		errno = error;
+		perror("Cannot run pdflatex");
+		free(build);
+		return NULL;
+	}
+
+	return build;
+}
+
+
+bool pdf_build_poll (pdf_build_t build)
+{
+	assert (build);
+
+	if (!build->finished)
+		pdf_build_reap(build, WNOHANG);
+
+	return build->finished;
+}
+
+
+int pdf_build_wait (pdf_build_t build)
+{
+	assert (build);
+
+	while (!build->finished)
+		pdf_build_reap(build, 0);
+
+	int status = build->status;
+	free(build);
+	return status;
+}
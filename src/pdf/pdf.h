@@ -0,0 +1,62 @@
+/*!
+ * @file
+ * @brief Header of building pdf file from tex file.
+ *
+ * Pdf file is built by pdflatex in a child process, so the caller
+ * can go on with its work and wait for the result later.
+ */
+
+#ifndef PDF_H_
+#define PDF_H_
+
+#include <stdbool.h>
+
+
+
+/*!
+ * @brief Running build of pdf file.
+ */
+typedef struct pdf_build* pdf_build_t;
+
+
+
+/*!
+ * @brief Start building pdf file from tex file in background.
+ *
+ * @note Pdf file and log of pdflatex are written to the directory
+ * of tex file.
+ *
+ * @note Don't forget to finish build using pdf_build_wait() function.
+ *
+ * @return Running build or NULL if pdflatex cannot be started.
+ */
+pdf_build_t pdf_build_start
+(
+	const char* path /*!< [in] path to tex file.                             */
+);
+
+/*!
+ * @brief Check build of pdf file to be finished without waiting for it.
+ *
+ * @return Checking result.
+ */
+bool pdf_build_poll
+(
+	pdf_build_t build /*!< [in,out] running build.                           */
+);
+
+/*!
+ * @brief Wait for build of pdf file and free its memory.
+ *
+ * @return Exit status of pdflatex or -1 if it has been terminated
+ * abnormally.
+ */
+int pdf_build_wait
+(
+	pdf_build_t build /*!< [in,out] running build.                           */
+);
+
+
+
+
+#endif // not defined PDF_H_
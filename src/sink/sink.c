@@ -0,0 +1,394 @@
+/*!
+ * @file
+ * @brief Implementation of buffered output sink.
+ */
+
+// write() isn't a part of strict C11 environment.
+#ifndef _DEFAULT_SOURCE
+#	define _DEFAULT_SOURCE
+#endif
+
+#include "sink.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+
+
+/*!
+ * @brief Targets of sink.
+ */
+typedef enum
+{
+	SINK_FILE   = 0, //!< file stream.
+	SINK_FD     = 1, //!< file descriptor.
+	SINK_MEMORY = 2, //!< growing buffer.
+}
+sink_target_t;
+
+/*!
+ * @brief Buffered output sink.
+ */
+struct sink
+{
+	sink_target_t target;   /*!< target of output.                           */
+	FILE*         file;     /*!< output stream of file target.               */
+	int           fd;       /*!< output descriptor of fd target.             */
+	bool          owned;    /*!< descriptor is closed by sink.               */
+	char*         buffer;   /*!< buffered output.                            */
+	size_t        size;     /*!< amount of bytes in buffer.                  */
+	size_t        capacity; /*!< capacity of buffer.                         */
+	bool          failed;   /*!< some writing has failed.                    */
+};
+
+/*!
+ * @brief Capacity of buffer of file and fd targets.
+ */
+static const size_t SINK_BUFFER_SIZE = 1 << 16;
+
+/*!
+ * @brief Initial capacity of buffer of memory target.
+ */
+static const size_t SINK_MEMORY_INIT_SIZE = 1 << 12;
+
+/*!
+ * @brief The least number which isn't appended by fast path of sink_fixed(),
+ * numbers below it multiplied by 100 are below 2^52 and their fractional
+ * part is exact.
+ */
+static const double SINK_FIXED_MAX = 0x1p45;
+
+
+
+
+/*!
+ * @brief Create sink with given target.
+ *
+ * @return Sink or NULL if an error occurred.
+ */
+static sink_t sink_create
+(
+	sink_target_t target,  /*!< [in] target of output.                       */
+	size_t        capacity /*!< [in] capacity of buffer.                     */
+)
+{
+	sink_t sink = (sink_t) calloc(1, sizeof *sink);
+	if (!sink)
+		return NULL;
+
+	// Memory target keeps place for terminating '\0'.
+	sink->target   = target;
+	sink->fd       = -1;
+	sink->capacity = capacity;
+	sink->buffer   = (char*) malloc(capacity + 1);
+	if (!sink->buffer)
+	{
+		free(sink);
+		return NULL;
+	}
+
+	return sink;
+}
+
+/*!
+ * @brief Write data to the target of sink past its buffer.
+ */
+static void sink_target_write
+(
+	sink_t      sink, /*!< [in,out] sink.                                    */
+	const char* data, /*!< [in]     written data.                            */
+	size_t      size  /*!< [in]     size of data.                            */
+)
+{
+	if (sink->failed || !size)
+		return;
+
+	switch (sink->target)
+	{
+		case SINK_FILE:
+			sink->failed = fwrite(data, 1, size, sink->file) != size;
+			return;
+
+		case SINK_FD:
+			while (size)
+			{
+				ssize_t written = write(sink->fd, data, size);
+				if (written < 0 && errno == EINTR)
+					continue;
+
+				if (written <= 0)
+				{
+					sink->failed = true;
+					return;
+				}
+
+				data += written;
+				size -= (size_t) written;
+			}
+
+			return;
+
+		case SINK_MEMORY:
+		default:
+			// Data is written past buffer of memory only if it can't grow.
+			sink->failed = true;
+			return;
+	}
+}
+
+/*!
+ * @brief Make place for data in buffer of sink.
+ *
+ * @return True if buffer has enough place after that.
+ */
+static bool sink_reserve
+(
+	sink_t sink, /*!< [in,out] sink.                                         */
+	size_t size  /*!< [in]     size of data.                                 */
+)
+{
+	if (sink->target != SINK_MEMORY)
+	{
+		sink_target_write(sink, sink->buffer, sink->size);
+		sink->size = 0;
+		return size <= sink->capacity;
+	}
+
+	size_t capacity = sink->capacity;
+	while (capacity - sink->size < size)
+	{
+		if (capacity > SIZE_MAX / 4)
+		{
+			sink->failed = true;
+			return false;
+		}
+
+		capacity *= 2;
+	}
+
+	char* check = (char*) realloc(sink->buffer, capacity + 1);
+	if (!check)
+	{
+		sink->failed = true;
+		return false;
+	}
+
+	sink->buffer   = check;
+	sink->capacity = capacity;
+	return true;
+}
+
+/*!
+ * @brief Write digits of unsigned number before the end of string.
+ *
+ * @return Pointer to the first digit.
+ */
+static char* sink_digits
+(
+	char*              end, /*!< [out] end of string.                        */
+	unsigned long long num  /*!< [in]  written number.                       */
+)
+{
+	do
+	{
+		*--end = (char) ('0' + num % 10);
+		num   /= 10;
+	}
+	while (num);
+
+	return end;
+}
+
+
+
+
+sink_t sink_create_path (const char* path)
+{
+	assert (path);
+
+	// Descriptor isn't inherited by child processes such as pdflatex.
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (fd < 0)
+		return NULL;
+
+	sink_t sink = sink_create(SINK_FD, SINK_BUFFER_SIZE);
+	if (!sink)
+	{
+		close(fd);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	sink->fd    = fd;
+	sink->owned = true;
+	return sink;
+}
+
+
+sink_t sink_create_file (FILE* file)
+{
+	assert (file);
+
+	sink_t sink = sink_create(SINK_FILE, SINK_BUFFER_SIZE);
+	if (sink)
+		sink->file = file;
+
+	return sink;
+}
+
+
+sink_t sink_create_fd (int fd)
+{
+	assert (fd >= 0);
+
+	sink_t sink = sink_create(SINK_FD, SINK_BUFFER_SIZE);
+	if (sink)
+		sink->fd = fd;
+
+	return sink;
+}
+
+
+sink_t sink_create_memory (void)
+{
+	return sink_create(SINK_MEMORY, SINK_MEMORY_INIT_SIZE);
+}
+
+
+bool sink_destroy (sink_t sink)
+{
+	if (!sink)
+		return true;
+
+	bool ret = sink_flush(sink);
+	if (sink->owned && close(sink->fd))
+		ret = false;
+
+	free(sink->buffer);
+	free(sink);
+	return ret;
+}
+
+
+bool sink_flush (sink_t sink)
+{
+	assert (sink);
+
+	if (sink->target == SINK_MEMORY)
+		return !sink->failed;
+
+	sink_target_write(sink, sink->buffer, sink->size);
+	sink->size = 0;
+	if (sink->target == SINK_FILE && !sink->failed)
+		sink->failed = fflush(sink->file) != 0;
+
+	return !sink->failed;
+}
+
+
+const char* sink_data (const sink_t sink, size_t* size)
+{
+	assert (sink);
+
+	if (sink->target != SINK_MEMORY)
+		return NULL;
+
+	if (size)
+		*size = sink->size;
+
+	sink->buffer[sink->size] = '\0';
+	return sink->buffer;
+}
+
+
+void sink_write (sink_t sink, const char* data, size_t size)
+{
+	assert (sink);
+	assert (data || !size);
+
+	if (size > sink->capacity - sink->size && !sink_reserve(sink, size))
+	{
+		// Data which is longer than buffer is written at once.
+		sink_target_write(sink, data, size);
+		return;
+	}
+
+	memcpy(sink->buffer + sink->size, data, size);
+	sink->size += size;
+}
+
+
+void sink_puts (sink_t sink, const char* str)
+{
+	assert (str);
+
+	sink_write(sink, str, strlen(str));
+}
+
+
+void sink_putc (sink_t sink, char ch)
+{
+	assert (sink);
+
+	if (sink->size == sink->capacity && !sink_reserve(sink, 1))
+		return;
+
+	sink->buffer[sink->size++] = ch;
+}
+
+
+void sink_integer (sink_t sink, long long num)
+{
+	char  str[32] = "";
+	char* end     = str + sizeof str;
+	char* begin   = sink_digits(end, (num < 0) ? 0ULL - (unsigned long long) num
+	                                           : (unsigned long long) num);
+	if (num < 0)
+		*--begin = '-';
+
+	sink_write(sink, begin, (size_t) (end - begin));
+}
+
+
+void sink_fixed (sink_t sink, double num)
+{
+	double absolute = fabs(num);
+	if (!(absolute < SINK_FIXED_MAX))
+	{
+		// Every digit of the biggest number is printed.
+		char str[DBL_MAX_10_EXP + 8] = "";
+		int  size = snprintf(str, sizeof str, "%.2f", num);
+		sink_write(sink, str, (size > 0) ? (size_t) size : 0);
+		return;
+	}
+
+	// Exact product is scaled + error, so rounding to hundredths
+	// is the same as in printf() including ties to even.
+	double scaled = absolute * 100;
+	double error  = fma(absolute, 100, -scaled);
+	double whole  = floor(scaled);
+	double excess = (scaled - whole - 0.5) + error;
+
+	unsigned long long hundredths = (unsigned long long) whole;
+	if (excess > 0 || (fpclassify(excess) == FP_ZERO && hundredths % 2))
+		++hundredths;
+
+	char  str[32] = "";
+	char* end     = str + sizeof str;
+	char* begin   = sink_digits(end - 3, hundredths / 100);
+	end[-3] = '.';
+	end[-2] = (char) ('0' + hundredths / 10 % 10);
+	end[-1] = (char) ('0' + hundredths % 10);
+	if (signbit(num))
+		*--begin = '-';
+
+	sink_write(sink, begin, (size_t) (end - begin));
+}
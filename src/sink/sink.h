@@ -0,0 +1,153 @@
+/*!
+ * @file
+ * @brief Header of buffered output sink.
+ *
+ * Sink collects output in its own buffer and passes it to the target
+ * in big blocks, so appending a short string is a copy to memory
+ * without locking and formatting of stdio. Sink belongs to one thread.
+ */
+
+#ifndef SINK_H_
+#define SINK_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+
+
+
+/*!
+ * @brief Buffered output sink.
+ */
+typedef struct sink* sink_t;
+
+
+
+/*!
+ * @brief Create sink which writes to new file.
+ *
+ * @note File is closed by sink_destroy().
+ *
+ * @return Sink or NULL if an error occurred, errno is set in this case.
+ */
+sink_t sink_create_path
+(
+	const char* path /*!< [in] path to file.                                 */
+);
+
+/*!
+ * @brief Create sink which writes to file stream.
+ *
+ * @note Stream isn't closed by sink_destroy().
+ *
+ * @return Sink or NULL if an error occurred.
+ */
+sink_t sink_create_file
+(
+	FILE* file /*!< [in,out] output stream.                                  */
+);
+
+/*!
+ * @brief Create sink which writes to file descriptor.
+ *
+ * @note Descriptor isn't closed by sink_destroy().
+ *
+ * @return Sink or NULL if an error occurred.
+ */
+sink_t sink_create_fd
+(
+	int fd /*!< [in] output file descriptor.                                 */
+);
+
+/*!
+ * @brief Create sink which collects output in memory.
+ *
+ * @return Sink or NULL if an error occurred.
+ */
+sink_t sink_create_memory (void);
+
+/*!
+ * @brief Flush sink and free its memory.
+ *
+ * @return Success of all writings.
+ */
+bool sink_destroy
+(
+	sink_t sink /*!< [in,out] sink.                                          */
+);
+
+/*!
+ * @brief Pass buffered output to the target.
+ *
+ * @return Success of all writings.
+ */
+bool sink_flush
+(
+	sink_t sink /*!< [in,out] sink.                                          */
+);
+
+/*!
+ * @brief Get output collected by memory sink.
+ *
+ * @note Output is terminated by '\0' and valid until the next appending
+ * to sink or its destruction.
+ *
+ * @return Output or NULL if sink doesn't collect output in memory.
+ */
+const char* sink_data
+(
+	const sink_t sink, /*!< [in]  sink.                                      */
+	size_t*      size  /*!< [out] size of output, it can be NULL.            */
+);
+
+/*!
+ * @brief Append data to sink.
+ */
+void sink_write
+(
+	sink_t      sink, /*!< [in,out] sink.                                    */
+	const char* data, /*!< [in]     appended data.                           */
+	size_t      size  /*!< [in]     size of data.                            */
+);
+
+/*!
+ * @brief Append string to sink.
+ */
+void sink_puts
+(
+	sink_t      sink, /*!< [in,out] sink.                                    */
+	const char* str   /*!< [in]     appended string.                         */
+);
+
+/*!
+ * @brief Append character to sink.
+ */
+void sink_putc
+(
+	sink_t sink, /*!< [in,out] sink.                                         */
+	char   ch    /*!< [in]     appended character.                           */
+);
+
+/*!
+ * @brief Append integer in decimal format to sink.
+ */
+void sink_integer
+(
+	sink_t    sink, /*!< [in,out] sink.                                      */
+	long long num   /*!< [in]     appended number.                           */
+);
+
+/*!
+ * @brief Append number with two digits after point to sink.
+ *
+ * @note Output is the same as output of "%.2f" format.
+ */
+void sink_fixed
+(
+	sink_t sink, /*!< [in,out] sink.                                         */
+	double num   /*!< [in]     appended number.                              */
+);
+
+
+
+
+#endif // not defined SINK_H_
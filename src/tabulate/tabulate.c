@@ -0,0 +1,367 @@
+/*!
+ * @file
+ * @brief Implementation of tabulation of derivatives over a uniform grid.
+ */
+
+// sysconf() isn't a part of strict C11 environment.
+#ifndef _DEFAULT_SOURCE
+#	define _DEFAULT_SOURCE
+#endif
+
+#include "tabulate.h"
+#include "../bytecode/bytecode.h"
+#include "../dag/dag.h"
+#include "../differentiator.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+
+
+struct tabulate_pool;
+
+/*!
+ * @brief Thread of the pool with its part of the current window.
+ */
+struct tabulate_worker
+{
+	pthread_t             thread;  /*!< thread.                              */
+	struct tabulate_pool* pool;    /*!< pool of the thread.                  */
+	size_t                first;   /*!< index of the first point of chunk.   */
+	size_t                amount;  /*!< amount of points in chunk.           */
+	double*               x;       /*!< points of chunk.                     */
+	double*               values;  /*!< values at points of chunk.           */
+	char*                 buffer;  /*!< formatted chunk.                     */
+	size_t                size;    /*!< amount of bytes in buffer.           */
+	bool                  success; /*!< success of evaluation of chunk.      */
+};
+
+/*!
+ * @brief Pool of threads which process the grid window by window.
+ */
+struct tabulate_pool
+{
+	pthread_mutex_t          mutex;   /*!< mutex of the fields below.        */
+	pthread_cond_t           start;   /*!< signaled when window is given.    */
+	pthread_cond_t           done;    /*!< signaled when window is ready.    */
+	size_t                   window;  /*!< number of the current window.     */
+	size_t                   pending; /*!< amount of busy workers.           */
+	bool                     stop;    /*!< workers should exit.              */
+	bytecode_t               code;    /*!< compiled derivative.              */
+	const tabulate_params_t* params;  /*!< parameters of tabulation.         */
+	struct tabulate_worker*  workers; /*!< workers of the pool.              */
+	size_t                   size;    /*!< amount of running workers.        */
+};
+
+/*!
+ * @brief Amount of points which are processed by one worker at once.
+ */
+static const size_t TABULATE_CHUNK = 16384;
+
+/*!
+ * @brief Place for line in CSV format. Every number takes at most
+ * 24 characters with 17 significant digits, snprintf() also writes
+ * terminating '\0' after the line.
+ */
+static const size_t TABULATE_LINE = 2 * 24 + 2 + 1;
+
+
+
+
+/*!
+ * @brief Build derivative of given order and compile it.
+ *
+ * @return Compiled derivative or NULL if an error occurred.
+ */
+static bytecode_t tabulate_compile
+(
+	const bintree_t expression, /*!< [in] expression.                        */
+	size_t          order       /*!< [in] order of derivative.               */
+)
+{
+	dag_store_t store = dag_store_create();
+	if (!store)
+	{
+		fputs("Cannot create expression store.\n\n", stderr);
+		return NULL;
+	}
+
+	// Derivatives of high orders share a lot of subexpressions,
+	// so they are built and compiled in the hash-consed store.
+	dag_t root = dag_from_bintree(store, expression);
+	for (size_t i = 0; i < order && root != DAG_NONE; ++i)
+		root = differentiate_dag(store, root);
+
+	bytecode_t code = (root != DAG_NONE) ? bytecode_compile_dag(store, root)
+	                                     : NULL;
+	if (root == DAG_NONE)
+		fputs("Cannot build derivative for tabulation.\n\n", stderr);
+	else if (!code)
+		fputs("Cannot evaluate expression numerically.\n\n", stderr);
+
+	dag_store_destroy(store);
+	return code;
+}
+
+/*!
+ * @brief Evaluate and format chunk of worker.
+ */
+static void tabulate_chunk
+(
+	struct tabulate_worker* worker /*!< [in,out] worker.                     */
+)
+{
+	const tabulate_params_t* params = worker->pool->params;
+
+	// Points are found by index, so errors don't accumulate.
+	double step = (params->steps) ? (params->to - params->from)
+	                                / (double) params->steps : 0;
+	for (size_t i = 0; i < worker->amount; ++i)
+	{
+		size_t index = worker->first + i;
+		worker->x[i] = (index == params->steps && index)
+		               ? params->to : params->from + step * (double) index;
+	}
+
+	worker->size    = 0;
+	worker->success = bytecode_evaluate_batch(worker->pool->code, worker->x,
+	                                          worker->values, worker->amount);
+	if (!worker->success)
+		return;
+
+	if (params->format == TABULATE_BINARY)
+	{
+		for (size_t i = 0; i < worker->amount; ++i)
+		{
+			memcpy(worker->buffer + worker->size, &worker->x[i],
+			       sizeof *worker->x);
+			worker->size += sizeof *worker->x;
+			memcpy(worker->buffer + worker->size, &worker->values[i],
+			       sizeof *worker->values);
+			worker->size += sizeof *worker->values;
+		}
+
+		return;
+	}
+
+	for (size_t i = 0; i < worker->amount; ++i)
+	{
+		int length = snprintf(worker->buffer + worker->size, TABULATE_LINE,
+		                      "%.17g,%.17g\n", worker->x[i], worker->values[i]);
+		if (length < 0 || (size_t) length >= TABULATE_LINE)
+		{
+			fputs("Cannot format line of table.\n\n", stderr);
+			worker->success = false;
+			return;
+		}
+
+		worker->size += (size_t) length;
+	}
+}
+
+/*!
+ * @brief Main function of worker thread.
+ *
+ * @return NULL.
+ */
+static void* tabulate_thread
+(
+	void* arg /*!< [in,out] worker.                                          */
+)
+{
+	struct tabulate_worker* worker = (struct tabulate_worker*) arg;
+	struct tabulate_pool*   pool   = worker->pool;
+	size_t                  window = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	while (true)
+	{
+		while (pool->window == window && !pool->stop)
+			pthread_cond_wait(&pool->start, &pool->mutex);
+
+		if (pool->stop)
+			break;
+
+		window = pool->window;
+		pthread_mutex_unlock(&pool->mutex);
+
+		tabulate_chunk(worker);
+
+		pthread_mutex_lock(&pool->mutex);
+		if (--pool->pending == 0)
+			pthread_cond_signal(&pool->done);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+/*!
+ * @brief Stop workers of the pool and free their memory.
+ */
+static void tabulate_pool_stop
+(
+	struct tabulate_pool* pool /*!< [in,out] pool of threads.                */
+)
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (size_t i = 0; i < pool->size; ++i)
+		pthread_join(pool->workers[i].thread, NULL);
+
+	for (size_t i = 0; pool->workers && i < pool->params->threads; ++i)
+	{
+		free(pool->workers[i].x);
+		free(pool->workers[i].values);
+		free(pool->workers[i].buffer);
+	}
+
+	free(pool->workers);
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->start);
+	pthread_mutex_destroy(&pool->mutex);
+}
+
+/*!
+ * @brief Start workers of the pool.
+ *
+ * @note Pool should be stopped by tabulate_pool_stop() even if an error
+ * occurred.
+ *
+ * @return Success of starting.
+ */
+static bool tabulate_pool_start
+(
+	struct tabulate_pool* pool /*!< [in,out] pool of threads.                */
+)
+{
+	size_t threads = pool->params->threads;
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done,  NULL);
+
+	pool->workers = (struct tabulate_worker*) calloc(threads,
+	                                                 sizeof *pool->workers);
+	if (!pool->workers)
+	{
+		fputs("Cannot allocate memory for threads.\n\n", stderr);
+		return false;
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		struct tabulate_worker* worker = &pool->workers[i];
+
+		worker->pool   = pool;
+		worker->x      = (double*) calloc(TABULATE_CHUNK, sizeof *worker->x);
+		worker->values = (double*) calloc(TABULATE_CHUNK,
+		                                  sizeof *worker->values);
+		worker->buffer = (char*) malloc(TABULATE_CHUNK * TABULATE_LINE);
+		if (!worker->x || !worker->values || !worker->buffer)
+		{
+			fputs("Cannot allocate memory for table.\n\n", stderr);
+			return false;
+		}
+
+		if (pthread_create(&worker->thread, NULL, tabulate_thread, worker))
+		{
+			fputs("Cannot create thread.\n\n", stderr);
+			return false;
+		}
+
+		++pool->size;
+	}
+
+	return true;
+}
+
+/*!
+ * @brief Process the grid window by window and write the results.
+ *
+ * @return Success of tabulation.
+ */
+static bool tabulate_run
+(
+	struct tabulate_pool* pool,  /*!< [in,out] pool of threads.              */
+	FILE*                 output /*!< [in,out] output stream.                */
+)
+{
+	size_t points = pool->params->steps + 1;
+	size_t window = pool->size * TABULATE_CHUNK;
+	for (size_t first = 0; first < points; first += window)
+	{
+		for (size_t i = 0; i < pool->size; ++i)
+		{
+			struct tabulate_worker* worker = &pool->workers[i];
+
+			size_t begin   = first + i * TABULATE_CHUNK;
+			worker->first  = begin;
+			worker->amount = (begin >= points) ? 0
+			                 : (points - begin < TABULATE_CHUNK)
+			                   ? points - begin : TABULATE_CHUNK;
+		}
+
+		pthread_mutex_lock(&pool->mutex);
+		++pool->window;
+		pool->pending = pool->size;
+		pthread_cond_broadcast(&pool->start);
+		while (pool->pending)
+			pthread_cond_wait(&pool->done, &pool->mutex);
+
+		pthread_mutex_unlock(&pool->mutex);
+
+		// Chunks are written in order of points.
+		for (size_t i = 0; i < pool->size; ++i)
+		{
+			struct tabulate_worker* worker = &pool->workers[i];
+			if (!worker->success)
+				return false;
+
+			if (fwrite(worker->buffer, 1, worker->size, output) != worker->size)
+			{
+				perror("Cannot write table");
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+
+
+bool tabulate (const bintree_t expression, const tabulate_params_t* params,
+               FILE* output)
+{
+	assert (expression);
+	assert (params);
+	assert (output);
+
+	tabulate_params_t actual = *params;
+	if (!actual.threads)
+	{
+		long processors = sysconf(_SC_NPROCESSORS_ONLN);
+		actual.threads  = (processors > 0) ? (size_t) processors : 1;
+	}
+
+	struct tabulate_pool pool = {0};
+	pool.params = &actual;
+	pool.code   = tabulate_compile(expression, actual.order);
+	if (!pool.code)
+		return false;
+
+	bool ret = tabulate_pool_start(&pool) && tabulate_run(&pool, output);
+
+	tabulate_pool_stop(&pool);
+	bytecode_destroy(pool.code);
+	return ret;
+}
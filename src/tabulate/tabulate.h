@@ -0,0 +1,65 @@
+/*!
+ * @file
+ * @brief Header of tabulation of derivatives over a uniform grid.
+ *
+ * Points of the grid are processed by a pool of threads in windows,
+ * every thread evaluates and formats its own part of a window, so both
+ * evaluation and formatting scale with the amount of processors.
+ */
+
+#ifndef TABULATE_H_
+#define TABULATE_H_
+
+#include "../tree/bintree.h"
+
+#include <stdio.h>
+
+
+
+/*!
+ * @brief Formats of tabulation output.
+ */
+typedef enum
+{
+	TABULATE_CSV    = 0, //!< lines "x,value" with 17 significant digits.
+	TABULATE_BINARY = 1, //!< pairs of x and value as native doubles.
+}
+tabulate_format_t;
+
+/*!
+ * @brief Parameters of tabulation.
+ */
+typedef struct
+{
+	double            from;    /*!< the first point of the grid.             */
+	double            to;      /*!< the last point of the grid.              */
+	size_t            steps;   /*!< amount of steps, there are steps + 1
+	                                points in the grid.                      */
+	size_t            order;   /*!< order of tabulated derivative.           */
+	size_t            threads; /*!< amount of threads, 0 means amount
+	                                of processors.                           */
+	tabulate_format_t format;  /*!< format of output.                        */
+}
+tabulate_params_t;
+
+
+
+/*!
+ * @brief Write values of derivative of expression at points of the grid.
+ *
+ * @note Expression can contain only variable x, numbers, constants e and pi,
+ * arithmetic operations and builtin functions.
+ *
+ * @return Success of tabulation.
+ */
+bool tabulate
+(
+	const bintree_t          expression, /*!< [in]     expression.           */
+	const tabulate_params_t* params,     /*!< [in]     parameters.           */
+	FILE*                    output      /*!< [in,out] output stream.        */
+);
+
+
+
+
+#endif // not defined TABULATE_H_
@@ -0,0 +1,469 @@
+/*!
+ * @file
+ * @brief Implementation of numeric Taylor-mode differentiation.
+ */
+
+#include "taylor.h"
+#include "../builtins/builtins.h"
+#include "../dsl/dsl.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Stack of series of evaluated subexpressions.
+ */
+struct series_stack
+{
+	double* series;   /*!< coefficients of series one after another.         */
+	size_t  size;     /*!< amount of series in the stack.                    */
+	size_t  capacity; /*!< capacity of the stack in series.                  */
+	size_t  len;      /*!< amount of coefficients in every series.           */
+};
+
+/*!
+ * @brief Amount of scratch series used by rules.
+ */
+static const size_t TAYLOR_SCRATCH_AMOUNT = 3;
+
+/*!
+ * @brief Value of e constant.
+ */
+static const double TAYLOR_E  = 2.71828182845904523536;
+
+/*!
+ * @brief Value of pi constant.
+ */
+static const double TAYLOR_PI = 3.14159265358979323846;
+
+
+
+
+/*!
+ * @brief Check coefficient to be exact zero.
+ *
+ * @note double_equal() isn't used because small coefficients are meaningful.
+ *
+ * @return Result of checking.
+ */
+static bool is_zero
+(
+	double num /*!< [in] coefficient.                                        */
+)
+{
+	return fpclassify(num) == FP_ZERO;
+}
+
+/*!
+ * @brief Push new series to the stack.
+ *
+ * @note Pointer is valid until the next pushing.
+ *
+ * @return Pushed series or NULL if an error occurred.
+ */
+static double* series_push
+(
+	struct series_stack* stack /*!< [in,out] stack of series.                */
+)
+{
+	if (stack->size == stack->capacity)
+	{
+		size_t capacity = (stack->capacity) ? stack->capacity * 2 : 16;
+		void*  check    = realloc(stack->series,
+		                          capacity * stack->len * sizeof *stack->series);
+		if (!check)
+		{
+			fputs("Cannot allocate memory for series.\n\n", stderr);
+			return NULL;
+		}
+
+		stack->series   = (double*) check;
+		stack->capacity = capacity;
+	}
+
+	double* series = stack->series + stack->size++ * stack->len;
+	memset(series, 0, stack->len * sizeof *series);
+	return series;
+}
+
+/*!
+ * @brief Get series from the top of stack.
+ *
+ * @return Series which is the depth-th from the top.
+ */
+static double* series_top
+(
+	struct series_stack* stack, /*!< [in] stack of series.                   */
+	size_t               depth  /*!< [in] depth of series, 0 is the top.     */
+)
+{
+	assert (depth < stack->size);
+
+	return stack->series + (stack->size - 1 - depth) * stack->len;
+}
+
+/*!
+ * @brief Raise series to the constant power.
+ */
+static void series_pow_const
+(
+	double*       result,   /*!< [out] power.                                */
+	const double* base,     /*!< [in]  base.                                 */
+	double        exponent, /*!< [in]  exponent.                             */
+	double*       scratch,  /*!< [in]  room for two series.                  */
+	size_t        order     /*!< [in]  order of series.                      */
+)
+{
+	size_t len = order + 1;
+	if (is_zero(base[0]) && exponent >= 0 && is_zero(exponent - floor(exponent)))
+	{
+		// Recurrence divides by base[0], so natural powers are found
+		// by squaring. Powers higher than order are zero series anyway.
+		double* power   = scratch;
+		double* product = scratch + len;
+		size_t  n       = (exponent < (double) len) ? (size_t) exponent : len;
+		memcpy(power, base, len * sizeof *power);
+		memset(result, 0, len * sizeof *result);
+		result[0] = 1;
+		while (n)
+		{
+			if (n & 1)
+			{
+				taylor_mul(product, result, power, order);
+				memcpy(result, product, len * sizeof *result);
+			}
+
+			n >>= 1;
+			if (n)
+			{
+				taylor_mul(product, power, power, order);
+				memcpy(power, product, len * sizeof *power);
+			}
+		}
+
+		return;
+	}
+
+	result[0] = pow(base[0], exponent);
+	for (size_t k = 1; k < len; ++k)
+	{
+		double sum = 0;
+		for (size_t j = 1; j <= k; ++j)
+			sum += ((exponent + 1) * (double) j - (double) k)
+			       * base[j] * result[k - j];
+
+		result[k] = sum / ((double) k * base[0]);
+	}
+}
+
+/*!
+ * @brief Raise series to the power of series.
+ */
+static void series_pow
+(
+	double*       result,   /*!< [out] power.                                */
+	const double* base,     /*!< [in]  base.                                 */
+	const double* exponent, /*!< [in]  exponent.                             */
+	double*       scratch,  /*!< [in]  room for two series.                  */
+	size_t        order     /*!< [in]  order of series.                      */
+)
+{
+	bool constant = true;
+	for (size_t k = 1; k <= order && constant; ++k)
+		constant = is_zero(exponent[k]);
+
+	if (constant)
+	{
+		series_pow_const(result, base, exponent[0], scratch, order);
+		return;
+	}
+
+	// base^exponent = exp(exponent * ln(base)).
+	double* logarithm = scratch;
+	double* product   = scratch + order + 1;
+	taylor_ln(logarithm, base, order);
+	taylor_mul(product, exponent, logarithm, order);
+	taylor_exp(result, product, order);
+}
+
+/*!
+ * @brief Push series of leaf to the stack.
+ *
+ * @return Success of pushing.
+ */
+static bool series_leaf
+(
+	struct series_stack* stack,      /*!< [in,out] stack of series.          */
+	const bintree_t      expression, /*!< [in]     leaf.                     */
+	double               point       /*!< [in]     center of series.         */
+)
+{
+	double value = 0;
+	if (D_TYPE == TOKEN_NUMBER)
+		value = D_NUMBER;
+	else if (D_TYPE == TOKEN_VAR && D_IDENT == SYMBOL_X)
+		value = point;
+	else if (D_TYPE == TOKEN_VAR && D_IDENT == SYMBOL_E)
+		value = TAYLOR_E;
+	else if (D_TYPE == TOKEN_VAR && D_IDENT == SYMBOL_PI)
+		value = TAYLOR_PI;
+	else
+	{
+		if (D_TYPE == TOKEN_VAR)
+			fprintf(stderr, "Cannot expand variable %s to series.\n\n",
+			        symbol_name(D_IDENT));
+		else
+			fputs("Cannot expand unknown token to series.\n\n", stderr);
+
+		return false;
+	}
+
+	double* series = series_push(stack);
+	if (!series)
+		return false;
+
+	series[0] = value;
+	if (D_TYPE == TOKEN_VAR && D_IDENT == SYMBOL_X && stack->len > 1)
+		series[1] = 1;
+
+	return true;
+}
+
+/*!
+ * @brief Replace series of operands on the top of stack by series of node.
+ *
+ * @return Success of evaluation.
+ */
+static bool series_node
+(
+	struct series_stack* stack,      /*!< [in,out] stack of series.          */
+	const bintree_t      expression, /*!< [in]     evaluated node.           */
+	double               point,      /*!< [in]     center of series.         */
+	double*              scratch     /*!< [in]     scratch series.           */
+)
+{
+	if (!D_LHS && !D_RHS)
+		return series_leaf(stack, D_NODE, point);
+
+	size_t len   = stack->len;
+	size_t order = len - 1;
+	if (D_TYPE == TOKEN_FUNC)
+	{
+		const builtin_rule_t* rule = builtin_rule(D_FUNC);
+		if (!rule)
+		{
+			fprintf(stderr, "Cannot expand function %s to series.\n\n",
+			        symbol_name(D_IDENT));
+			return false;
+		}
+
+		double* arg = series_top(stack, 0);
+		rule->series(scratch, arg, scratch + len, order);
+		memcpy(arg, scratch, len * sizeof *arg);
+		return true;
+	}
+
+	if (D_TYPE != TOKEN_OP || D_OP == OP_DERIV || D_OP == OP_EMPTY)
+	{
+		fputs("Cannot expand operation to series.\n\n", stderr);
+		return false;
+	}
+
+	if (D_ISPREFUNARY)
+	{
+		double* arg = series_top(stack, 0);
+		if (D_OP == OP_MINUS)
+			for (size_t k = 0; k < len; ++k)
+				arg[k] = -arg[k];
+
+		return true;
+	}
+
+	double* lhs = series_top(stack, 1);
+	double* rhs = series_top(stack, 0);
+	switch (D_OP)
+	{
+		case OP_PLUS:
+			for (size_t k = 0; k < len; ++k)
+				lhs[k] += rhs[k];
+			break;
+
+		case OP_MINUS:
+			for (size_t k = 0; k < len; ++k)
+				lhs[k] -= rhs[k];
+			break;
+
+		case OP_MUL:
+			taylor_mul(scratch, lhs, rhs, order);
+			memcpy(lhs, scratch, len * sizeof *lhs);
+			break;
+
+		case OP_DIV:
+			taylor_div(lhs, lhs, rhs, order);
+			break;
+
+		case OP_POW:
+			series_pow(scratch, lhs, rhs, scratch + len, order);
+			memcpy(lhs, scratch, len * sizeof *lhs);
+			break;
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			assert ("UNREACHABLE" && false);
+			return false;
+	}
+
+	--stack->size;
+	return true;
+}
+
+
+
+
+bool taylor_coefficients (const bintree_t expression, double point,
+                          size_t order, double* coefficients)
+{
+	assert (expression);
+	assert (coefficients);
+
+	struct series_stack stack = {NULL, 0, 0, order + 1};
+
+	double* scratch = (double*) calloc(TAYLOR_SCRATCH_AMOUNT * stack.len,
+	                                   sizeof *scratch);
+	if (!scratch)
+	{
+		fputs("Cannot allocate memory for series.\n\n", stderr);
+		return false;
+	}
+
+	// Children are evaluated before their parent, so operands of every node
+	// are on the top of stack when the node is visited.
+	bool      ret  = true;
+	bintree_t node = bintree_postorder_first(expression);
+	while (ret)
+	{
+		ret = series_node(&stack, node, point, scratch);
+		if (node == expression)
+			break;
+
+		node = bintree_postorder_next(expression, node);
+	}
+
+	if (ret)
+		memcpy(coefficients, stack.series, stack.len * sizeof *coefficients);
+
+	free(stack.series);
+	free(scratch);
+	return ret;
+}
+
+
+bool taylor_derivatives (const bintree_t expression, double point,
+                         size_t order, double* derivatives)
+{
+	if (!taylor_coefficients(expression, point, order, derivatives))
+		return false;
+
+	double factorial = 1;
+	for (size_t k = 1; k <= order; ++k)
+	{
+		factorial      *= (double) k;
+		derivatives[k] *= factorial;
+	}
+
+	return true;
+}
+
+
+void taylor_mul (double* result, const double* lhs,
+                 const double* rhs, size_t order)
+{
+	assert (result != lhs && result != rhs);
+
+	for (size_t k = 0; k <= order; ++k)
+	{
+		double sum = 0;
+		for (size_t j = 0; j <= k; ++j)
+			sum += lhs[j] * rhs[k - j];
+
+		result[k] = sum;
+	}
+}
+
+
+void taylor_div (double* result, const double* lhs,
+                 const double* rhs, size_t order)
+{
+	assert (result != rhs);
+
+	// Dividend coefficient is read before it is overwritten.
+	for (size_t k = 0; k <= order; ++k)
+	{
+		double sum = lhs[k];
+		for (size_t j = 1; j <= k; ++j)
+			sum -= rhs[j] * result[k - j];
+
+		result[k] = sum / rhs[0];
+	}
+}
+
+
+void taylor_exp (double* result, const double* arg, size_t order)
+{
+	assert (result != arg);
+
+	result[0] = exp(arg[0]);
+	for (size_t k = 1; k <= order; ++k)
+	{
+		double sum = 0;
+		for (size_t j = 1; j <= k; ++j)
+			sum += (double) j * arg[j] * result[k - j];
+
+		result[k] = sum / (double) k;
+	}
+}
+
+
+void taylor_ln (double* result, const double* arg, size_t order)
+{
+	assert (result != arg);
+
+	result[0] = log(arg[0]);
+	for (size_t k = 1; k <= order; ++k)
+	{
+		double sum = 0;
+		for (size_t j = 1; j < k; ++j)
+			sum += (double) j * result[j] * arg[k - j];
+
+		result[k] = (arg[k] - sum / (double) k) / arg[0];
+	}
+}
+
+
+void taylor_sincos (double* sine, double* cosine,
+                    const double* arg, size_t order)
+{
+	assert (sine != arg && cosine != arg && sine != cosine);
+
+	sine[0]   = sin(arg[0]);
+	cosine[0] = cos(arg[0]);
+	for (size_t k = 1; k <= order; ++k)
+	{
+		double sin_sum = 0;
+		double cos_sum = 0;
+		for (size_t j = 1; j <= k; ++j)
+		{
+			sin_sum += (double) j * arg[j] * cosine[k - j];
+			cos_sum += (double) j * arg[j] * sine[k - j];
+		}
+
+		sine[k]   =  sin_sum / (double) k;
+		cosine[k] = -cos_sum / (double) k;
+	}
+}
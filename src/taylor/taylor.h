@@ -0,0 +1,120 @@
+/*!
+ * @file
+ * @brief Header of numeric Taylor-mode differentiation.
+ *
+ * Expression is evaluated over truncated power series instead of numbers:
+ * every node gets coefficients u_0, ..., u_n of its Taylor series at given
+ * point, where u_k = u^(k)(a) / k!. Every rule costs O(n^2) operations,
+ * so high orders are reachable without building derivative trees.
+ *
+ * Series are arrays of (order + 1) doubles.
+ */
+
+#ifndef TAYLOR_H_
+#define TAYLOR_H_
+
+#include "../tree/bintree.h"
+
+
+
+/*!
+ * @brief Calculate Taylor coefficients of expression at given point.
+ *
+ * @note coefficients[k] is f^(k)(point) / k!.
+ *
+ * @note Expression can contain only variable x, numbers, constants e and pi,
+ * arithmetic operations and builtin functions.
+ *
+ * @return Success of calculation.
+ */
+bool taylor_coefficients
+(
+	const bintree_t expression,  /*!< [in]  expression.                      */
+	double          point,       /*!< [in]  center of series.                */
+	size_t          order,       /*!< [in]  maximal order of coefficients.   */
+	double*         coefficients /*!< [out] array of (order + 1) elements.   */
+);
+
+/*!
+ * @brief Calculate derivatives of expression at given point.
+ *
+ * @note derivatives[k] is f^(k)(point). It can be infinite for high orders
+ * because of k! factor, use taylor_coefficients() in this case.
+ *
+ * @return Success of calculation.
+ */
+bool taylor_derivatives
+(
+	const bintree_t expression, /*!< [in]  expression.                       */
+	double          point,      /*!< [in]  point of differentiation.         */
+	size_t          order,      /*!< [in]  maximal order of derivatives.     */
+	double*         derivatives /*!< [out] array of (order + 1) elements.    */
+);
+
+/*!
+ * @brief Multiply series.
+ *
+ * @note Result mustn't be the same array as operands.
+ */
+void taylor_mul
+(
+	double*       result, /*!< [out] product.                                */
+	const double* lhs,    /*!< [in]  left operand.                           */
+	const double* rhs,    /*!< [in]  right operand.                          */
+	size_t        order   /*!< [in]  order of series.                        */
+);
+
+/*!
+ * @brief Divide series.
+ *
+ * @note Result can be the same array as dividend but not as divisor.
+ */
+void taylor_div
+(
+	double*       result, /*!< [out] quotient.                               */
+	const double* lhs,    /*!< [in]  dividend.                               */
+	const double* rhs,    /*!< [in]  divisor.                                */
+	size_t        order   /*!< [in]  order of series.                        */
+);
+
+/*!
+ * @brief Calculate exponent of series.
+ *
+ * @note Result mustn't be the same array as argument.
+ */
+void taylor_exp
+(
+	double*       result, /*!< [out] exponent of argument.                   */
+	const double* arg,    /*!< [in]  argument.                               */
+	size_t        order   /*!< [in]  order of series.                        */
+);
+
+/*!
+ * @brief Calculate natural logarithm of series.
+ *
+ * @note Result mustn't be the same array as argument.
+ */
+void taylor_ln
+(
+	double*       result, /*!< [out] logarithm of argument.                  */
+	const double* arg,    /*!< [in]  argument.                               */
+	size_t        order   /*!< [in]  order of series.                        */
+);
+
+/*!
+ * @brief Calculate sine and cosine of series together.
+ *
+ * @note Results mustn't be the same arrays as argument.
+ */
+void taylor_sincos
+(
+	double*       sine,   /*!< [out] sine of argument.                       */
+	double*       cosine, /*!< [out] cosine of argument.                     */
+	const double* arg,    /*!< [in]  argument.                               */
+	size_t        order   /*!< [in]  order of series.                        */
+);
+
+
+
+
+#endif // not defined TAYLOR_H_
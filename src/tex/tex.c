@@ -5,6 +5,9 @@
  */
 
 #include "phrases.h"
+#include "../builtins/builtins.h"
+#include "../bytecode/bytecode.h"
+#include "../dag/dag.h"
 #include "../dsl/dsl.h"
 #include "../tree/token_specific.h"
 #include "../optimization/optimization.h"
@@ -12,12 +15,74 @@
 #include "../utilities/utilities.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 
 
 
+/*!
+ * @brief Label of big subexpression which was printed.
+ */
+struct tex_label
+{
+	size_t    number; /*!< number of label, 0 if subexpression has no label. */
+	bintree_t open;   /*!< root of subexpression while label is being
+	                       defined, else NULL.                               */
+	dag_t     outer;  /*!< label which was being defined when this one
+	                       was started.                                      */
+};
+
+/*!
+ * @brief Subexpression of printed expression.
+ */
+struct tex_subexpr
+{
+	bintree_t root; /*!< root of subexpression or BINTREE_NULL.              */
+	size_t    hash; /*!< hash of subexpression when it was interned.         */
+	dag_t     node; /*!< node of subexpression in the store of article.      */
+	size_t    size; /*!< amount of nodes in subexpression.                   */
+};
+
+/*!
+ * @brief Article in tex format.
+ */
+struct tex
+{
+	sink_t              sink;          /*!< output sink.                     */
+	dag_store_t         store;         /*!< every printed subexpression.     */
+	struct tex_label*   labels;        /*!< labels indexed by nodes
+	                                        of the store.                    */
+	size_t              capacity;      /*!< capacity of labels array.        */
+	size_t              amount;        /*!< amount of labels.                */
+	dag_t               open;          /*!< the innermost label which is
+	                                        being defined or DAG_NONE.       */
+	struct tex_subexpr* subexprs;      /*!< hash table of printed
+	                                        subexpressions keyed by roots.   */
+	size_t              subexprs_cap;  /*!< capacity of hash table,
+	                                        power of 2.                      */
+	size_t              subexprs_size; /*!< amount of subexpressions.        */
+};
+
+/*!
+ * @brief Initial capacity of labels array.
+ */
+static const size_t TEX_LABELS_INIT_CAPACITY = 64;
+
+/*!
+ * @brief Initial capacity of subexpressions hash table.
+ */
+static const size_t TEX_SUBEXPRS_INIT_CAPACITY = 256;
+
+/*!
+ * @brief The least size of subexpression which gets a label.
+ */
+static const size_t TEX_LABEL_MIN_SIZE = 16;
+
+
+
+
 /*!
  * @brief Check given token to be a special char.
  *
@@ -25,10 +90,10 @@
  */
 static bool spec_word
 (
-	const char* str /*!< [in] given identifier name.                         */
+	symbol_t ident /*!< [in] given identifier.                               */
 )
 {
-	return !strcmp(str, "pi") || !strcmp(str, "e");
+	return ident == SYMBOL_PI || ident == SYMBOL_E;
 }
 
 /*!
@@ -56,211 +121,740 @@ static int op_prior
 }
 
 /*!
- * @brief Print an expression in tex format.
+ * @brief Get priority of operation which contains subexpression.
+ *
+ * @return Priority number or -1 if subexpression is printed without brackets.
  */
-static void print_expr
+static int outer_prior
+(
+	const bintree_t root,      /*!< [in] printed expression.                 */
+	const bintree_t expression /*!< [in] its subexpression.                  */
+)
+{
+	if (D_NODE == root)
+		return -1;
+
+	bintree_t parent = BINTREE_NODE_PARENT(D_NODE);
+	token_t   t      = BINTREE_NODE_VALUE(parent);
+	if (t.type != TOKEN_OP)
+		return -1;
+
+	if (!BINTREE_NODE_LEFT(parent) || !BINTREE_NODE_RIGHT(parent))
+		return PARSER_MAX_PRIOR;
+
+	switch (t.value.operation)
+	{
+		case OP_DIV:
+			return -1;
+
+		case OP_POW:
+			return (BINTREE_NODE_LEFT(parent) == D_NODE)
+			       ? op_prior(OP_POW) + 1 : -1;
+
+		case OP_EMPTY:
+		case OP_PLUS:
+		case OP_MINUS:
+		case OP_MUL:
+		case OP_DERIV:
+		default:
+			return op_prior(t.value.operation);
+	}
+}
+
+/*!
+ * @brief Print part of node which is before its left subexpression.
+ */
+static void print_expr_open
 (
-	const bintree_t expression, /*!< [in,out] expression which will
-	                                          be printed.                    */
-	int             curr_prior, /*!< [in]    priority of current operation.  */
-	FILE*           output      /*!< [in,out] output stream.                 */
+	const bintree_t expression, /*!< [in]     printed node.                  */
+	int             curr_prior, /*!< [in]     priority of current operation. */
+	sink_t          output      /*!< [in,out] output sink.                   */
 )
 {
 	if (D_TYPE == TOKEN_NUMBER)
 	{
 		if (D_NUMBER < 0 && curr_prior != -1)
-				fputs("( ", output);
+				sink_puts(output, "( ");
 
-		fprintf(output, "%.2lf ",
-		        double_equal(D_NUMBER, 0) ? 0 : D_NUMBER);
+		sink_fixed(output, double_equal(D_NUMBER, 0) ? 0 : D_NUMBER);
+		sink_putc(output, ' ');
 		if (D_NUMBER < 0 && curr_prior != -1)
-				fputs(") ", output);
+				sink_puts(output, ") ");
 		return;
 	}
 
 	if (D_TYPE == TOKEN_VAR)
 	{
 		if (spec_word(D_IDENT))
-			fputc('\\', output);
+			sink_putc(output, '\\');
 
-		fprintf(output, "%s ", D_IDENT);
+		sink_puts(output, symbol_name(D_IDENT));
+		sink_putc(output, ' ');
 		return;
 	}
 
 	if (D_TYPE == TOKEN_FUNC)
 	{
-		fprintf(output, "\\operatorname{%s}(", D_IDENT);
-		print_expr(D_ARG, -1, output);
-		fputs(") ", output);
+		const builtin_rule_t* rule = builtin_rule(D_FUNC);
+		if (rule)
+			sink_puts(output, rule->tex_name);
+		else
+		{
+			sink_puts(output, "\\operatorname{");
+			sink_puts(output, symbol_name(D_IDENT));
+			sink_putc(output, '}');
+		}
+
+		sink_putc(output, '(');
+
 		return;
 	}
 
-	if (D_TYPE == TOKEN_OP)
+	if (D_TYPE != TOKEN_OP || D_ISPOSTUNARY)
+		return;
+
+	if (D_ISPREFUNARY)
 	{
-		int prior = op_prior(D_OP);
-		if (D_ISPREFUNARY)
+		if (curr_prior != -1)
+			sink_puts(output, "( ");
+
+		switch (D_OP)
 		{
-			if (curr_prior != -1)
-				fputs("( ", output);
+			case OP_PLUS:
+				sink_putc(output, '+');
+				break;
 
-			switch (D_OP)
-			{
-				case OP_PLUS:
-					fputc('+', output);
-					break;
+			case OP_MINUS:
+				sink_putc(output, '-');
+				break;
 
-				case OP_MINUS:
-					fputc('-', output);
-					break;
+			default:
+				break;
+		}
 
-				default:
-					break;
-			}
+		return;
+	}
 
-			print_expr(D_PREFARG, PARSER_MAX_PRIOR, output);
-			if (curr_prior != -1)
-				fputs(") ", output);
+	if (op_prior(D_OP) < curr_prior)
+		sink_putc(output, '(');
 
-			return;
+	if (D_OP == OP_DIV)
+		sink_puts(output, "\\frac{");
+}
+
+/*!
+ * @brief Print part of binary operation which is between its operands.
+ */
+static void print_expr_middle
+(
+	const bintree_t expression, /*!< [in]     printed node.                  */
+	sink_t          output      /*!< [in,out] output sink.                   */
+)
+{
+	if (D_TYPE != TOKEN_OP || !D_ISBINOP)
+		return;
+
+	switch (D_OP)
+	{
+		case OP_PLUS:
+			sink_puts(output, "+ ");
+			break;
+
+		case OP_MINUS:
+			sink_puts(output, "- ");
+			break;
+
+		case OP_MUL:
+			sink_puts(output, "\\cdot ");
+			break;
+
+		case OP_DIV:
+			sink_puts(output, "}{");
+			break;
+
+		case OP_POW:
+			sink_puts(output, "^{");
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*!
+ * @brief Print part of node which is after its right subexpression.
+ */
+static void print_expr_close
+(
+	const bintree_t expression, /*!< [in]     printed node.                  */
+	int             curr_prior, /*!< [in]     priority of current operation. */
+	sink_t          output      /*!< [in,out] output sink.                   */
+)
+{
+	if (D_TYPE == TOKEN_FUNC)
+	{
+		sink_puts(output, ") ");
+		return;
+	}
+
+	if (D_TYPE != TOKEN_OP)
+		return;
+
+	if (D_ISPREFUNARY)
+	{
+		if (curr_prior != -1)
+			sink_puts(output, ") ");
+
+		return;
+	}
+
+	if (D_ISPOSTUNARY)
+	{
+		if (D_OP == OP_DERIV)
+			sink_putc(output, '\'');
+
+		return;
+	}
+
+	if (D_OP == OP_DIV || D_OP == OP_POW)
+		sink_puts(output, "} ");
+
+	if (op_prior(D_OP) < curr_prior)
+		sink_putc(output, ')');
+}
+
+/*!
+ * @brief Find slot of subexpression in the hash table of article.
+ *
+ * @return Slot with given root or empty slot where it should be added.
+ */
+static struct tex_subexpr* tex_subexpr_slot
+(
+	const tex_t     tex, /*!< [in] article.                                  */
+	const bintree_t root /*!< [in] root of subexpression.                    */
+)
+{
+	size_t mask  = tex->subexprs_cap - 1;
+	size_t index = hash_bytes(&root, sizeof root) & mask;
+	while (tex->subexprs[index].root && tex->subexprs[index].root != root)
+		index = (index + 1) & mask;
+
+	return &tex->subexprs[index];
+}
+
+/*!
+ * @brief Find subexpression which was interned before.
+ *
+ * @note Subexpression is trusted while its root keeps the hash,
+ * changes of tree drop cached hashes of changed nodes and of their
+ * ancestors (see bintree_hash()).
+ *
+ * @return Subexpression or NULL if it isn't interned or was changed.
+ */
+static const struct tex_subexpr* tex_subexpr_find
+(
+	const tex_t     tex, /*!< [in] article.                                  */
+	const bintree_t root /*!< [in] root of subexpression.                    */
+)
+{
+	const struct tex_subexpr* slot = tex_subexpr_slot(tex, root);
+	return (slot->root == root && slot->hash == bintree_hash(root))
+	       ? slot : NULL;
+}
+
+/*!
+ * @brief Remember subexpression in the hash table of article.
+ *
+ * @return True if subexpression is added else false.
+ */
+static bool tex_subexpr_add
+(
+	tex_t                     tex,    /*!< [in,out] article.                 */
+	const struct tex_subexpr* subexpr /*!< [in]     subexpression.           */
+)
+{
+	if ((tex->subexprs_size + 1) * 2 > tex->subexprs_cap)
+	{
+		struct tex_subexpr* old      = tex->subexprs;
+		size_t              old_cap  = tex->subexprs_cap;
+		struct tex_subexpr* subexprs = (struct tex_subexpr*)
+		                               calloc(old_cap * 2, sizeof *subexprs);
+		if (!subexprs)
+			return false;
+
+		tex->subexprs     = subexprs;
+		tex->subexprs_cap = old_cap * 2;
+		for (size_t i = 0; i < old_cap; ++i)
+			if (old[i].root)
+				*tex_subexpr_slot(tex, old[i].root) = old[i];
+
+		free(old);
+	}
+
+	struct tex_subexpr* slot = tex_subexpr_slot(tex, subexpr->root);
+	if (!slot->root)
+		++tex->subexprs_size;
+
+	*slot = *subexpr;
+	return true;
+}
+
+/*!
+ * @brief Add every subexpression of printed expression to the store
+ * of article.
+ *
+ * @note Only subexpressions which were changed since they were interned
+ * last time are visited, so every printed tree is walked once
+ * however many times its subexpressions are printed.
+ *
+ * @return Subexpression or NULL if an error occurred.
+ */
+static const struct tex_subexpr* tex_intern
+(
+	tex_t           tex,       /*!< [in,out] article.                        */
+	const bintree_t expression /*!< [in]     printed expression.             */
+)
+{
+	// Children are interned before their parent in post-order.
+	const struct tex_subexpr* found = NULL;
+	bintree_t                 node  = expression;
+	while (!(found = tex_subexpr_find(tex, expression)))
+	{
+		bintree_t                 left  = BINTREE_NODE_LEFT(node);
+		bintree_t                 right = BINTREE_NODE_RIGHT(node);
+		const struct tex_subexpr* lhs   = (left)
+		                                  ? tex_subexpr_find(tex, left)
+		                                  : NULL;
+		if (left && !lhs)
+		{
+			node = left;
+			continue;
 		}
 
-		if (D_ISPOSTUNARY)
+		const struct tex_subexpr* rhs   = (right)
+		                                  ? tex_subexpr_find(tex, right)
+		                                  : NULL;
+		if (right && !rhs)
 		{
-			print_expr(D_POSTARG, PARSER_MAX_PRIOR, output);
-			switch (D_OP)
-			{
-				case OP_DERIV:
-					fputc('\'', output);
-					break;
+			node = right;
+			continue;
+		}
 
-				default:
-					break;
-			}
+		struct tex_subexpr subexpr =
+		{
+			node,
+			bintree_hash(node),
+			dag_intern(tex->store, &BINTREE_NODE_VALUE(node),
+			           (lhs) ? lhs->node : DAG_NONE,
+			           (rhs) ? rhs->node : DAG_NONE),
+			1 + ((lhs) ? lhs->size : 0) + ((rhs) ? rhs->size : 0),
+		};
+
+		if (subexpr.node == DAG_NONE || !tex_subexpr_add(tex, &subexpr))
+			return NULL;
+
+		if (node != expression)
+			node = BINTREE_NODE_PARENT(node);
+	}
 
-			return;
+	// Every node of the store can get a label.
+	size_t capacity = tex->capacity;
+	while (capacity <= dag_store_size(tex->store))
+		capacity *= 2;
+
+	if (capacity != tex->capacity)
+	{
+		void* check = realloc(tex->labels, capacity * sizeof *tex->labels);
+		if (!check)
+			return NULL;
+
+		tex->labels = (struct tex_label*) check;
+		memset(tex->labels + tex->capacity, 0,
+		       (capacity - tex->capacity) * sizeof *tex->labels);
+		tex->capacity = capacity;
+	}
+
+	return found;
+}
+
+/*!
+ * @brief Print label instead of subexpression which was printed before,
+ * or start definition of label if subexpression is big.
+ *
+ * @return True if label is printed instead of subexpression.
+ */
+static bool print_label_open
+(
+	tex_t                     tex,        /*!< [in,out] article.             */
+	const bintree_t           expression, /*!< [in]     subexpression.       */
+	const struct tex_subexpr* subexpr,    /*!< [in]     its node and size.   */
+	sink_t                    output      /*!< [in,out] output sink.         */
+)
+{
+	struct tex_label* label = &tex->labels[subexpr->node];
+	if (label->number)
+	{
+		sink_puts(output, "u_{");
+		sink_integer(output, (long long) label->number);
+		sink_puts(output, "} ");
+		return true;
+	}
+
+	if (subexpr->size < TEX_LABEL_MIN_SIZE)
+		return false;
+
+	label->number = ++tex->amount;
+	label->open   = expression;
+	label->outer  = tex->open;
+	tex->open     = subexpr->node;
+	sink_puts(output, "\\underbrace{");
+	return false;
+}
+
+/*!
+ * @brief Finish definition of label if subexpression has started it.
+ */
+static void print_label_close
+(
+	tex_t           tex,        /*!< [in,out] article.                       */
+	const bintree_t expression, /*!< [in]     subexpression.                 */
+	sink_t          output      /*!< [in,out] output sink.                   */
+)
+{
+	// Definitions of labels are nested like subexpressions.
+	if (tex->open == DAG_NONE || tex->labels[tex->open].open != expression)
+		return;
+
+	struct tex_label* label = &tex->labels[tex->open];
+	sink_puts(output, "}_{u_{");
+	sink_integer(output, (long long) label->number);
+	sink_puts(output, "}} ");
+	label->open = BINTREE_NULL;
+	tex->open   = label->outer;
+}
+
+/*!
+ * @brief Print an expression in tex format.
+ */
+static void print_expr
+(
+	const bintree_t root,   /*!< [in]     expression which will be printed.  */
+	tex_t           tex,    /*!< [in,out] article whose labels are used
+	                                      or NULL.                           */
+	sink_t          output  /*!< [in,out] output sink.                       */
+)
+{
+	// Labels which are being defined are closed even if new ones
+	// can't be found.
+	bool find = tex != NULL;
+
+	// Every node is printed in three parts around its subexpressions,
+	// direction shows which of them is printed next.
+	bintree_t           node = root;
+	bintree_direction_t from = BINTREE_STAY;
+	while (true)
+	{
+		int                       curr_prior = outer_prior(root, node);
+		const struct tex_subexpr* subexpr    = (from == BINTREE_STAY && find)
+		                                       ? tex_intern(tex, node) : NULL;
+		if (from == BINTREE_STAY && find && !subexpr)
+		{
+			fputs("Cannot find labels of expression.\n\n", stderr);
+			find = false;
 		}
 
-		if (prior < curr_prior)
-			fputc('(', output);
-		
-		switch (D_OP)
+		bool labelled = subexpr && print_label_open(tex, node, subexpr,
+		                                            output);
+
+		if (!labelled && from == BINTREE_STAY)
 		{
-			case OP_PLUS:
-				print_expr(D_LHS, prior, output);
-				fputs("+ ", output);
-				print_expr(D_RHS, prior, output);
-				break;
+			print_expr_open(node, curr_prior, output);
+			if (BINTREE_NODE_LEFT(node))
+			{
+				node = BINTREE_NODE_LEFT(node);
+				continue;
+			}
 
-			case OP_MINUS:
-				print_expr(D_LHS, prior, output);
-				fputs("- ", output);
-				print_expr(D_RHS, prior, output);
-				break;
+			from = BINTREE_LEFT;
+		}
 
-			case OP_MUL:
-				print_expr(D_LHS, prior, output);
-				fputs("\\cdot ", output);
-				print_expr(D_RHS, prior, output);
-				break;
+		if (!labelled && from == BINTREE_LEFT)
+		{
+			print_expr_middle(node, output);
+			if (BINTREE_NODE_RIGHT(node))
+			{
+				node = BINTREE_NODE_RIGHT(node);
+				from = BINTREE_STAY;
+				continue;
+			}
+		}
 
-			case OP_DIV:
-				fputs("\\frac{", output);
-				print_expr(D_LHS, -1, output);
-				fputs("}{", output);
-				print_expr(D_RHS, -1, output);
-				fputs("} ", output);
-				break;
+		if (!labelled)
+			print_expr_close(node, curr_prior, output);
 
-			case OP_POW:
-				print_expr(D_LHS, prior + 1, output);
-				fputs("^{", output);
-				print_expr(D_RHS, -1, output);
-				fputs("} ", output);
-				break;
+		if (!labelled && tex)
+			print_label_close(tex, node, output);
 
-			default:
-				break;
-		}
+		if (node == root)
+			return;
 
-		if (prior < curr_prior)
-			fputc(')', output);
+		bintree_t parent = BINTREE_NODE_PARENT(node);
+		from = (BINTREE_NODE_LEFT(parent) == node) ? BINTREE_LEFT
+		                                           : BINTREE_RIGHT;
+		node = parent;
 	}
 }
 
+/*!
+ * @brief Print absolute value of series coefficient in tex format.
+ *
+ * @note Very small and very big numbers are printed in scientific notation
+ * since high order coefficients don't fit in fixed point.
+ */
+static void print_coefficient
+(
+	double num,   /*!< [in]     coefficient.                                 */
+	sink_t output /*!< [in,out] output sink.                                 */
+)
+{
+	num = fabs(num);
+	if (!isfinite(num) || (num >= 0.01 && num < 1e6))
+	{
+		sink_fixed(output, num);
+		sink_putc(output, ' ');
+		return;
+	}
+
+	int exponent = (int) floor(log10(num));
+	sink_fixed(output, num / pow(10, exponent));
+	sink_puts(output, " \\cdot 10^{");
+	sink_integer(output, exponent);
+	sink_puts(output, "} ");
+}
+
+/*!
+ * @brief Print remainder term, finish article and free its memory.
+ *
+ * @return Success of writing of article.
+ */
+static bool close_article
+(
+	tex_t  tex,       /*!< [in,out] article.                                 */
+	size_t max_deriv, /*!< [in]     amount of derivatives.                   */
+	double val        /*!< [in]     value for substitution.                  */
+)
+{
+	sink_puts(tex->sink, "+ o((x - ");
+	sink_fixed(tex->sink, val);
+	sink_puts(tex->sink, ")^");
+	sink_integer(tex->sink, (long long) max_deriv);
+	sink_puts(tex->sink, ")\\end{dmath*}\n\n");
+	sink_puts(tex->sink, TEX_FINAL);
+
+	bool ret = sink_flush(tex->sink);
+	if (!ret)
+		fputs("Cannot write tex file.\n\n", stderr);
+
+	abort_article(tex);
+	return ret;
+}
+
 
 
 
-FILE* start_article (const bintree_t expression, size_t max_deriv)
+tex_t start_article (sink_t output, const bintree_t expression,
+                     size_t max_deriv)
 {
+	assert (output);
 	assert (expression);
 
-	FILE* tex = fopen("Taylor.tex", "w");
+	tex_t tex = (tex_t) calloc(1, sizeof *tex);
 	if (!tex)
 	{
-		perror("Cannot create tex file");
+		fputs("Cannot allocate memory for article.\n\n", stderr);
+		return NULL;
+	}
+
+	tex->capacity = TEX_LABELS_INIT_CAPACITY;
+	tex->labels   = (struct tex_label*) calloc(tex->capacity,
+	                                           sizeof *tex->labels);
+	tex->store    = dag_store_create();
+
+	tex->subexprs_cap = TEX_SUBEXPRS_INIT_CAPACITY;
+	tex->subexprs     = (struct tex_subexpr*) calloc(tex->subexprs_cap,
+	                                                 sizeof *tex->subexprs);
+	if (!tex->labels || !tex->store || !tex->subexprs)
+	{
+		fputs("Cannot allocate memory for article.\n\n", stderr);
+		dag_store_destroy(tex->store);
+		free(tex->subexprs);
+		free(tex->labels);
+		free(tex);
 		return NULL;
 	}
 
-	fputs(TEX_PREAMBLE, tex);
-	print_expression(expression, tex);
-	fprintf(tex, "%s%zd%s", TEX_PREAMBLE_1, max_deriv, tEX_PREAMBLE_2);
+	tex->sink = output;
+	sink_puts(tex->sink, TEX_PREAMBLE);
+	print_expression(expression, tex->sink);
+	sink_puts(tex->sink, TEX_PREAMBLE_1);
+	sink_integer(tex->sink, (long long) max_deriv);
+	sink_puts(tex->sink, tEX_PREAMBLE_2);
 	return tex;
 }
 
 
-void finish_article (FILE* tex, const bintree_t* derivatives,
+bool finish_article (tex_t tex, const bintree_t* derivatives,
                      size_t max_deriv, double val)
 {
 	assert (tex);
 	assert (derivatives);
 
-	fprintf(tex, "%s%.2lf%s\\begin{dmath*}", TEX_TAYLOR, val, TEX_TAYLOR_1);
-	print_expression(derivatives[0], tex);
-	fputs(" = ", tex);
-	print_expression_at(derivatives[0], val, tex);
+	sink_t output = tex->sink;
+	sink_puts(output, TEX_TAYLOR);
+	sink_fixed(output, val);
+	sink_puts(output, TEX_TAYLOR_1);
+	sink_puts(output, "\\begin{dmath*}");
+	print_expression(derivatives[0], output);
+	sink_puts(output, " = ");
+	print_expression_at(derivatives[0], val, output);
 	for (size_t i = 1; i <= max_deriv; ++i)
 	{
-		fputs("+ \\frac{", tex);
-		print_expression_at(derivatives[i], val, tex);
-		fprintf(tex, "}{%zd!} \\cdot (x - %.2lf)^%zd ", i, val, i);
+		sink_puts(output, "+ \\frac{");
+		print_expression_at(derivatives[i], val, output);
+		sink_puts(output, "}{");
+		sink_integer(output, (long long) i);
+		sink_puts(output, "!} \\cdot (x - ");
+		sink_fixed(output, val);
+		sink_puts(output, ")^");
+		sink_integer(output, (long long) i);
+		sink_putc(output, ' ');
 	}
 
-	fprintf(tex, "+ o((x - %.2lf)^%zd)\\end{dmath*}\n\n", val, max_deriv);
-	fputs(TEX_FINAL, tex);
-	fclose(tex);
-	system("pdflatex -interaction=nonstopmode -halt-on-error Taylor.tex "
-	       ">/dev/null 2>/dev/null");
+	return close_article(tex, max_deriv, val);
+}
+
+
+bool finish_article_series (tex_t tex, const bintree_t expression,
+                            const double* coefficients,
+                            size_t max_deriv, double val)
+{
+	assert (tex);
+	assert (expression);
+	assert (coefficients);
+
+	sink_t output = tex->sink;
+	sink_puts(output, TEX_TAYLOR);
+	sink_fixed(output, val);
+	sink_puts(output, TEX_TAYLOR_1);
+	sink_puts(output, "\\begin{dmath*}");
+	print_expression(expression, output);
+	sink_puts(output, " = ");
+
+	// Zero coefficients are skipped, for example every second one of sine.
+	bool first = true;
+	for (size_t i = 0; i <= max_deriv; ++i)
+	{
+		double num = coefficients[i];
+		if (fpclassify(num) == FP_ZERO)
+			continue;
+
+		if (num < 0)
+			sink_puts(output, "- ");
+		else if (!first)
+			sink_puts(output, "+ ");
+
+		print_coefficient(num, output);
+		if (i > 0)
+		{
+			sink_puts(output, "\\cdot (x - ");
+			sink_fixed(output, val);
+			sink_puts(output, (i > 1) ? ")^{" : ") ");
+		}
+
+		if (i > 1)
+		{
+			sink_integer(output, (long long) i);
+			sink_puts(output, "} ");
+		}
+
+		first = false;
+	}
+
+	if (first)
+		sink_puts(output, "0 ");
+
+	return close_article(tex, max_deriv, val);
 }
 
 
 void print_expression_at (const bintree_t expr,
-                          double substitute, FILE* output)
+                          double substitute, sink_t output)
 {
 	assert (expr);
 	assert (output);
 
+	// Expression which can be evaluated numerically is printed as a number,
+	// others are simplified after substitution.
+	bytecode_t code = bytecode_compile(expr);
+	if (code)
+	{
+		double value = bytecode_evaluate(code, substitute);
+		sink_fixed(output, double_equal(value, 0) ? 0 : value);
+		sink_putc(output, ' ');
+		bytecode_destroy(code);
+		return;
+	}
+
 	bintree_t sub = expression_substitute(expr, substitute);
 	sub = tree_optimize(sub);
-	print_expr(sub, -1, output);
+	print_expr(sub, NULL, output);
 	bintree_destroy(sub);
 }
 
 
-void print_expression (const bintree_t expr, FILE* output)
+void abort_article (tex_t tex)
+{
+	assert (tex);
+
+	dag_store_destroy(tex->store);
+	free(tex->subexprs);
+	free(tex->labels);
+	free(tex);
+}
+
+
+sink_t tex_sink (const tex_t tex)
+{
+	assert (tex);
+
+	return tex->sink;
+}
+
+
+void print_labelled_expression (tex_t tex, const bintree_t expression)
+{
+	assert (tex);
+	assert (expression);
+
+	print_expr(expression, tex, tex->sink);
+}
+
+
+void print_expression (const bintree_t expr, sink_t output)
 {
 	assert (expr);
 	assert (output);
 
-	print_expr(expr, -1, output);
+	print_expr(expr, NULL, output);
 }
 
 
-void print_context (const tex_context_t context, FILE* output)
+void print_context (const tex_context_t context, sink_t output)
 {
 	size_t size = 0;
 	while (TEX_PHRASES[context][size])
 		++size;
 
 	size_t random = (size_t) rand() % size;
-	fputs(TEX_PHRASES[context][random], output);
+	sink_puts(output, TEX_PHRASES[context][random]);
 }
@@ -6,6 +6,7 @@
 #ifndef TEX_H_
 #define TEX_H_
 
+#include "../sink/sink.h"
 #include "../tree/bintree.h"
 
 #include <stdio.h>
@@ -34,27 +35,98 @@ enum contexts
 };
 
 /*!
- * @brief Start article about Taylor's series in tex file.
+ * @brief Article in tex format.
  *
- * @return File with started article or NULL.
+ * Article remembers big subexpressions which were printed by
+ * print_labelled_expression(), they get labels at their first appearance
+ * and only labels are printed later.
+ *
+ * @note Articles with different sinks can be written by several threads
+ * at once if every thread selects its own node arena for its trees
+ * (see bintree_arena_select()).
+ */
+typedef struct tex* tex_t;
+
+/*!
+ * @brief Start article about Taylor's series in tex format.
+ *
+ * @note Article doesn't own output sink, it should be destroyed
+ * by the caller after the article is finished or aborted.
+ *
+ * @return Started article or NULL.
  */
-FILE* start_article
+tex_t start_article
 (
-	const bintree_t expression, /*!< [in] an initial expression.              */
-	size_t          max_deriv   /*!< [in] maximal derivative.                */
+	sink_t          output,     /*!< [in,out] output sink.                   */
+	const bintree_t expression, /*!< [in]     an initial expression.         */
+	size_t          max_deriv   /*!< [in]     maximal derivative.            */
 );
 
 /*!
+ * @brief Finish article using derivatives and free its memory.
  *
+ * @return Success of writing of article.
  */
-void finish_article
+bool finish_article
 (
-	FILE*            tex,         /*!< [in,out] tex file stream.             */
+	tex_t            tex,         /*!< [in,out] article.                     */
 	const bintree_t* derivatives, /*!< [in]     array with derivatives.      */
 	size_t           max_deriv,   /*!< [in]     amount of derivatives.       */
 	double           val          /*!< [in]     value for substitution.	     */
 );
 
+/*!
+ * @brief Finish article using numeric Taylor coefficients
+ * and free its memory.
+ *
+ * @note coefficients[i] is i-th derivative at val divided by i!.
+ *
+ * @return Success of writing of article.
+ */
+bool finish_article_series
+(
+	tex_t           tex,          /*!< [in,out] article.                     */
+	const bintree_t expression,   /*!< [in]     an initial expression.       */
+	const double*   coefficients, /*!< [in]     array with coefficients.     */
+	size_t          max_deriv,    /*!< [in]     amount of derivatives.       */
+	double          val           /*!< [in]     value for substitution.      */
+);
+
+/*!
+ * @brief Free memory of article without finishing it.
+ */
+void abort_article
+(
+	tex_t tex /*!< [in,out] article.                                         */
+);
+
+/*!
+ * @brief Get output sink of article.
+ *
+ * @return Output sink.
+ */
+sink_t tex_sink
+(
+	const tex_t tex /*!< [in] article.                                       */
+);
+
+/*!
+ * @brief Print an expression to article in tex format.
+ *
+ * Subexpression which was printed before is replaced by its label.
+ * Big subexpression which is printed the first time is underbraced
+ * with a new label.
+ *
+ * @note Printed subexpressions are interned in the store of article,
+ * so only identical subexpressions share a label.
+ */
+void print_labelled_expression
+(
+	tex_t           tex,       /*!< [in,out] article.                        */
+	const bintree_t expression /*!< [in]     expression which will
+	                                         be printed.                     */
+);
+
 /*!
  * @brief Print an expression in tex format.
  */
@@ -63,7 +135,7 @@ void print_expression_at
 	const bintree_t expression,   /*!< [in]     expression which will
 	                                            be printed.                  */
 	double          substitution, /*!< [in]     value for substitution.      */
-	FILE*           output        /*!< [in,out] output stream.               */
+	sink_t          output        /*!< [in,out] output sink.                 */
 );
 
 /*!
@@ -73,7 +145,7 @@ void print_expression
 (
 	const bintree_t expression, /*!< [in]     expression which will
 	                                          be printed.                    */
-	FILE*           output      /*!< [in,out] output stream.                 */
+	sink_t          output      /*!< [in,out] output sink.                   */
 );
 
 /*!
@@ -84,7 +156,7 @@ void print_expression
 void print_context
 (
 	const tex_context_t context, /*!< [in]     given context.                */
-	FILE*               output   /*!< [in,out] tex file.                     */
+	sink_t              output   /*!< [in,out] output sink.                  */
 );
 
 
@@ -8,71 +8,457 @@
 #include "../utilities/utilities.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 
 
 
 
+#ifdef BINTREE_COMPACT
+
+/*!
+ * @brief Node arena.
+ */
+struct bintree_arena
+{
+	struct bintree_storage storage;   /*!< node arrays.                      */
+	size_t                 size;      /*!< amount of used nodes including
+	                                       node 0 which isn't used.          */
+	size_t                 capacity;  /*!< capacity of node arrays.          */
+	bintree_t              free_list; /*!< list of released nodes.           */
+};
+
+/*!
+ * @brief Arena which is used if no other arena was selected.
+ */
+static struct bintree_arena bintree_default_arena;
+
+_Thread_local struct bintree_storage bintree_storage_;
+
+#else // not defined BINTREE_COMPACT
+
 /*!
- * @brief Deserialize binary tree recursively.
+ * @brief Chunk of nodes in the node arena.
  *
- * @return Binary tree or NULL if an error occurred during processing this
- * function.
+ * @note Chunks are aligned to their size, so chunk of node is found
+ * by its address.
  */
-static bintree_t bintree_deserialize_
+struct bintree_arena_chunk
+{
+	struct bintree_arena_chunk* next;    /*!< next chunk.                    */
+	bintree_arena_t             arena;   /*!< arena which owns the chunk.    */
+	struct bintree_node         nodes[]; /*!< nodes of the chunk.            */
+};
+
+/*!
+ * @brief Node arena.
+ */
+struct bintree_arena
+{
+	struct bintree_arena_chunk* chunks;    /*!< list of all chunks.          */
+	struct bintree_arena_chunk* current;   /*!< chunk for new nodes.         */
+	size_t                      used;      /*!< used nodes in current chunk. */
+	bintree_t                   free_list; /*!< list of released nodes.      */
+};
+
+/*!
+ * @brief Arena which is used if no other arena was selected.
+ */
+static struct bintree_arena bintree_default_arena = {NULL, NULL, 0, NULL};
+
+#endif // not defined BINTREE_COMPACT
+
+/*!
+ * @brief Arena which new nodes are allocated from, every thread selects
+ * its own one.
+ */
+static _Thread_local bintree_arena_t bintree_selected_arena
+	= &bintree_default_arena;
+
+
+
+
+#ifdef BINTREE_COMPACT
+
+/*!
+ * @brief Increase capacity of arena twice.
+ *
+ * @return Success of growing.
+ */
+static bool bintree_arena_grow
 (
-	const char* str,       /*!< [in]     input string.                       */
-	size_t*     curr_index /*!< [in,out] index of processing character.      */
+	bintree_arena_t arena /*!< [in,out] node arena.                          */
 )
 {
-	const char* curr_ptr = strpbrk(str + *curr_index, "{\"}");
-	if (!curr_ptr || *curr_ptr != '{')
-		return NULL;
+	if (arena->capacity >= UINT32_MAX)
+		return false;
+
+	size_t capacity = (arena->capacity)
+	                  ? arena->capacity * 2 : BINTREE_ARENA_CHUNK;
+	struct bintree_storage* storage = &arena->storage;
+#ifdef BINTREE_COMPACT_SOA
+	// All arrays are placed in one block. Wider elements go first
+	// to be aligned.
+	void* check = malloc(capacity * (sizeof *storage->value
+	                                 + sizeof *storage->hash
+	                                 + 3 * sizeof (bintree_t)));
+	if (!check)
+		return false;
+
+	struct bintree_storage grown = {.value = (BINTREE_VALUE_T*) check};
+	grown.hash   = (size_t*) (grown.value + capacity);
+	grown.left   = (bintree_t*) (grown.hash + capacity);
+	grown.right  = grown.left  + capacity;
+	grown.parent = grown.right + capacity;
+	size_t size = arena->size;
+	if (size)
+	{
+		memcpy(grown.value,  storage->value,  size * sizeof *grown.value);
+		memcpy(grown.hash,   storage->hash,   size * sizeof *grown.hash);
+		memcpy(grown.left,   storage->left,   size * sizeof *grown.left);
+		memcpy(grown.right,  storage->right,  size * sizeof *grown.right);
+		memcpy(grown.parent, storage->parent, size * sizeof *grown.parent);
+	}
 
-	++curr_ptr;
-	bintree_t node = (bintree_t) calloc(1, sizeof *node);
+	free(storage->value);
+	*storage = grown;
+#else
+	void* check = realloc(storage->nodes, capacity * sizeof *storage->nodes);
+	if (!check)
+		return false;
+
+	storage->nodes = (struct bintree_node*) check;
+#endif
+
+	arena->capacity = capacity;
+	if (arena == bintree_selected_arena)
+		bintree_storage_ = *storage;
+
+	return true;
+}
+
+/*!
+ * @brief Allocate node from the selected arena.
+ *
+ * @return Node filled by zeros or BINTREE_NULL if an error occurred.
+ */
+static bintree_t bintree_node_alloc (void)
+{
+	bintree_arena_t arena = bintree_selected_arena;
+	bintree_t       node  = arena->free_list;
+	if (node)
+	{
+		arena->free_list = BINTREE_NODE_LEFT(node);
+	}
+	else
+	{
+		if (arena->size == arena->capacity && !bintree_arena_grow(arena))
+			return BINTREE_NULL;
+
+		// Node 0 is BINTREE_NULL and isn't used.
+		if (!arena->size)
+			arena->size = 1;
+
+		node = (bintree_t) arena->size++;
+	}
+
+	BINTREE_NODE_LEFT(node)   = BINTREE_NULL;
+	BINTREE_NODE_RIGHT(node)  = BINTREE_NULL;
+	BINTREE_NODE_PARENT(node) = BINTREE_NULL;
+	BINTREE_NODE_HASH(node)   = 0;
+	memset(&BINTREE_NODE_VALUE(node), 0, sizeof (BINTREE_VALUE_T));
+	return node;
+}
+
+#else // not defined BINTREE_COMPACT
+
+/*!
+ * @brief Size of chunk in bytes, the least power of 2 which fits
+ * BINTREE_ARENA_CHUNK nodes. Bits of the size without one are spread
+ * to the right and one is added.
+ */
+enum
+{
+	BINTREE_CHUNK_BITS_0  = sizeof (struct bintree_arena_chunk)
+	                        + BINTREE_ARENA_CHUNK * sizeof (struct bintree_node)
+	                        - 1,
+	BINTREE_CHUNK_BITS_1  = BINTREE_CHUNK_BITS_0 | BINTREE_CHUNK_BITS_0 >> 1,
+	BINTREE_CHUNK_BITS_2  = BINTREE_CHUNK_BITS_1 | BINTREE_CHUNK_BITS_1 >> 2,
+	BINTREE_CHUNK_BITS_4  = BINTREE_CHUNK_BITS_2 | BINTREE_CHUNK_BITS_2 >> 4,
+	BINTREE_CHUNK_BITS_8  = BINTREE_CHUNK_BITS_4 | BINTREE_CHUNK_BITS_4 >> 8,
+	BINTREE_CHUNK_BITS_16 = BINTREE_CHUNK_BITS_8 | BINTREE_CHUNK_BITS_8 >> 16,
+	BINTREE_CHUNK_BYTES   = BINTREE_CHUNK_BITS_16 + 1,
+};
+
+/*!
+ * @brief Get amount of nodes in one chunk.
+ *
+ * @return Amount of nodes.
+ */
+static size_t bintree_chunk_capacity (void)
+{
+	return ((size_t) BINTREE_CHUNK_BYTES - sizeof (struct bintree_arena_chunk))
+	       / sizeof (struct bintree_node);
+}
+
+/*!
+ * @brief Get chunk which node was allocated from.
+ *
+ * @return Chunk of node.
+ */
+static struct bintree_arena_chunk* bintree_node_chunk
+(
+	bintree_t node /*!< [in] node.                                           */
+)
+{
+	return (struct bintree_arena_chunk*)
+	       ((uintptr_t) node & ~(uintptr_t) (BINTREE_CHUNK_BYTES - 1));
+}
+
+/*!
+ * @brief Allocate node from the selected arena.
+ *
+ * @return Node filled by zeros or NULL if an error occurred.
+ */
+static bintree_t bintree_node_alloc (void)
+{
+	bintree_arena_t arena = bintree_selected_arena;
+	bintree_t       node  = arena->free_list;
+	if (node)
+	{
+		arena->free_list = BINTREE_NODE_LEFT(node);
+		memset(node, 0, sizeof *node);
+		return node;
+	}
+
+	if (!arena->current || arena->used == bintree_chunk_capacity())
+	{
+		struct bintree_arena_chunk* next = (arena->current)
+		                                   ? arena->current->next
+		                                   : arena->chunks;
+		if (!next)
+		{
+			next = (struct bintree_arena_chunk*)
+			       aligned_alloc(BINTREE_CHUNK_BYTES, BINTREE_CHUNK_BYTES);
+			if (!next)
+				return NULL;
+
+			next->next  = NULL;
+			next->arena = arena;
+			if (arena->current)
+				arena->current->next = next;
+			else
+				arena->chunks = next;
+		}
+
+		arena->current = next;
+		arena->used    = 0;
+	}
+
+	node = &arena->current->nodes[arena->used++];
+	memset(node, 0, sizeof *node);
+	return node;
+}
+
+#endif // not defined BINTREE_COMPACT
+
+/*!
+ * @brief Return node to the free list of the arena it was allocated from.
+ *
+ * @note Value of the node should be destroyed before.
+ */
+static void bintree_node_release
+(
+	bintree_t node /*!< [in,out] released node.                              */
+)
+{
+#ifdef BINTREE_COMPACT
+	// Index doesn't show its arena, it can be only checked to be
+	// allocated from the selected one.
+	bintree_arena_t arena = bintree_selected_arena;
+	assert (node < arena->size);
+#else
+	bintree_arena_t arena = bintree_node_chunk(node)->arena;
+#endif
+
+	BINTREE_NODE_LEFT(node)   = arena->free_list;
+	BINTREE_NODE_RIGHT(node)  = BINTREE_NULL;
+	BINTREE_NODE_PARENT(node) = BINTREE_NULL;
+	arena->free_list          = node;
+}
+
+/*!
+ * @brief Destroy values of all nodes which were allocated from the arena.
+ */
+static void bintree_arena_destroy_values
+(
+	bintree_arena_t arena /*!< [in,out] node arena.                          */
+)
+{
+#if defined(BINTREE_VALUE_TRIVIAL)
+	MAYBE_UNUSED(arena);
+	return;
+#elif defined(BINTREE_COMPACT)
+	// Values are reached through the selected arena only.
+	bintree_arena_t prev = bintree_arena_select(arena);
+	for (size_t i = 1; i < arena->size; ++i)
+		BINTREE_VALUE_DESTROY(BINTREE_NODE_VALUE((bintree_t) i));
+
+	bintree_arena_select(prev);
+#else
+	if (!arena->current)
+		return;
+
+	for (struct bintree_arena_chunk* chunk = arena->chunks;
+	     chunk; chunk = chunk->next)
+	{
+		size_t used = (chunk == arena->current)
+		              ? arena->used : bintree_chunk_capacity();
+		for (size_t i = 0; i < used; ++i)
+			BINTREE_VALUE_DESTROY(chunk->nodes[i].value);
+
+		if (chunk == arena->current)
+			break;
+	}
+#endif
+}
+
+/*!
+ * @brief Drop cached hash of node and of its ancestors which still have it.
+ *
+ * @note Node without cached hash never has ancestors with cached hash,
+ * so going up stops on the first such ancestor.
+ */
+static void bintree_invalidate
+(
+	bintree_t node /*!< [in,out] changed node or BINTREE_NULL.               */
+)
+{
 	if (!node)
-		return NULL;
+		return;
 
-	*curr_index = (size_t) (curr_ptr - str);
-	node->left = bintree_deserialize_(str, curr_index);
+	BINTREE_NODE_HASH(node) = 0;
+	for (node = BINTREE_NODE_PARENT(node);
+	     node && BINTREE_NODE_HASH(node); node = BINTREE_NODE_PARENT(node))
+		BINTREE_NODE_HASH(node) = 0;
+}
 
-	curr_ptr = strchr(str + *curr_index, '\"');
+/*!
+ * @brief Part of node which is expected next during deserialization.
+ */
+typedef enum
+{
+	BINTREE_PART_LEFT  = 0, //!< left subtree or value.
+	BINTREE_PART_VALUE = 1, //!< value.
+	BINTREE_PART_RIGHT = 2, //!< right subtree or end of node.
+	BINTREE_PART_END   = 3, //!< end of node.
+}
+bintree_part_t;
+
+/*!
+ * @brief Read value of node from string.
+ *
+ * @return Pointer to the character after value
+ * or NULL if string doesn't contain value.
+ */
+static const char* bintree_deserialize_value
+(
+	bintree_t   node, /*!< [in,out] node.                                    */
+	const char* str   /*!< [in]     string which starts before value.        */
+)
+{
+	const char* curr_ptr = strchr(str, '\"');
 	if (!curr_ptr)
-		return bintree_destroy(node);
+		return NULL;
 
 	char* node_end = (char*) curr_ptr;
 	do
 	{
 		node_end = strchr(node_end + 1, '\"');
 		if (!node_end)
-			return bintree_destroy(node);
+			return NULL;
 	}
 	while (node_end[-1] == '\\');
 
 	*node_end = '\0';
 	++curr_ptr;
 	size_t node_len = (size_t) (node_end - curr_ptr);
-	BINTREE_VALUE_PARSE(node->value, curr_ptr, node_len);
-	*node_end   = '\"';
-	curr_ptr    = node_end + 1;
+	BINTREE_VALUE_PARSE(BINTREE_NODE_VALUE(node), curr_ptr, node_len);
+	*node_end = '\"';
 
-	*curr_index = (size_t) (curr_ptr - str);
-	node->right = bintree_deserialize_(str, curr_index);
-	curr_ptr = strchr(str + *curr_index, '}');
-	if (!curr_ptr)
-		return bintree_destroy(node);
+	return node_end + 1;
+}
 
-	*curr_index = (size_t) (curr_ptr - str + 1);
+/*!
+ * @brief Deserialize binary tree.
+ *
+ * @return Binary tree or NULL if an error occurred during processing this
+ * function.
+ */
+static bintree_t bintree_deserialize_
+(
+	const char* str /*!< [in] input string.                                  */
+)
+{
+	const char* curr_ptr = strpbrk(str, "{\"}");
+	if (!curr_ptr || *curr_ptr != '{')
+		return BINTREE_NULL;
 
-	node->parent = NULL;
-	if (node->left)
-		node->left->parent = node;
-	if (node->right)
-		node->right->parent = node;
+	bintree_t root = bintree_node_alloc();
+	if (!root)
+		return BINTREE_NULL;
 
-	return node;
+	// Children are linked to their parents at once,
+	// so the way back to the root is kept by the tree itself.
+	bintree_t      node = root;
+	bintree_part_t part = BINTREE_PART_LEFT;
+	++curr_ptr;
+	while (true)
+	{
+		const char* next = strpbrk(curr_ptr, "{\"}");
+		if ((part == BINTREE_PART_LEFT || part == BINTREE_PART_RIGHT)
+		    && next && *next == '{')
+		{
+			bintree_t child = bintree_node_alloc();
+			if (!child)
+				return bintree_destroy(root);
+
+			if (part == BINTREE_PART_LEFT)
+				BINTREE_NODE_LEFT(node)  = child;
+			else
+				BINTREE_NODE_RIGHT(node) = child;
+
+			BINTREE_NODE_PARENT(child) = node;
+			node     = child;
+			part     = BINTREE_PART_LEFT;
+			curr_ptr = next + 1;
+			continue;
+		}
+
+		if (part == BINTREE_PART_LEFT || part == BINTREE_PART_VALUE)
+		{
+			curr_ptr = bintree_deserialize_value(node, curr_ptr);
+			if (!curr_ptr)
+				return bintree_destroy(root);
+
+			part = BINTREE_PART_RIGHT;
+			continue;
+		}
+
+		curr_ptr = strchr(curr_ptr, '}');
+		if (!curr_ptr)
+			return bintree_destroy(root);
+
+		++curr_ptr;
+		if (node == root)
+			return root;
+
+		bintree_t parent = BINTREE_NODE_PARENT(node);
+		part = (BINTREE_NODE_LEFT(parent) == node) ? BINTREE_PART_VALUE
+		                                           : BINTREE_PART_END;
+		node = parent;
+	}
 }
 
 /*!
@@ -80,73 +466,95 @@ static bintree_t bintree_deserialize_
  */
 static void bintree_print_
 (
- 	const bintree_t node,   /*!< [in]     binary tree.                       */
-	FILE*           output, /*!< [in,out] output stream.                     */
-	size_t          depth   /*!< [in]     recursion depth.                   */
+ 	const bintree_t head,  /*!< [in]     binary tree.                        */
+	FILE*           output /*!< [in,out] output stream.                      */
 )
 {
-	if (!node)
+	if (!head)
 		return;
 
-	print_n_chars('\t', depth, output);
-	fputs("{\n", output);
-
-	bintree_print_(node->left, output, depth + 1);
-
-	print_n_chars('\t', depth + 1, output);
-	putc('\"', output);
-	BINTREE_VALUE_PRINT(node->value, output);
-	fputs("\"\n", output);
-
-	bintree_print_(node->right, output, depth + 1);
-
-	print_n_chars('\t', depth, output);
-	fputs("}\n", output);
+	// Direction shows from where the node was reached: from its parent
+	// (stay), from its left subtree or from its right one.
+	bintree_t           node  = head;
+	bintree_direction_t from  = BINTREE_STAY;
+	size_t              depth = 0;
+	while (true)
+	{
+		if (from == BINTREE_STAY)
+		{
+			print_n_chars('\t', depth, output);
+			fputs("{\n", output);
+
+			if (BINTREE_NODE_LEFT(node))
+			{
+				node = BINTREE_NODE_LEFT(node);
+				++depth;
+				continue;
+			}
+
+			from = BINTREE_LEFT;
+		}
+
+		if (from == BINTREE_LEFT)
+		{
+			print_n_chars('\t', depth + 1, output);
+			putc('\"', output);
+			BINTREE_VALUE_PRINT(BINTREE_NODE_VALUE(node), output);
+			fputs("\"\n", output);
+
+			if (BINTREE_NODE_RIGHT(node))
+			{
+				node = BINTREE_NODE_RIGHT(node);
+				from = BINTREE_STAY;
+				++depth;
+				continue;
+			}
+		}
+
+		print_n_chars('\t', depth, output);
+		fputs("}\n", output);
+
+		if (node == head)
+			return;
+
+		bintree_t parent = BINTREE_NODE_PARENT(node);
+		from = (BINTREE_NODE_LEFT(parent) == node) ? BINTREE_LEFT
+		                                           : BINTREE_RIGHT;
+		node = parent;
+		--depth;
+	}
 }
 
 /*!
- * @brief Recursively write all binary tree edges.
+ * @brief Write all binary tree edges.
  *
- * @note If edge equals to NULL segmentation fault will be thrown.
- *
- * @return Amount of nodes in subtree.
+ * @note Nodes are named by their handles, so names are unique
+ * without numbering them.
  */
-static size_t bintree_dump_write_edges
+static void bintree_dump_write_edges
 (
-	const bintree_t node,      /*!< [in]     current node.                   */
-	FILE*           dump,      /*!< [in,out] dump file stream.               */
-	size_t          curr_index /*!< [in]     index of current node.          */
+	const bintree_t head, /*!< [in]     binary tree.                         */
+	FILE*           dump  /*!< [in,out] dump file stream.                    */
 )
 {
-	assert (node);
-
-	// Left size includes current node.
-	size_t left_size  = 1;
-	size_t right_size = 0;
-
-	fprintf(dump, "\tN%zd [label = \"<NL%zd>|", curr_index, curr_index);
-	BINTREE_VALUE_PRINT(node->value, dump);
-	fprintf(dump, "|<NR%zd>\"];\n", curr_index);
-
-	if (node->left)
-	{
-		fprintf(dump, "\tN%zd:<NL%zd> -> N%zd;\n",
-			curr_index, curr_index, curr_index + 1);
-
-		left_size += bintree_dump_write_edges(node->left, dump,
-		                                      curr_index + 1);
-	}
+	assert (head);
 
-	if (node->right)
+	for (bintree_t node = head; node; node = bintree_preorder_next(head, node))
 	{
-		fprintf(dump, "\tN%zd:<NR%zd> -> N%zd;\n",
-			curr_index, curr_index, curr_index + left_size);
-
-		right_size = bintree_dump_write_edges(node->right, dump,
-		                                      curr_index + left_size);
+		uintptr_t name = (uintptr_t) node;
+		fprintf(dump, "\tN%" PRIxPTR " [label = \"<NL%" PRIxPTR ">|",
+		        name, name);
+		BINTREE_VALUE_PRINT(BINTREE_NODE_VALUE(node), dump);
+		fprintf(dump, "|<NR%" PRIxPTR ">\"];\n", name);
+
+		if (BINTREE_NODE_LEFT(node))
+			fprintf(dump, "\tN%" PRIxPTR ":<NL%" PRIxPTR "> -> N%" PRIxPTR ";\n",
+			        name, name, (uintptr_t) BINTREE_NODE_LEFT(node));
+
+		if (BINTREE_NODE_RIGHT(node))
+			fprintf(dump, "\tN%" PRIxPTR ":<NR%" PRIxPTR "> -> N%" PRIxPTR ";\n",
+			        name, name, (uintptr_t) BINTREE_NODE_RIGHT(node));
 	}
-
-	return left_size + right_size;
 }
 
 /*!
@@ -175,49 +583,96 @@ static void bintree_write_dump_to_dot
 		tree_name, line, func, file);
 
 	if (head)
-		bintree_dump_write_edges(head, dump, 0);
+		bintree_dump_write_edges(head, dump);
 	
 	fputc('}', dump);
 }
 
-/*!
- * @brief Recursively find an element in binary tree.
- *
- * @return Node with given element
- * or NULL if tree doesn't contain given element.
- */
-static bintree_t bintree_find_
-(
-	const bintree_t node, /*!< [in] current node.                            */
-	BINTREE_VALUE_T elem  /*!< [in] given element.                           */
-)
+
+
+
+bintree_arena_t bintree_arena_create (void)
 {
-	if (BINTREE_VALUE_EQUAL(node->value, elem))
-		return node;
+	return (bintree_arena_t) calloc(1, sizeof (struct bintree_arena));
+}
+
+
+bintree_arena_t bintree_arena_destroy (bintree_arena_t arena)
+{
+	if (!arena)
+		return NULL;
+
+	bintree_arena_destroy_values(arena);
+	if (bintree_selected_arena == arena)
+		bintree_arena_select(NULL);
 
-	bintree_t ret = NULL;
-	if (node->left && (ret = bintree_find_(node->left, elem)))
-		return ret;
+#ifdef BINTREE_COMPACT
+#	ifdef BINTREE_COMPACT_SOA
+	free(arena->storage.value);
+#	else
+	free(arena->storage.nodes);
+#	endif
+
+	if (arena != &bintree_default_arena)
+		free(arena);
+	else
+		memset(arena, 0, sizeof *arena);
+
+	// Default arena could be selected and its arrays are freed now.
+	if (bintree_selected_arena == &bintree_default_arena)
+		bintree_storage_ = bintree_default_arena.storage;
+#else
+	struct bintree_arena_chunk* chunk = arena->chunks;
+	while (chunk)
+	{
+		struct bintree_arena_chunk* next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
 
-	if (node->right && (ret = bintree_find_(node->right, elem)))
-		return ret;
+	if (arena != &bintree_default_arena)
+		free(arena);
+	else
+		*arena = (struct bintree_arena) {NULL, NULL, 0, NULL};
+#endif
 
 	return NULL;
 }
 
 
+void bintree_arena_reset (bintree_arena_t arena)
+{
+	if (!arena)
+		arena = &bintree_default_arena;
+
+	bintree_arena_destroy_values(arena);
+#ifdef BINTREE_COMPACT
+	arena->size      = 0;
+#else
+	arena->current   = NULL;
+	arena->used      = 0;
+#endif
+	arena->free_list = BINTREE_NULL;
+}
+
+
+bintree_arena_t bintree_arena_select (bintree_arena_t arena)
+{
+	bintree_arena_t prev   = bintree_selected_arena;
+	bintree_selected_arena = (arena) ? arena : &bintree_default_arena;
+#ifdef BINTREE_COMPACT
+	bintree_storage_       = bintree_selected_arena->storage;
+#endif
+
+	return prev;
+}
 
 
 bintree_t bintree_create (const BINTREE_VALUE_T value)
 {
-	bintree_t node = (bintree_t) calloc(1, sizeof *node);
+	bintree_t node = bintree_node_alloc();
 	if (node)
-	{
-		node->left   = NULL;
-		node->right  = NULL;
-		node->parent = NULL;
-		BINTREE_VALUE_COPY(node->value, value);
-	}
+		BINTREE_VALUE_COPY(BINTREE_NODE_VALUE(node), value);
 
 	return node;
 }
@@ -225,14 +680,9 @@ bintree_t bintree_create (const BINTREE_VALUE_T value)
 
 bintree_t bintree_create_by_moving (BINTREE_VALUE_T value)
 {
-	bintree_t node = (bintree_t) calloc(1, sizeof *node);
+	bintree_t node = bintree_node_alloc();
 	if (node)
-	{
-		node->left   = NULL;
-		node->right  = NULL;
-		node->parent = NULL;
-		BINTREE_VALUE_MOVE(node->value, value);
-	}
+		BINTREE_VALUE_MOVE(BINTREE_NODE_VALUE(node), value);
 
 	return node;
 }
@@ -240,46 +690,81 @@ bintree_t bintree_create_by_moving (BINTREE_VALUE_T value)
 
 bintree_t bintree_destroy (bintree_t head)
 {
-	if (!head)
-		return NULL;
-
-	BINTREE_VALUE_DESTROY(head->value);
-	bintree_destroy(head->left);
-	bintree_destroy(head->right);
-	free(head);
+	// Left subtrees are rotated to the right until the node has no left
+	// child, so nodes are released one by one without any stack.
+	bintree_t node = head;
+	while (node)
+	{
+		bintree_t left = BINTREE_NODE_LEFT(node);
+		if (left)
+		{
+			BINTREE_NODE_LEFT(node)  = BINTREE_NODE_RIGHT(left);
+			BINTREE_NODE_RIGHT(left) = node;
+			node = left;
+			continue;
+		}
+
+		bintree_t right = BINTREE_NODE_RIGHT(node);
+		BINTREE_VALUE_DESTROY(BINTREE_NODE_VALUE(node));
+		bintree_node_release(node);
+		node = right;
+	}
 
-	return NULL;
+	return BINTREE_NULL;
 }
 
 
 bintree_t bintree_copy (const bintree_t root)
 {
 	if (!root)
-		return NULL;
+		return BINTREE_NULL;
 
-	bintree_t node = bintree_create(root->value);
-	if (!node)
-		return NULL;
+	bintree_t copy = bintree_create(BINTREE_NODE_VALUE(root));
+	if (!copy)
+		return BINTREE_NULL;
 
-	if (root->left)
-	{
-		bintree_t lhs  = bintree_copy(root->left);
-		if (!lhs)
-			return bintree_destroy(node);
+	BINTREE_NODE_HASH(copy) = BINTREE_NODE_HASH(root);
 
-		bintree_hook_left(node, lhs);
-	}
-	
-	if (root->right)
+	// Both trees are walked together, the copy grows by the child
+	// which isn't copied yet.
+	bintree_t node = root;
+	bintree_t dest = copy;
+	while (true)
 	{
-		bintree_t rhs = bintree_copy(root->right);
-		if (!rhs)
-			return bintree_destroy(node);
+		bintree_t child = BINTREE_NULL;
+		bool      left  = false;
+		if (BINTREE_NODE_LEFT(node) && !BINTREE_NODE_LEFT(dest))
+		{
+			child = BINTREE_NODE_LEFT(node);
+			left  = true;
+		}
+		else if (BINTREE_NODE_RIGHT(node) && !BINTREE_NODE_RIGHT(dest))
+			child = BINTREE_NODE_RIGHT(node);
+
+		if (!child)
+		{
+			if (node == root)
+				return copy;
+
+			node = BINTREE_NODE_PARENT(node);
+			dest = BINTREE_NODE_PARENT(dest);
+			continue;
+		}
+
+		bintree_t created = bintree_create(BINTREE_NODE_VALUE(child));
+		if (!created)
+			return bintree_destroy(copy);
+
+		if (left)
+			BINTREE_NODE_LEFT(dest)  = created;
+		else
+			BINTREE_NODE_RIGHT(dest) = created;
 
-		bintree_hook_right(node, rhs);
+		BINTREE_NODE_PARENT(created) = dest;
+		BINTREE_NODE_HASH(created)   = BINTREE_NODE_HASH(child);
+		node = child;
+		dest = created;
 	}
-
-	return node;
 }
 
 
@@ -296,21 +781,25 @@ bintree_t bintree_hook_left (bintree_t node, bintree_t for_hooking)
 	assert (node);
 	assert (for_hooking);
 
-	bintree_t for_hooking_parent = for_hooking->parent;
+	bintree_t for_hooking_parent = BINTREE_NODE_PARENT(for_hooking);
 	if (for_hooking_parent)
 	{
-		if (for_hooking_parent->left == for_hooking)
-			for_hooking_parent->left = NULL;
+		if (BINTREE_NODE_LEFT(for_hooking_parent) == for_hooking)
+			BINTREE_NODE_LEFT(for_hooking_parent) = BINTREE_NULL;
 		else
-			for_hooking_parent->right = NULL;
+			BINTREE_NODE_RIGHT(for_hooking_parent) = BINTREE_NULL;
+
+		bintree_invalidate(for_hooking_parent);
 	}
 
-	bintree_destroy(node->left);
-	node->left = for_hooking;
+	bintree_destroy(BINTREE_NODE_LEFT(node));
+	BINTREE_NODE_LEFT(node) = for_hooking;
 	if (for_hooking)
-		for_hooking->parent = node;
+		BINTREE_NODE_PARENT(for_hooking) = node;
 
-	return node->left;
+	bintree_invalidate(node);
+
+	return BINTREE_NODE_LEFT(node);
 
 }
 
@@ -320,10 +809,12 @@ bintree_t bintree_unhook_left (bintree_t node)
 {
 	assert (node);
 
-	bintree_t left = node->left;
-	node->left     = NULL;
+	bintree_t left = BINTREE_NODE_LEFT(node);
+	BINTREE_NODE_LEFT(node)     = BINTREE_NULL;
 	if (left)
-		left->parent = NULL;
+		BINTREE_NODE_PARENT(left) = BINTREE_NULL;
+
+	bintree_invalidate(node);
 
 	return left;
 }
@@ -342,21 +833,25 @@ bintree_t bintree_hook_right (bintree_t node, bintree_t for_hooking)
 	assert (node);
 	assert (for_hooking);
 
-	bintree_t for_hooking_parent = for_hooking->parent;
+	bintree_t for_hooking_parent = BINTREE_NODE_PARENT(for_hooking);
 	if (for_hooking_parent)
 	{
-		if (for_hooking_parent->left == for_hooking)
-			for_hooking_parent->left = NULL;
+		if (BINTREE_NODE_LEFT(for_hooking_parent) == for_hooking)
+			BINTREE_NODE_LEFT(for_hooking_parent) = BINTREE_NULL;
 		else
-			for_hooking_parent->right = NULL;
+			BINTREE_NODE_RIGHT(for_hooking_parent) = BINTREE_NULL;
+
+		bintree_invalidate(for_hooking_parent);
 	}
 
-	bintree_destroy(node->right);
-	node->right = for_hooking;
+	bintree_destroy(BINTREE_NODE_RIGHT(node));
+	BINTREE_NODE_RIGHT(node) = for_hooking;
 	if (for_hooking)
-		for_hooking->parent = node;
+		BINTREE_NODE_PARENT(for_hooking) = node;
+
+	bintree_invalidate(node);
 
-	return node->right;
+	return BINTREE_NODE_RIGHT(node);
 
 }
 
@@ -365,10 +860,12 @@ bintree_t bintree_unhook_right (bintree_t node)
 {
 	assert (node);
 
-	bintree_t right = node->right;
-	node->right     = NULL;
+	bintree_t right = BINTREE_NODE_RIGHT(node);
+	BINTREE_NODE_RIGHT(node)     = BINTREE_NULL;
 	if (right)
-		right->parent = NULL;
+		BINTREE_NODE_PARENT(right) = BINTREE_NULL;
+
+	bintree_invalidate(node);
 
 	return right;
 }
@@ -378,7 +875,7 @@ void bintree_print (const bintree_t head, FILE* output)
 {
 	assert (output);
 
-	bintree_print_(head, output, 0);
+	bintree_print_(head, output);
 }
 
 
@@ -416,7 +913,7 @@ bintree_t bintree_read (FILE* input)
 	size_t len = 0;
 	char* data = read_string(input, &len);
 	if (!data)
-		return NULL;
+		return BINTREE_NULL;
 
 	bintree_t head = bintree_deserialize(data);
 	free(data);
@@ -429,8 +926,7 @@ bintree_t bintree_deserialize (const char* str)
 {
 	assert (str);
 
-	size_t index = 0;
-	return bintree_deserialize_(str, &index);
+	return bintree_deserialize_(str);
 }
 
 
@@ -438,7 +934,64 @@ bintree_t bintree_find (const bintree_t head, BINTREE_VALUE_T elem)
 {
 	assert (head);
 
-	return bintree_find_(head, elem);
+	for (bintree_t node = head; node; node = bintree_preorder_next(head, node))
+		if (BINTREE_VALUE_EQUAL(BINTREE_NODE_VALUE(node), elem))
+			return node;
+
+	return BINTREE_NULL;
+}
+
+
+bintree_t bintree_preorder_next (const bintree_t root, const bintree_t node)
+{
+	assert (root);
+	assert (node);
+
+	if (BINTREE_NODE_LEFT(node))
+		return BINTREE_NODE_LEFT(node);
+
+	if (BINTREE_NODE_RIGHT(node))
+		return BINTREE_NODE_RIGHT(node);
+
+	// The next node is the right sibling of the nearest ancestor
+	// which has it.
+	for (bintree_t curr = node; curr != root; curr = BINTREE_NODE_PARENT(curr))
+	{
+		bintree_t parent = BINTREE_NODE_PARENT(curr);
+		if (BINTREE_NODE_LEFT(parent) == curr && BINTREE_NODE_RIGHT(parent))
+			return BINTREE_NODE_RIGHT(parent);
+	}
+
+	return BINTREE_NULL;
+}
+
+
+bintree_t bintree_postorder_first (const bintree_t root)
+{
+	assert (root);
+
+	bintree_t node = root;
+	while (BINTREE_NODE_LEFT(node) || BINTREE_NODE_RIGHT(node))
+		node = (BINTREE_NODE_LEFT(node)) ? BINTREE_NODE_LEFT(node)
+		                                 : BINTREE_NODE_RIGHT(node);
+
+	return node;
+}
+
+
+bintree_t bintree_postorder_next (const bintree_t root, const bintree_t node)
+{
+	assert (root);
+	assert (node);
+
+	if (node == root)
+		return BINTREE_NULL;
+
+	bintree_t parent = BINTREE_NODE_PARENT(node);
+	if (BINTREE_NODE_LEFT(parent) == node && BINTREE_NODE_RIGHT(parent))
+		return bintree_postorder_first(BINTREE_NODE_RIGHT(parent));
+
+	return parent;
 }
 
 
@@ -463,9 +1016,10 @@ bintree_direction_t* bintree_get_way (const bintree_t node, size_t* len)
 	bintree_t curr_node = node;
 	for (size_t i = 1; i <= length; ++i)
 	{
-		way[length - i] = (curr_node->parent->right == curr_node)
-		                  ? BINTREE_RIGHT : BINTREE_LEFT;
-		curr_node = curr_node->parent;
+		bintree_t parent = BINTREE_NODE_PARENT(curr_node);
+		way[length - i]  = (BINTREE_NODE_RIGHT(parent) == curr_node)
+		                   ? BINTREE_RIGHT : BINTREE_LEFT;
+		curr_node = parent;
 	}
 
 	return way;
@@ -475,7 +1029,8 @@ bintree_direction_t* bintree_get_way (const bintree_t node, size_t* len)
 size_t bintree_get_height (const bintree_t node)
 {
 	size_t height = 0;
-	for (bintree_t curr_node = node; curr_node; curr_node = curr_node->parent)
+	for (bintree_t curr_node = node; curr_node;
+	     curr_node = BINTREE_NODE_PARENT(curr_node))
 		++height;
 
 	return height;
@@ -489,9 +1044,9 @@ bintree_t bintree_next (const bintree_t node, bintree_direction_t dir)
 	switch (dir)
 	{
 		case BINTREE_STAY:  return node;
-		case BINTREE_LEFT:  return node->left;
-		case BINTREE_RIGHT: return node->right;
-		default:            return NULL;
+		case BINTREE_LEFT:  return BINTREE_NODE_LEFT(node);
+		case BINTREE_RIGHT: return BINTREE_NODE_RIGHT(node);
+		default:            return BINTREE_NULL;
 	}
 }
 
@@ -502,23 +1057,25 @@ bintree_t bintree_insert_left (bintree_t* root,
 	assert (where);
 	assert (node);
 
-	bintree_t parent = where->parent;
-	bintree_destroy(node->left);
-	bintree_destroy(node->parent);
-	node->left    = where;
-	node->parent  = parent;
-	where->parent = node;
+	bintree_t parent = BINTREE_NODE_PARENT(where);
+	bintree_destroy(BINTREE_NODE_LEFT(node));
+	bintree_destroy(BINTREE_NODE_PARENT(node));
+	BINTREE_NODE_LEFT(node)    = where;
+	BINTREE_NODE_PARENT(node)  = parent;
+	BINTREE_NODE_PARENT(where) = node;
 	if (!parent)
 	{
+		bintree_invalidate(node);
 		*root = node;
 		return node;
 	}
 
-	if (parent->left == where)
-		parent->left = node;
+	if (BINTREE_NODE_LEFT(parent) == where)
+		BINTREE_NODE_LEFT(parent) = node;
 	else
-		parent->right = node;
+		BINTREE_NODE_RIGHT(parent) = node;
 
+	bintree_invalidate(node);
 	return node;
 }
 
@@ -529,23 +1086,25 @@ bintree_t bintree_insert_right (bintree_t* root,
 	assert (where);
 	assert (node);
 
-	bintree_t parent = where->parent;
-	bintree_destroy(node->right);
-	bintree_destroy(node->parent);
-	node->right   = where;
-	node->parent  = parent;
-	where->parent = node;
+	bintree_t parent = BINTREE_NODE_PARENT(where);
+	bintree_destroy(BINTREE_NODE_RIGHT(node));
+	bintree_destroy(BINTREE_NODE_PARENT(node));
+	BINTREE_NODE_RIGHT(node)   = where;
+	BINTREE_NODE_PARENT(node)  = parent;
+	BINTREE_NODE_PARENT(where) = node;
 	if (!parent)
 	{
+		bintree_invalidate(node);
 		*root = node;
 		return node;
 	}
 
-	if (parent->left == where)
-		parent->left = node;
+	if (BINTREE_NODE_LEFT(parent) == where)
+		BINTREE_NODE_LEFT(parent) = node;
 	else
-		parent->right = node;
+		BINTREE_NODE_RIGHT(parent) = node;
 
+	bintree_invalidate(node);
 	return node;
 }
 
@@ -557,38 +1116,107 @@ bintree_t bintree_replace (bintree_t what, bintree_t to)
 	if (what == to)
 		return what;
 
-	if (to->parent)
+	if (BINTREE_NODE_PARENT(to))
 	{
-		if (to->parent->left == to)
-			to->parent->left = NULL;
+		if (BINTREE_NODE_LEFT(BINTREE_NODE_PARENT(to)) == to)
+			BINTREE_NODE_LEFT(BINTREE_NODE_PARENT(to)) = BINTREE_NULL;
 		else
-			to->parent->right = NULL;
-	}
+			BINTREE_NODE_RIGHT(BINTREE_NODE_PARENT(to)) = BINTREE_NULL;
 
-	bintree_destroy(what->left);;
-	what->left = to->left;
-	to->left   = NULL;
-	if (what->left)
-		what->left->parent = what;
-
-	bintree_destroy(what->right);;
-	what->right = to->right;
-	to->right   = NULL;
-	if (what->right)
-		what->right->parent = what;
+		bintree_invalidate(BINTREE_NODE_PARENT(to));
+	}
 
-	BINTREE_VALUE_MOVE(what->value, to->value);
+	bintree_destroy(BINTREE_NODE_LEFT(what));;
+	BINTREE_NODE_LEFT(what) = BINTREE_NODE_LEFT(to);
+	BINTREE_NODE_LEFT(to)   = BINTREE_NULL;
+	if (BINTREE_NODE_LEFT(what))
+		BINTREE_NODE_PARENT(BINTREE_NODE_LEFT(what)) = what;
+
+	bintree_destroy(BINTREE_NODE_RIGHT(what));;
+	BINTREE_NODE_RIGHT(what) = BINTREE_NODE_RIGHT(to);
+	BINTREE_NODE_RIGHT(to)   = BINTREE_NULL;
+	if (BINTREE_NODE_RIGHT(what))
+		BINTREE_NODE_PARENT(BINTREE_NODE_RIGHT(what)) = what;
+
+	// Subtree of node becomes the same as substitution's one.
+	size_t hash = BINTREE_NODE_HASH(to);
+	BINTREE_VALUE_MOVE(BINTREE_NODE_VALUE(what), BINTREE_NODE_VALUE(to));
 	bintree_destroy(to);
+	bintree_invalidate(what);
+	BINTREE_NODE_HASH(what) = hash;
 	return what;
 }
 
 
+size_t bintree_hash (const bintree_t root)
+{
+	if (!root)
+		return 0;
+
+	// Only subtrees without cached hash are visited. They are calculated
+	// in post-order, so hashes of children are always ready.
+	bintree_t node = root;
+	while (!BINTREE_NODE_HASH(root))
+	{
+		bintree_t left  = BINTREE_NODE_LEFT(node);
+		bintree_t right = BINTREE_NODE_RIGHT(node);
+		if (left && !BINTREE_NODE_HASH(left))
+		{
+			node = left;
+			continue;
+		}
+
+		if (right && !BINTREE_NODE_HASH(right))
+		{
+			node = right;
+			continue;
+		}
+
+		size_t hash = BINTREE_VALUE_HASH(BINTREE_NODE_VALUE(node));
+		hash = hash_combine(hash, (left)  ? BINTREE_NODE_HASH(left)  : 0);
+		hash = hash_combine(hash, (right) ? BINTREE_NODE_HASH(right) : 0);
+
+		// Zero means that hash isn't calculated.
+		BINTREE_NODE_HASH(node) = (hash) ? hash : 1;
+		if (node != root)
+			node = BINTREE_NODE_PARENT(node);
+	}
+
+	return BINTREE_NODE_HASH(root);
+}
+
+
+void bintree_value_changed (bintree_t node)
+{
+	assert (node);
+
+	bintree_invalidate(node);
+}
+
+
 bool bintree_equal (const bintree_t a, const bintree_t b)
 {
 	if (!a || !b)
 		return a == b;
 
-	return BINTREE_VALUE_EQUAL(a->value, b->value)
-	       && bintree_equal(a->left,  b->left)
-	       && bintree_equal(a->right, b->right);
+	if (bintree_hash(a) != bintree_hash(b))
+		return false;
+
+	// Hashes of all nodes are cached now. Trees are walked together
+	// while their nodes have the same values and the same children.
+	bintree_t x = a;
+	bintree_t y = b;
+	while (x)
+	{
+		if (BINTREE_NODE_HASH(x) != BINTREE_NODE_HASH(y)
+		    || !BINTREE_VALUE_EQUAL(BINTREE_NODE_VALUE(x), BINTREE_NODE_VALUE(y))
+		    || (!BINTREE_NODE_LEFT(x))  != (!BINTREE_NODE_LEFT(y))
+		    || (!BINTREE_NODE_RIGHT(x)) != (!BINTREE_NODE_RIGHT(y)))
+			return false;
+
+		x = bintree_preorder_next(a, x);
+		y = bintree_preorder_next(b, y);
+	}
+
+	return true;
 }
@@ -25,10 +25,19 @@
 	token_move(&NODE_VALUE_, &VALUE_)
 
 /*!
+ * @brief Destroy function for binary tree elements.
  *
+ * @note It must be safe to call it twice for the same element
+ * because arena reset destroys elements of released nodes again.
  */
 #define BINTREE_VALUE_DESTROY(VALUE_) token_destroy(&VALUE_)
 
+/*!
+ * @brief Defined if elements don't own any resources,
+ * so arena can release nodes without destroying their values.
+ */
+#define BINTREE_VALUE_TRIVIAL
+
 /*!
  * @brief Function which prints a tree element.
  */
@@ -41,6 +50,11 @@
 #define BINTREE_VALUE_EQUAL(NODE_VALUE_, VALUE_) \
 	token_equal(&NODE_VALUE_, &VALUE_)
 
+/*!
+ * @brief Function which returns hash of element.
+ */
+#define BINTREE_VALUE_HASH(VALUE_) token_hash(&VALUE_)
+
 /*!
  * @brief Function which parses value from input string.
  */
@@ -51,3 +65,29 @@
  * @brief Max file name of binary tree dump.
  */
 #define BINTREE_MAX_FNAME ((size_t) 8192)
+
+/*!
+ * @brief The least amount of nodes in one chunk of the node arena.
+ *
+ * @note Chunks are rounded up to a power of 2 bytes, the rest of them
+ * is filled by nodes too.
+ */
+#define BINTREE_ARENA_CHUNK ((size_t) 4096)
+
+/*!
+ * @brief Define it to keep nodes in one array of the arena and link them
+ * by 32-bit indices instead of pointers.
+ *
+ * @note Nodes can be accessed only while their arena is selected.
+ */
+// #define BINTREE_COMPACT
+
+/*!
+ * @brief Define it to keep children, parents and values of nodes
+ * in separate arrays. It implies BINTREE_COMPACT.
+ */
+// #define BINTREE_COMPACT_SOA
+
+#if defined(BINTREE_COMPACT_SOA) && !defined(BINTREE_COMPACT)
+#	define BINTREE_COMPACT
+#endif
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "bintree.config.h"
 
@@ -26,6 +27,79 @@ typedef enum
 }
 bintree_direction_t;
 
+#ifdef BINTREE_COMPACT
+
+/*!
+ * @brief Index of node in the selected arena.
+ */
+typedef uint32_t bintree_t;
+
+#	ifdef BINTREE_COMPACT_SOA
+
+/*!
+ * @brief Node arrays of an arena. Fields of node are kept in separate arrays.
+ */
+struct bintree_storage
+{
+	bintree_t*       left;   /*!< left children.                             */
+	bintree_t*       right;  /*!< right children.                            */
+	bintree_t*       parent; /*!< parent nodes.                              */
+	BINTREE_VALUE_T* value;  /*!< values of nodes.                           */
+	size_t*          hash;   /*!< cached hashes of subtrees.                 */
+};
+
+#		define BINTREE_NODE_LEFT(NODE_)   (bintree_storage_.left[NODE_])
+#		define BINTREE_NODE_RIGHT(NODE_)  (bintree_storage_.right[NODE_])
+#		define BINTREE_NODE_PARENT(NODE_) (bintree_storage_.parent[NODE_])
+#		define BINTREE_NODE_VALUE(NODE_)  (bintree_storage_.value[NODE_])
+#		define BINTREE_NODE_HASH(NODE_)   (bintree_storage_.hash[NODE_])
+
+#	else // not defined BINTREE_COMPACT_SOA
+
+/*!
+ * @brief Node of a binary tree.
+ */
+struct bintree_node
+{
+	bintree_t       left;   /*!< left child.                                 */
+	bintree_t       right;  /*!< right child.                                */
+	bintree_t       parent; /*!< parent node.                                */
+	BINTREE_VALUE_T value;  /*!< value of node.                              */
+	size_t          hash;   /*!< cached hash of subtree or 0.                */
+};
+
+/*!
+ * @brief Node array of an arena.
+ */
+struct bintree_storage
+{
+	struct bintree_node* nodes; /*!< nodes.                                  */
+};
+
+#		define BINTREE_NODE_LEFT(NODE_)   (bintree_storage_.nodes[NODE_].left)
+#		define BINTREE_NODE_RIGHT(NODE_)  (bintree_storage_.nodes[NODE_].right)
+#		define BINTREE_NODE_PARENT(NODE_) (bintree_storage_.nodes[NODE_].parent)
+#		define BINTREE_NODE_VALUE(NODE_)  (bintree_storage_.nodes[NODE_].value)
+#		define BINTREE_NODE_HASH(NODE_)   (bintree_storage_.nodes[NODE_].hash)
+
+#	endif // not defined BINTREE_COMPACT_SOA
+
+/*!
+ * @brief Node arrays of the arena selected by the calling thread.
+ *
+ * @note Don't use it directly, use BINTREE_NODE_LEFT() and others.
+ * Arrays are moved when arena grows, so don't keep pointers to nodes
+ * while new nodes are created.
+ */
+extern _Thread_local struct bintree_storage bintree_storage_;
+
+/*!
+ * @brief Node which doesn't exist.
+ */
+#	define BINTREE_NULL ((bintree_t) 0)
+
+#else // not defined BINTREE_COMPACT
+
 /*!
  * @brief Node of a binary tree.
  */
@@ -35,11 +109,91 @@ typedef struct bintree_node
 	struct bintree_node* right;  /*!< right child.                           */
 	struct bintree_node* parent; /*!< parent node.                           */
 	BINTREE_VALUE_T      value; /*!< value of node.                          */
+	size_t               hash;  /*!< cached hash of subtree or 0.            */
 }
 *bintree_t;
 
+#	define BINTREE_NODE_LEFT(NODE_)   ((NODE_)->left)
+#	define BINTREE_NODE_RIGHT(NODE_)  ((NODE_)->right)
+#	define BINTREE_NODE_PARENT(NODE_) ((NODE_)->parent)
+#	define BINTREE_NODE_VALUE(NODE_)  ((NODE_)->value)
+#	define BINTREE_NODE_HASH(NODE_)   ((NODE_)->hash)
 
+/*!
+ * @brief Node which doesn't exist.
+ */
+#	define BINTREE_NULL NULL
 
+#endif // not defined BINTREE_COMPACT
+
+/*!
+ * @brief Arena which nodes of binary trees are allocated from.
+ *
+ * Nodes are taken from big chunks and released nodes are kept in a free list,
+ * so creating and destroying nodes doesn't call malloc() and free().
+ * If BINTREE_COMPACT is defined all nodes of arena are kept in one growing
+ * array and trees refer to them by indices.
+ * All nodes are allocated from the selected arena
+ * (see bintree_arena_select()).
+ *
+ * @note Node is returned to the arena it was allocated from whichever arena
+ * is selected. If BINTREE_COMPACT is defined node must be destroyed while
+ * its arena is selected.
+ *
+ * @note Arena isn't synchronized and the default arena is shared by all
+ * threads, so every thread which works with trees at the same time
+ * as others should select its own arena first.
+ */
+typedef struct bintree_arena* bintree_arena_t;
+
+
+
+
+/*!
+ * @brief Create new node arena.
+ *
+ * @note Don't forget to free memory using bintree_arena_destroy() function.
+ *
+ * @return Created arena. If error occurred it returns NULL.
+ */
+bintree_arena_t bintree_arena_create (void);
+
+/*!
+ * @brief Destroy arena and all nodes allocated from it.
+ *
+ * @note If arena is selected the default arena becomes selected.
+ *
+ * @return NULL.
+ */
+bintree_arena_t bintree_arena_destroy
+(
+	bintree_arena_t arena /*!< [in,out] node arena.                          */
+);
+
+/*!
+ * @brief Release all nodes of the arena at once.
+ *
+ * @note Memory isn't returned to system and will be used for new nodes.
+ * All trees allocated from the arena become invalid.
+ */
+void bintree_arena_reset
+(
+	bintree_arena_t arena /*!< [in,out] node arena or NULL for the default
+	                                    arena.                               */
+);
+
+/*!
+ * @brief Select arena which new nodes will be allocated from.
+ *
+ * @note Arena is selected only for the calling thread.
+ *
+ * @return Previously selected arena.
+ */
+bintree_arena_t bintree_arena_select
+(
+	bintree_arena_t arena /*!< [in] node arena or NULL for the default
+	                                arena.                                   */
+);
 
 /*!
  * @brief Create new node.
@@ -196,7 +350,7 @@ bintree_t bintree_read
 );
 
 /*!
- * @brief Recursively deserialize binary tree from string.
+ * @brief Deserialize binary tree from string.
  *
  * @return Binary tree. IF an error occurred it returns NULL.
  */
@@ -216,6 +370,44 @@ bintree_t bintree_find
 	const bintree_t head, /*!< [in] binary tree.                             */
 	BINTREE_VALUE_T elem  /*!< [in] given element.                           */
 );
+/*!
+ * @brief Get the next node of subtree in pre-order.
+ *
+ * @note Traversal uses parent links instead of recursion,
+ * so it works for trees of any depth. The first node is the root itself.
+ *
+ * @return Next node or NULL if node is the last one.
+ */
+bintree_t bintree_preorder_next
+(
+	const bintree_t root, /*!< [in] root of traversed subtree.               */
+	const bintree_t node  /*!< [in] current node of subtree.                 */
+);
+
+/*!
+ * @brief Get the first node of subtree in post-order.
+ *
+ * @return Leftmost leaf of subtree.
+ */
+bintree_t bintree_postorder_first
+(
+	const bintree_t root /*!< [in] root of traversed subtree.                */
+);
+
+/*!
+ * @brief Get the next node of subtree in post-order.
+ *
+ * @note Children of the current node aren't visited again, so the current
+ * node can be changed or replaced before getting the next one.
+ *
+ * @return Next node or NULL if node is the root.
+ */
+bintree_t bintree_postorder_next
+(
+	const bintree_t root, /*!< [in] root of traversed subtree.               */
+	const bintree_t node  /*!< [in] current node of subtree.                 */
+);
+
 /*!
  * @brief Get way to the particular node.
  *
@@ -286,9 +478,35 @@ bintree_t bintree_replace
 	bintree_t to    /*!< [in,out] to what should replace.                    */
 );
 
+/*!
+ * @brief Get structural hash of binary tree.
+ *
+ * Hash is cached in nodes and calculated again only for subtrees
+ * which were changed.
+ *
+ * @return Hash of tree or 0 if tree is empty.
+ */
+size_t bintree_hash
+(
+	const bintree_t root /*!< [in] binary tree.                              */
+);
+
+/*!
+ * @brief Drop cached hashes of node and its ancestors.
+ *
+ * @note Call it after changing value of node directly.
+ * Functions of binary tree do it themselves.
+ */
+void bintree_value_changed
+(
+	bintree_t node /*!< [in,out] changed node.                               */
+);
+
 /*!
  * @brief Check two binary trees to equality.
  *
+ * @note Trees with different hashes are rejected without traversal.
+ *
  * @return Equality of trees.
  */
 bool bintree_equal
@@ -5,50 +5,59 @@
 
 #include "token_specific.h"
 #include "bintree.h"
+#include "../builtins/builtins.h"
+#include "../utilities/utilities.h"
 
 #include <assert.h>
-#include <string.h>
 
 
 
 
 /*!
- * @brief Recursively substitute all values.
+ * @brief Check node to be a number with given value.
  *
- * @return Tree with substitution.
+ * @return Result of checking.
  */
-static bintree_t expr_substitute
+static bool is_number
 (
-	const bintree_t expr,        /*!< [in] input expression.                 */
-	double          substitution /*!< [in] substitution value.               */
+	const bintree_t node, /*!< [in] checked node.                            */
+	double          num   /*!< [in] expected number.                         */
 )
 {
-	token_t t = expr->value;
-	if (t.type == TOKEN_VAR && !strcmp(t.value.ident, "x"))
-	{
-		t.type         = TOKEN_NUMBER;
-		t.value.number = substitution;
-	}
-
-	bintree_t root = bintree_create(t);
-	if (!root)
-		return NULL;
-
-	if (expr->left)
-	{
-		bintree_hook_left(root, expr_substitute(expr->left, substitution));
-		if (!root->left)
-			return bintree_destroy(root);
-	}
+	return BINTREE_NODE_VALUE(node).type == TOKEN_NUMBER
+	       && double_equal(BINTREE_NODE_VALUE(node).value.number, num);
+}
 
-	if (expr->right)
-	{
-		bintree_hook_right(root, expr_substitute(expr->right, substitution));
-		if (!root->right)
-			return bintree_destroy(root);
-	}
+/*!
+ * @brief Destroy one of operands and keep another.
+ *
+ * @return Kept operand.
+ */
+static bintree_t keep_operand
+(
+	bintree_t kept,     /*!< [in] kept operand.                              */
+	bintree_t destroyed /*!< [in] destroyed operand.                         */
+)
+{
+	bintree_destroy(destroyed);
+	return kept;
+}
 
-	return root;
+/*!
+ * @brief Destroy both operands and replace them by number.
+ *
+ * @return Created number.
+ */
+static bintree_t replace_by_number
+(
+	bintree_t lhs, /*!< [in] left operand.                                   */
+	bintree_t rhs, /*!< [in] right operand.                                  */
+	double    num  /*!< [in] number.                                         */
+)
+{
+	bintree_destroy(lhs);
+	bintree_destroy(rhs);
+	return create_number(num);
 }
 
 
@@ -57,7 +66,7 @@ static bintree_t expr_substitute
 bintree_t create_binop_node (bintree_t lhs, bintree_t rhs, token_t op)
 {
 	if (!lhs || !rhs)
-		return NULL;
+		return BINTREE_NULL;
 
 	bintree_t node = bintree_create_by_moving(op);
 	if (!node)
@@ -69,7 +78,7 @@ bintree_t create_binop_node (bintree_t lhs, bintree_t rhs, token_t op)
 		bintree_destroy(lhs);
 		bintree_destroy(rhs);
 		token_destroy(&op);
-		return NULL;
+		return BINTREE_NULL;
 	}
 
 	bintree_hook_left(node, lhs);
@@ -82,7 +91,7 @@ bintree_t create_binop_node (bintree_t lhs, bintree_t rhs, token_t op)
 bintree_t create_prefunop_node (bintree_t operand, token_t op)
 {
 	if (!operand)
-		return NULL;
+		return BINTREE_NULL;
 
 	bintree_t node = bintree_create_by_moving(op);
 	if (!node)
@@ -93,7 +102,7 @@ bintree_t create_prefunop_node (bintree_t operand, token_t op)
 		bintree_destroy(node);
 		bintree_destroy(operand);
 		token_destroy(&op);
-		return NULL;
+		return BINTREE_NULL;
 	}
 
 	bintree_hook_left(node, operand);
@@ -105,7 +114,7 @@ bintree_t create_prefunop_node (bintree_t operand, token_t op)
 bintree_t create_postunop_node (bintree_t operand, token_t op)
 {
 	if (!operand)
-		return NULL;
+		return BINTREE_NULL;
 
 	bintree_t node = bintree_create_by_moving(op);
 	if (!node)
@@ -116,7 +125,7 @@ bintree_t create_postunop_node (bintree_t operand, token_t op)
 		bintree_destroy(node);
 		bintree_destroy(operand);
 		token_destroy(&op);
-		return NULL;
+		return BINTREE_NULL;
 	}
 
 	bintree_hook_right(node, operand);
@@ -131,7 +140,7 @@ bintree_t create_func_node (bintree_t func, bintree_t arg)
 	{
 		bintree_destroy(func);
 		bintree_destroy(arg);
-		return NULL;
+		return BINTREE_NULL;
 	}
 
 	bintree_hook_right(func, arg);
@@ -139,6 +148,138 @@ bintree_t create_func_node (bintree_t func, bintree_t arg)
 }
 
 
+bintree_t make_binop_node (bintree_t lhs, bintree_t rhs, token_t op)
+{
+	if (!lhs || !rhs)
+	{
+		bintree_destroy(lhs);
+		bintree_destroy(rhs);
+		return BINTREE_NULL;
+	}
+
+	if (op.type != TOKEN_OP)
+		return create_binop_node(lhs, rhs, op);
+
+	token_t l = BINTREE_NODE_VALUE(lhs);
+	token_t r = BINTREE_NODE_VALUE(rhs);
+	if (l.type == TOKEN_NUMBER && r.type == TOKEN_NUMBER)
+		return replace_by_number(lhs, rhs,
+		                         operation_calculate(op.value.operation,
+		                                             l.value.number,
+		                                             r.value.number));
+
+	switch (op.value.operation)
+	{
+		case OP_PLUS:
+			if (is_number(lhs, 0))
+				return keep_operand(rhs, lhs);
+
+			if (is_number(rhs, 0))
+				return keep_operand(lhs, rhs);
+
+			break;
+
+		case OP_MINUS:
+			if (is_number(rhs, 0))
+				return keep_operand(lhs, rhs);
+
+			if (is_number(lhs, 0))
+				return make_prefunop_node(keep_operand(rhs, lhs), op);
+
+			if (bintree_equal(lhs, rhs))
+				return replace_by_number(lhs, rhs, 0);
+
+			break;
+
+		case OP_MUL:
+			if (is_number(lhs, 0) || is_number(rhs, 0))
+				return replace_by_number(lhs, rhs, 0);
+
+			if (is_number(lhs, 1))
+				return keep_operand(rhs, lhs);
+
+			if (is_number(rhs, 1))
+				return keep_operand(lhs, rhs);
+
+			break;
+
+		case OP_DIV:
+			if (is_number(lhs, 0))
+				return replace_by_number(lhs, rhs, 0);
+
+			if (is_number(rhs, 1))
+				return keep_operand(lhs, rhs);
+
+			if (bintree_equal(lhs, rhs))
+				return replace_by_number(lhs, rhs, 1);
+
+			break;
+
+		case OP_POW:
+			if (is_number(lhs, 0))
+				return replace_by_number(lhs, rhs, 0);
+
+			if (is_number(lhs, 1) || is_number(rhs, 0))
+				return replace_by_number(lhs, rhs, 1);
+
+			if (is_number(rhs, 1))
+				return keep_operand(lhs, rhs);
+
+			break;
+
+		case OP_EMPTY:
+		case OP_DERIV:
+		default:
+			break;
+	}
+
+	return create_binop_node(lhs, rhs, op);
+}
+
+
+bintree_t make_prefunop_node (bintree_t operand, token_t op)
+{
+	if (!operand || op.type != TOKEN_OP)
+		return create_prefunop_node(operand, op);
+
+	token_t t = BINTREE_NODE_VALUE(operand);
+	if (op.value.operation == OP_PLUS)
+		return operand;
+
+	if (op.value.operation == OP_MINUS && t.type == TOKEN_NUMBER)
+	{
+		t.value.number = -t.value.number;
+		bintree_destroy(operand);
+		return bintree_create_by_moving(t);
+	}
+
+	// -(-u) = u
+	if (op.value.operation == OP_MINUS && t.type == TOKEN_OP
+	    && t.value.operation == OP_MINUS && !BINTREE_NODE_RIGHT(operand))
+	{
+		bintree_t arg = bintree_unhook_left(operand);
+		bintree_destroy(operand);
+		return arg;
+	}
+
+	return create_prefunop_node(operand, op);
+}
+
+
+bintree_t make_func_node (bintree_t func, bintree_t arg)
+{
+	bintree_t root = create_func_node(func, arg);
+	if (!root)
+		return BINTREE_NULL;
+
+	const builtin_rule_t* rule = builtin_rule(BINTREE_NODE_VALUE(root).func);
+	if (rule)
+		rule->simplify(root);
+
+	return root;
+}
+
+
 bintree_t create_number (double num)
 {
 	token_t token = {.type = TOKEN_NUMBER, .value.number = num};
@@ -150,5 +291,20 @@ bintree_t expression_substitute (const bintree_t expr, double substitution)
 {
 	assert (expr);
 
-	return expr_substitute(expr, substitution);
+	bintree_t root = bintree_copy(expr);
+	if (!root)
+		return BINTREE_NULL;
+
+	for (bintree_t node = root; node; node = bintree_preorder_next(root, node))
+	{
+		token_t* t = &BINTREE_NODE_VALUE(node);
+		if (t->type == TOKEN_VAR && t->value.ident == SYMBOL_X)
+		{
+			t->type         = TOKEN_NUMBER;
+			t->value.number = substitution;
+			bintree_value_changed(node);
+		}
+	}
+
+	return root;
 }
@@ -69,6 +69,50 @@ bintree_t create_func_node
 	bintree_t arg   /*!< [in] function's argument.                           */
 );
 
+/*!
+ * @brief Create node of binary operation simplifying it at once.
+ *
+ * Constants are folded and identities like 0 + u, 1 * u, u ^ 1 or 0 * u
+ * are applied, so node is created only if nothing can be simplified.
+ *
+ * @note Operands are owned by the result and freed if an error occurred.
+ *
+ * @return Created expression. If an error has been occurred it returns NULL.
+ */
+bintree_t make_binop_node
+(
+	bintree_t lhs, /*!< [in] left operand.                                   */
+	bintree_t rhs, /*!< [in] right opeand.                                   */
+	token_t   op   /*!< [in] token that has operation type.                  */
+);
+
+/*!
+ * @brief Create node of prefix unary operation simplifying it at once.
+ *
+ * @note Operand is owned by the result and freed if an error occurred.
+ *
+ * @return Created expression. If an error has been occurred it returns NULL.
+ */
+bintree_t make_prefunop_node
+(
+	bintree_t operand, /*!< [in] an operand.                                 */
+	token_t   op       /*!< [in] token that has operation type.              */
+);
+
+/*!
+ * @brief Create node of function replacing it by its value
+ * at special points of builtin functions.
+ *
+ * @note Arguments are owned by the result and freed if an error occurred.
+ *
+ * @return Created expression. If an error has been occurred it returns NULL.
+ */
+bintree_t make_func_node
+(
+	bintree_t func, /*!< [in] function name.                                 */
+	bintree_t arg   /*!< [in] function's argument.                           */
+);
+
 /*!
  * @brief Create node of number type.
  *
@@ -26,39 +26,37 @@ char* read_string (FILE* input, size_t* size)
 	assert (input);
 	assert (size);
 
-	const size_t CHUNK_SIZE = 10000;
+	// Buffer grows geometrically, so every byte is copied only a few times.
+	size_t capacity = 10000;
 	size_t len      = 0;
 	size_t was_read = 0;
-	char* str = (char*) calloc(CHUNK_SIZE, sizeof *str);
+	char* str = (char*) malloc(capacity * sizeof *str);
 	if (!str)
 	{
 		*size = 0;
 		return NULL;
 	}
 
-	while ((was_read = fread(str + len, 1, CHUNK_SIZE, input)) == CHUNK_SIZE)
+	while ((was_read = fread(str + len, 1, capacity - len - 1, input)) > 0)
 	{
-		len += CHUNK_SIZE;
-		char* realloc_check = (char*) realloc(str, (len + CHUNK_SIZE)
-		                                           * sizeof *str);
-		
+		len += was_read;
+		if (len + 1 < capacity)
+			continue;
+
+		char* realloc_check = (char*) realloc(str, 2 * capacity * sizeof *str);
 		if (!realloc_check)
 		{
-			if (fgetc(input) != EOF)
-			{
-				*size = 0;
-				free(str);
-				return NULL;
-			}
-
-			break;
+			*size = 0;
+			free(str);
+			return NULL;
 		}
 
-		str = realloc_check;
+		str       = realloc_check;
+		capacity *= 2;
 	}
 
-	len   += was_read;
-	*size  = len;
+	str[len] = '\0';
+	*size    = len;
 
 	return str;
 }
@@ -109,3 +107,27 @@ bool double_equal (double a, double b)
 	double c = b - a;
 	return -DOUBLE_PRECISION < c && c < DOUBLE_PRECISION;
 }
+
+
+size_t hash_bytes (const void* data, size_t size)
+{
+	assert (data || !size);
+
+	// FNV-1a hash.
+	const unsigned char* bytes = (const unsigned char*) data;
+	size_t               hash  = (size_t) 14695981039346656037ULL;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= (size_t) 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+
+size_t hash_combine (size_t seed, size_t hash)
+{
+	return seed ^ (hash + (size_t) 0x9E3779B97F4A7C15ULL
+	               + (seed << 6) + (seed >> 2));
+}
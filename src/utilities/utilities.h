@@ -103,6 +103,28 @@ bool double_equal
 	double b  /*!< [in] second number.                                       */
 );
 
+/*!
+ * @brief Calculate hash of memory block.
+ *
+ * @return Hash value.
+ */
+size_t hash_bytes
+(
+	const void* data, /*!< [in] memory block.                                */
+	size_t      size  /*!< [in] size of memory block.                        */
+);
+
+/*!
+ * @brief Mix hash value into another one.
+ *
+ * @return Combined hash value.
+ */
+size_t hash_combine
+(
+	size_t seed, /*!< [in] initial hash.                                     */
+	size_t hash  /*!< [in] mixed hash.                                       */
+);
+
 
 
 
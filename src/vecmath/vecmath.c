@@ -0,0 +1,638 @@
+/*!
+ * @file
+ * @brief Implementation of math functions over arrays of numbers.
+ *
+ * Vector kernels reduce argument to a small range and use polynomials there.
+ * Arguments which can't be reduced accurately (non-finite, non-positive for
+ * logarithm, very big for trigonometric functions) are passed to
+ * the standard library one by one.
+ */
+
+#include "vecmath.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+
+
+
+#ifdef VECMATH_SIMD
+
+// Kernels are always inlined, so calling convention of vectors doesn't matter.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+/*!
+ * @brief Amount of numbers in vector.
+ */
+#define VECMATH_LANES 4
+
+/*!
+ * @brief Vector of numbers.
+ */
+typedef double vecd_t __attribute__((vector_size(VECMATH_LANES
+                                                 * sizeof (double))));
+
+/*!
+ * @brief Vector of integers which has the same size as vecd_t.
+ */
+typedef int64_t veci_t __attribute__((vector_size(VECMATH_LANES
+                                                  * sizeof (int64_t))));
+
+/*!
+ * @brief Kernels are inlined into every clone of dispatched function,
+ * so they are compiled for its instruction set.
+ */
+#define VECMATH_KERNEL static inline __attribute__((always_inline))
+
+/*!
+ * @brief Apply kernel to every number of array.
+ */
+#define VECMATH_MAP(VALUES_, AMOUNT_, KERNEL_) \
+do \
+{ \
+	size_t i_ = 0; \
+	for (; i_ + VECMATH_LANES <= (AMOUNT_); i_ += VECMATH_LANES) \
+	{ \
+		vecd_t v_; \
+		memcpy(&v_, (VALUES_) + i_, sizeof v_); \
+		v_ = KERNEL_(v_); \
+		memcpy((VALUES_) + i_, &v_, sizeof v_); \
+	} \
+	\
+	if (i_ < (AMOUNT_)) \
+	{ \
+		vecd_t v_ = vec_splat(1); \
+		memcpy(&v_, (VALUES_) + i_, ((AMOUNT_) - i_) * sizeof (double)); \
+		v_ = KERNEL_(v_); \
+		memcpy((VALUES_) + i_, &v_, ((AMOUNT_) - i_) * sizeof (double)); \
+	} \
+} \
+while (false)
+
+/*!
+ * @brief Magic number which rounds number to integer when it is added.
+ */
+static const double ROUND_MAGIC = 6755399441055744.0;
+
+/*!
+ * @brief Binary logarithm of e.
+ */
+static const double LOG2_E = 1.44269504088896338700e+00;
+
+/*!
+ * @brief High part of natural logarithm of 2 with zero low bits.
+ */
+static const double LN2_HI = 6.93147180369123816490e-01;
+
+/*!
+ * @brief Low part of natural logarithm of 2.
+ */
+static const double LN2_LO = 1.90821492927058770002e-10;
+
+/*!
+ * @brief Square root of 2.
+ */
+static const double SQRT_2 = 1.41421356237309514547e+00;
+
+/*!
+ * @brief 2 / pi.
+ */
+static const double TWO_OVER_PI = 6.36619772367581382433e-01;
+
+/*!
+ * @brief Parts of pi / 2. First two have 33 significant bits,
+ * so their products by quadrant number are exact.
+ */
+static const double PIO2_1  = 1.57079632673412561417e+00;
+static const double PIO2_2  = 6.07710050630396597660e-11;
+static const double PIO2_2T = 2.02226624879595063154e-21;
+
+/*!
+ * @brief Maximal argument of trigonometric functions which is reduced
+ * by vector kernel.
+ */
+static const double TRIG_MAX = 1e5;
+
+/*!
+ * @brief Bounds of exponent argument. Outside of them result is
+ * zero or infinity anyway.
+ */
+static const double EXP_MIN = -746;
+static const double EXP_MAX = 710;
+
+/*!
+ * @brief Multiplier which splits number into two halves of 26 bits.
+ */
+static const double SPLIT = 134217729.0;
+
+/*!
+ * @brief The least number whose integer part isn't found by vec_round().
+ * Every number above it is integer.
+ */
+static const double ROUND_MAX = 0x1p51;
+
+
+
+
+/*!
+ * @brief Make vector whose numbers are equal to given one.
+ *
+ * @return Vector.
+ */
+VECMATH_KERNEL vecd_t vec_splat
+(
+	double num /*!< [in] number.                                             */
+)
+{
+	vecd_t v = {0};
+	return v + num;
+}
+
+/*!
+ * @brief Choose numbers from two vectors by mask.
+ *
+ * @return Numbers of first vector where mask is set, others from second one.
+ */
+VECMATH_KERNEL vecd_t vec_select
+(
+	veci_t mask, /*!< [in] mask of lanes.                                    */
+	vecd_t a,    /*!< [in] numbers where mask is set.                        */
+	vecd_t b     /*!< [in] numbers where mask isn't set.                     */
+)
+{
+	return (vecd_t) ((mask & (veci_t) a) | (~mask & (veci_t) b));
+}
+
+/*!
+ * @brief Round numbers to the nearest integer.
+ *
+ * @note Numbers should be less than 2^51 by absolute value.
+ *
+ * @return Rounded numbers.
+ */
+VECMATH_KERNEL vecd_t vec_round
+(
+	vecd_t v /*!< [in] numbers.                                              */
+)
+{
+	return (v + ROUND_MAGIC) - ROUND_MAGIC;
+}
+
+/*!
+ * @brief Mask of lanes which are normal positive numbers.
+ *
+ * @return Mask.
+ */
+VECMATH_KERNEL veci_t vec_positive
+(
+	vecd_t v /*!< [in] numbers.                                              */
+)
+{
+	return (v >= DBL_MIN) & (v <= DBL_MAX);
+}
+
+/*!
+ * @brief Replace lanes of result by function of argument where mask is set.
+ *
+ * @return Fixed result.
+ */
+VECMATH_KERNEL vecd_t vec_fixup
+(
+	vecd_t result,             /*!< [in] result of vector kernel.            */
+	vecd_t arg,                /*!< [in] argument.                           */
+	veci_t mask,               /*!< [in] lanes which should be replaced.     */
+	double (*func) (double)    /*!< [in] function of standard library.       */
+)
+{
+	for (size_t i = 0; i < VECMATH_LANES; ++i)
+		if (mask[i])
+			result[i] = func(arg[i]);
+
+	return result;
+}
+
+/*!
+ * @brief Multiply numbers without rounding error.
+ *
+ * @note Contraction to fma must be off, as it is in ISO C mode of GCC.
+ *
+ * @return Rounded products, their exact errors are in error.
+ */
+VECMATH_KERNEL vecd_t vec_mul_exact
+(
+	vecd_t  a,    /*!< [in]  first factors.                                  */
+	vecd_t  b,    /*!< [in]  second factors.                                 */
+	vecd_t* error /*!< [out] errors of products.                             */
+)
+{
+	vecd_t a_split = a * SPLIT;
+	vecd_t b_split = b * SPLIT;
+	vecd_t a_hi    = a_split - (a_split - a);
+	vecd_t b_hi    = b_split - (b_split - b);
+	vecd_t a_lo    = a - a_hi;
+	vecd_t b_lo    = b - b_hi;
+
+	vecd_t product = a * b;
+	*error = ((a_hi * b_hi - product) + a_hi * b_lo + a_lo * b_hi)
+	         + a_lo * b_lo;
+	return product;
+}
+
+/*!
+ * @brief Calculate exponent of sum of number and its small correction.
+ *
+ * @return Exponent of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_exp
+(
+	vecd_t x,  /*!< [in] numbers.                                            */
+	vecd_t low /*!< [in] corrections of numbers.                             */
+)
+{
+	veci_t nan = ~((x >= EXP_MIN) | (x < EXP_MIN));
+	vecd_t arg = vec_select(x < EXP_MIN, vec_splat(EXP_MIN), x);
+	arg        = vec_select(arg > EXP_MAX, vec_splat(EXP_MAX), arg);
+	arg        = vec_select(nan, vec_splat(0), arg);
+
+	// x = n * ln(2) + r where |r| <= ln(2) / 2.
+	vecd_t n = vec_round(arg * LOG2_E);
+	vecd_t r = ((arg - n * LN2_HI) - n * LN2_LO) + low;
+
+	vecd_t p = vec_splat(1.0 / 6227020800);
+	p = p * r + 1.0 / 479001600;
+	p = p * r + 1.0 / 39916800;
+	p = p * r + 1.0 / 3628800;
+	p = p * r + 1.0 / 362880;
+	p = p * r + 1.0 / 40320;
+	p = p * r + 1.0 / 5040;
+	p = p * r + 1.0 / 720;
+	p = p * r + 1.0 / 120;
+	p = p * r + 1.0 / 24;
+	p = p * r + 1.0 / 6;
+	p = p * r + 1.0 / 2;
+	p = p * r + 1;
+	p = p * r + 1;
+
+	// 2^n is applied in two steps so that overflow and underflow
+	// give infinity and subnormal numbers.
+	veci_t exp  = __builtin_convertvector(n, veci_t);
+	veci_t exp1 = exp >> 1;
+	veci_t exp2 = exp - exp1;
+	p = p * (vecd_t) ((exp1 + 1023) << 52);
+	p = p * (vecd_t) ((exp2 + 1023) << 52);
+	return vec_select(nan, x, p);
+}
+
+/*!
+ * @brief Split normal positive numbers into mantissa and exponent,
+ * x = m * 2^e where sqrt(2) / 2 <= m < sqrt(2).
+ *
+ * @return Exponents of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_frexp
+(
+	vecd_t  x,       /*!< [in]  numbers.                                     */
+	vecd_t* mantissa /*!< [out] mantissas of numbers.                        */
+)
+{
+	veci_t bits = (veci_t) x;
+	veci_t exp  = ((bits >> 52) & 0x7FF) - 1023;
+	vecd_t m    = (vecd_t) ((bits & 0x000FFFFFFFFFFFFF) | 0x3FF0000000000000);
+	veci_t big  = m > SQRT_2;
+
+	*mantissa = vec_select(big, m * 0.5, m);
+	return __builtin_convertvector(exp - big, vecd_t);
+}
+
+/*!
+ * @brief Calculate atanh(s) - s for |s| < 0.18.
+ *
+ * @return Tail of series of inverse hyperbolic tangent.
+ */
+VECMATH_KERNEL vecd_t vec_atanh_tail
+(
+	vecd_t s /*!< [in] numbers.                                              */
+)
+{
+	vecd_t z = s * s;
+	vecd_t p = vec_splat(1.0 / 21);
+	p = p * z + 1.0 / 19;
+	p = p * z + 1.0 / 17;
+	p = p * z + 1.0 / 15;
+	p = p * z + 1.0 / 13;
+	p = p * z + 1.0 / 11;
+	p = p * z + 1.0 / 9;
+	p = p * z + 1.0 / 7;
+	p = p * z + 1.0 / 5;
+	p = p * z + 1.0 / 3;
+	return p * z * s;
+}
+
+/*!
+ * @brief Calculate natural logarithm.
+ *
+ * @return Logarithm of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_ln
+(
+	vecd_t x /*!< [in] numbers.                                              */
+)
+{
+	veci_t special = ~vec_positive(x);
+	vecd_t m;
+	vecd_t e = vec_frexp(vec_select(special, vec_splat(1), x), &m);
+
+	// ln(m) = 2 * atanh(s) where s = (m - 1) / (m + 1), |s| < 0.18.
+	vecd_t f = m - 1;
+	vecd_t s = f / (f + 2);
+	vecd_t p = vec_atanh_tail(s);
+
+	vecd_t result = e * LN2_HI + (2 * s + (2 * p + e * LN2_LO));
+	return vec_fixup(result, x, special, log);
+}
+
+/*!
+ * @brief Calculate natural logarithm of normal positive numbers
+ * with twice the precision of double.
+ *
+ * @return High parts of logarithms, their low parts are in low.
+ */
+VECMATH_KERNEL vecd_t vec_ln_exact
+(
+	vecd_t  x,  /*!< [in]  numbers.                                          */
+	vecd_t* low /*!< [out] low parts of logarithms.                          */
+)
+{
+	vecd_t m;
+	vecd_t e = vec_frexp(x, &m);
+
+	// f is exact, f + 2 and quotient s are refined by their errors.
+	vecd_t f    = m - 1;
+	vecd_t d    = f + 2;
+	vecd_t d_lo = (2 - d) + f;
+	vecd_t s    = f / d;
+	vecd_t error;
+	vecd_t product = vec_mul_exact(s, d, &error);
+	vecd_t s_lo    = (((f - product) - error) - s * d_lo) / d;
+	vecd_t p       = vec_atanh_tail(s);
+
+	// e * LN2_HI and 2 * s are exact and the first one is bigger.
+	vecd_t head = e * LN2_HI;
+	vecd_t hi   = head + 2 * s;
+	vecd_t lo   = (2 * s - (hi - head)) + (2 * s_lo + (2 * p + e * LN2_LO));
+
+	vecd_t result = hi + lo;
+	*low = lo - (result - hi);
+	return result;
+}
+
+/*!
+ * @brief Calculate sine and cosine together.
+ *
+ * @return Mask of lanes which should be calculated by standard library.
+ */
+VECMATH_KERNEL veci_t vec_sincos
+(
+	vecd_t  x,      /*!< [in]  numbers.                                      */
+	vecd_t* sine,   /*!< [out] sine of numbers.                              */
+	vecd_t* cosine  /*!< [out] cosine of numbers.                            */
+)
+{
+	veci_t special = ~((x >= -TRIG_MAX) & (x <= TRIG_MAX));
+	vecd_t arg     = vec_select(special, vec_splat(0), x);
+
+	// x = q * pi / 2 + r where |r| <= pi / 4.
+	vecd_t q = vec_round(arg * TWO_OVER_PI);
+	vecd_t r = ((arg - q * PIO2_1) - q * PIO2_2) - q * PIO2_2T;
+	vecd_t z = r * r;
+
+	vecd_t s = vec_splat(1.0 / 355687428096000);
+	s = s * z - 1.0 / 1307674368000;
+	s = s * z + 1.0 / 6227020800;
+	s = s * z - 1.0 / 39916800;
+	s = s * z + 1.0 / 362880;
+	s = s * z - 1.0 / 5040;
+	s = s * z + 1.0 / 120;
+	s = s * z - 1.0 / 6;
+	s = r + r * z * s;
+
+	vecd_t c = vec_splat(-1.0 / 6402373705728000);
+	c = c * z + 1.0 / 20922789888000;
+	c = c * z - 1.0 / 87178291200;
+	c = c * z + 1.0 / 479001600;
+	c = c * z - 1.0 / 3628800;
+	c = c * z + 1.0 / 40320;
+	c = c * z - 1.0 / 720;
+	c = c * z + 1.0 / 24;
+	c = c * z - 1.0 / 2;
+	c = 1 + z * c;
+
+	// sin(x) and cos(x) are +-sin(r) or +-cos(r) depending on quadrant.
+	veci_t quadrant = __builtin_convertvector(q, veci_t) & 3;
+	veci_t swap     = (quadrant & 1) != 0;
+	veci_t sin_neg  = (quadrant & 2) != 0;
+	veci_t cos_neg  = ((quadrant + 1) & 2) != 0;
+	vecd_t sin_abs  = vec_select(swap, c, s);
+	vecd_t cos_abs  = vec_select(swap, s, c);
+	*sine   = vec_select(sin_neg, -sin_abs, sin_abs);
+	*cosine = vec_select(cos_neg, -cos_abs, cos_abs);
+	return special;
+}
+
+/*!
+ * @brief Calculate sine.
+ *
+ * @return Sine of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_sin
+(
+	vecd_t x /*!< [in] numbers.                                              */
+)
+{
+	vecd_t s, c;
+	veci_t special = vec_sincos(x, &s, &c);
+	return vec_fixup(s, x, special, sin);
+}
+
+/*!
+ * @brief Calculate cosine.
+ *
+ * @return Cosine of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_cos
+(
+	vecd_t x /*!< [in] numbers.                                              */
+)
+{
+	vecd_t s, c;
+	veci_t special = vec_sincos(x, &s, &c);
+	return vec_fixup(c, x, special, cos);
+}
+
+/*!
+ * @brief Calculate tangent.
+ *
+ * @return Tangent of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_tg
+(
+	vecd_t x /*!< [in] numbers.                                              */
+)
+{
+	vecd_t s, c;
+	veci_t special = vec_sincos(x, &s, &c);
+	return vec_fixup(s / c, x, special, tan);
+}
+
+/*!
+ * @brief Calculate cotangent of one number.
+ *
+ * @return Cotangent of number.
+ */
+static double ctg
+(
+	double x /*!< [in] number.                                               */
+)
+{
+	return 1 / tan(x);
+}
+
+/*!
+ * @brief Calculate cotangent.
+ *
+ * @return Cotangent of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_ctg
+(
+	vecd_t x /*!< [in] numbers.                                              */
+)
+{
+	vecd_t s, c;
+	veci_t special = vec_sincos(x, &s, &c);
+	return vec_fixup(c / s, x, special, ctg);
+}
+
+/*!
+ * @brief Raise numbers to the power.
+ *
+ * @return Powers of numbers.
+ */
+VECMATH_KERNEL vecd_t vec_pow
+(
+	vecd_t base,    /*!< [in] bases.                                         */
+	vecd_t exponent /*!< [in] exponents.                                     */
+)
+{
+	// Negative bases and special numbers are left to the standard library.
+	// So are integer exponents, whose powers such as 7^2 are often exact.
+	veci_t small   = (exponent > -ROUND_MAX) & (exponent < ROUND_MAX);
+	vecd_t whole   = vec_select(small, vec_round(exponent), exponent);
+	veci_t special = ~(vec_positive(base)
+	                   & (exponent >= -DBL_MAX) & (exponent <= DBL_MAX))
+	                 | (whole == exponent);
+	vecd_t arg     = vec_select(special, vec_splat(1), base);
+
+	// Error of logarithm is multiplied by exponent, so both of them
+	// are kept with twice the precision.
+	vecd_t ln_lo;
+	vecd_t ln_hi = vec_ln_exact(arg, &ln_lo);
+	vecd_t error;
+	vecd_t hi = vec_mul_exact(exponent, ln_hi, &error);
+	vecd_t lo = error + exponent * ln_lo;
+
+	// Products which overflow give zero or infinity anyway.
+	vecd_t result = vec_exp(hi, vec_select(lo == lo, lo, vec_splat(0)));
+	for (size_t i = 0; i < VECMATH_LANES; ++i)
+		if (special[i])
+			result[i] = pow(base[i], exponent[i]);
+
+	return result;
+}
+
+#endif // defined VECMATH_SIMD
+
+
+
+
+VECMATH_DISPATCH
+void vecmath_sin (double* values, size_t amount)
+{
+#ifdef VECMATH_SIMD
+	VECMATH_MAP(values, amount, vec_sin);
+#else
+	for (size_t i = 0; i < amount; ++i)
+		values[i] = sin(values[i]);
+#endif
+}
+
+
+VECMATH_DISPATCH
+void vecmath_cos (double* values, size_t amount)
+{
+#ifdef VECMATH_SIMD
+	VECMATH_MAP(values, amount, vec_cos);
+#else
+	for (size_t i = 0; i < amount; ++i)
+		values[i] = cos(values[i]);
+#endif
+}
+
+
+VECMATH_DISPATCH
+void vecmath_tg (double* values, size_t amount)
+{
+#ifdef VECMATH_SIMD
+	VECMATH_MAP(values, amount, vec_tg);
+#else
+	for (size_t i = 0; i < amount; ++i)
+		values[i] = tan(values[i]);
+#endif
+}
+
+
+VECMATH_DISPATCH
+void vecmath_ctg (double* values, size_t amount)
+{
+#ifdef VECMATH_SIMD
+	VECMATH_MAP(values, amount, vec_ctg);
+#else
+	for (size_t i = 0; i < amount; ++i)
+		values[i] = 1 / tan(values[i]);
+#endif
+}
+
+
+VECMATH_DISPATCH
+void vecmath_ln (double* values, size_t amount)
+{
+#ifdef VECMATH_SIMD
+	VECMATH_MAP(values, amount, vec_ln);
+#else
+	for (size_t i = 0; i < amount; ++i)
+		values[i] = log(values[i]);
+#endif
+}
+
+
+VECMATH_DISPATCH
+void vecmath_pow (double* bases, const double* exponents, size_t amount)
+{
+	size_t i = 0;
+#ifdef VECMATH_SIMD
+	for (; i + VECMATH_LANES <= amount; i += VECMATH_LANES)
+	{
+		vecd_t base;
+		vecd_t exponent;
+		memcpy(&base,     bases     + i, sizeof base);
+		memcpy(&exponent, exponents + i, sizeof exponent);
+		base = vec_pow(base, exponent);
+		memcpy(bases + i, &base, sizeof base);
+	}
+#endif
+
+	for (; i < amount; ++i)
+		bases[i] = pow(bases[i], exponents[i]);
+}
@@ -0,0 +1,96 @@
+/*!
+ * @file
+ * @brief Header of math functions over arrays of numbers.
+ *
+ * Functions process several numbers at once using SIMD instructions.
+ * On x86-64 the best instruction set (AVX2 or SSE2) is chosen at runtime.
+ * Without GCC vector extensions or with VECMATH_SCALAR defined functions
+ * of the standard library are called for every number.
+ */
+
+#ifndef VECMATH_H_
+#define VECMATH_H_
+
+#include <stddef.h>
+
+
+
+#if defined(__GNUC__) && !defined(VECMATH_SCALAR)
+/*!
+ * @brief Vector kernels are used.
+ */
+#	define VECMATH_SIMD
+#endif
+
+#if defined(VECMATH_SIMD) && defined(__x86_64__)
+/*!
+ * @brief Compile function for several instruction sets and choose one
+ * of them at runtime.
+ */
+#	define VECMATH_DISPATCH __attribute__((target_clones("avx2", "default")))
+#else
+#	define VECMATH_DISPATCH
+#endif
+
+
+
+/*!
+ * @brief Replace every number of array by its sine.
+ */
+void vecmath_sin
+(
+	double* values, /*!< [in,out] array of numbers.                          */
+	size_t  amount  /*!< [in]     amount of numbers.                         */
+);
+
+/*!
+ * @brief Replace every number of array by its cosine.
+ */
+void vecmath_cos
+(
+	double* values, /*!< [in,out] array of numbers.                          */
+	size_t  amount  /*!< [in]     amount of numbers.                         */
+);
+
+/*!
+ * @brief Replace every number of array by its tangent.
+ */
+void vecmath_tg
+(
+	double* values, /*!< [in,out] array of numbers.                          */
+	size_t  amount  /*!< [in]     amount of numbers.                         */
+);
+
+/*!
+ * @brief Replace every number of array by its cotangent.
+ */
+void vecmath_ctg
+(
+	double* values, /*!< [in,out] array of numbers.                          */
+	size_t  amount  /*!< [in]     amount of numbers.                         */
+);
+
+/*!
+ * @brief Replace every number of array by its natural logarithm.
+ */
+void vecmath_ln
+(
+	double* values, /*!< [in,out] array of numbers.                          */
+	size_t  amount  /*!< [in]     amount of numbers.                         */
+);
+
+/*!
+ * @brief Raise every number of array to the power of corresponding
+ * exponent.
+ */
+void vecmath_pow
+(
+	double*       bases,     /*!< [in,out] array of bases.                   */
+	const double* exponents, /*!< [in]     array of exponents.               */
+	size_t        amount     /*!< [in]     amount of numbers.                */
+);
+
+
+
+
+#endif // not defined VECMATH_H_
@@ -0,0 +1,58 @@
+/*!
+ * @file
+ * @brief Regression test of releasing nodes to their own arena.
+ *
+ * Tree is destroyed while another arena is selected. Its nodes should
+ * return to the arena they were allocated from, otherwise the selected
+ * arena reuses them after their arena is destroyed. The test is run
+ * with -fsanitize=address, which reports such use.
+ */
+
+#include "common/test_utils.h"
+#include "../src/parser/symbol.h"
+
+#include <stdio.h>
+
+
+
+
+int main (void)
+{
+#ifdef BINTREE_COMPACT
+	// Node of compact tree must be destroyed while its arena is selected.
+	symbol_table_destroy();
+	return 0;
+#else
+	bintree_arena_t owner    = bintree_arena_create();
+	bintree_arena_t selected = bintree_arena_create();
+	if (!owner || !selected)
+	{
+		bintree_arena_destroy(selected);
+		bintree_arena_destroy(owner);
+		return 1;
+	}
+
+	bintree_arena_select(owner);
+	bintree_t tree = test_parse("sin(x) * cos(x) + x ^ 2");
+	bool      ret  = tree;
+
+	bintree_arena_select(selected);
+	bintree_destroy(tree);
+	bintree_arena_destroy(owner);
+
+	// New nodes are taken from the selected arena only.
+	for (int i = 0; ret && i < 4; ++i)
+	{
+		bintree_t other = test_parse("ln(x) / (1 + x)");
+		ret = other && BINTREE_NODE_LEFT(other);
+		bintree_destroy(other);
+	}
+
+	if (!ret)
+		fputs("Nodes are released to another arena.\n", stderr);
+
+	bintree_arena_destroy(selected);
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+#endif
+}
@@ -0,0 +1,93 @@
+/*!
+ * @file
+ * @brief Regression test of evaluation of bytecode at many points.
+ *
+ * Batch is evaluated by vector kernels, its values should be close to
+ * values of bytecode at every point. Amount of points isn't a multiple
+ * of vector size, so the tail is checked too.
+ */
+
+#include "common/test_utils.h"
+#include "../src/bytecode/bytecode.h"
+#include "../src/parser/symbol.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+
+/*!
+ * @brief Checked expressions.
+ */
+static const char* const EXPRESSIONS[] =
+{
+	"x ^ 3 - 2 * x + 1",
+	"sin(2 * x) * cos(x) - tg(x / 4) + ctg(x + 0.5)",
+	"e ^ (x / 3) * ln(x * x + 1) - pi",
+	"(x * x + 1) ^ (x / 2) - 2 ^ x + x ^ 2",
+	"7",
+};
+
+/*!
+ * @brief Amount of points.
+ */
+enum { AMOUNT = 1027 };
+
+
+
+
+/*!
+ * @brief Compare batch evaluation of expression with point-wise one.
+ *
+ * @return Checking result.
+ */
+static bool batch_matches_points
+(
+	const char* str /*!< [in] expression in text format.                     */
+)
+{
+	static double x[AMOUNT];
+	static double values[AMOUNT];
+	for (size_t i = 0; i < AMOUNT; ++i)
+		x[i] = -8 + 16 * (double) i / AMOUNT;
+
+	bintree_t  expression = test_parse(str);
+	bytecode_t code       = (expression) ? bytecode_compile(expression)
+	                                     : NULL;
+	bool       ret        = code
+	                        && bytecode_evaluate_batch(code, x, values,
+	                                                   AMOUNT);
+	for (size_t i = 0; ret && i < AMOUNT; ++i)
+	{
+		double expected = bytecode_evaluate(code, x[i]);
+		if (isnan(expected) && isnan(values[i]))
+			continue;
+
+		if (!(fabs(values[i] - expected) <= 1e-13 * fmax(1, fabs(expected))))
+		{
+			fprintf(stderr, "Batch of %s at %g is %.17g, "
+			                "single point gives %.17g\n",
+			        str, x[i], values[i], expected);
+			ret = false;
+		}
+	}
+
+	bytecode_destroy(code);
+	bintree_destroy(expression);
+	return ret;
+}
+
+
+
+
+int main (void)
+{
+	bool ret = true;
+	for (size_t i = 0; i < sizeof EXPRESSIONS / sizeof *EXPRESSIONS; ++i)
+		ret = batch_matches_points(EXPRESSIONS[i]) && ret;
+
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
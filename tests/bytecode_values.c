@@ -0,0 +1,188 @@
+/*!
+ * @file
+ * @brief Regression test of bytecode of expressions.
+ *
+ * Bytecode compiled from tree and from the hash-consed store should give
+ * the same values as the same expressions written in C.
+ */
+
+#include "common/test_utils.h"
+#include "../src/bytecode/bytecode.h"
+#include "../src/dag/dag.h"
+#include "../src/parser/symbol.h"
+
+#include <math.h>
+#include <stdio.h>
+
+
+
+
+/*!
+ * @brief Expression and its reference function.
+ */
+struct checked_expression
+{
+	const char* str;                   /*!< expression in text format.       */
+	double      (*function) (double);  /*!< the same expression in C.        */
+};
+
+/*!
+ * @brief Polynomial.
+ *
+ * @return Value of function.
+ */
+static double poly
+(
+	double x /*!< [in] argument.                                             */
+)
+{
+	return -x * x * x + 2 * x - 1.5;
+}
+
+/*!
+ * @brief Product of trigonometric functions.
+ *
+ * @return Value of function.
+ */
+static double trig
+(
+	double x /*!< [in] argument.                                             */
+)
+{
+	return sin(2 * x) * cos(x) - tan(x / 4);
+}
+
+/*!
+ * @brief Cotangent and fraction.
+ *
+ * @return Value of function.
+ */
+static double cotg
+(
+	double x /*!< [in] argument.                                             */
+)
+{
+	return 1 / tan(x + 0.5) - 3 / (1 + x * x);
+}
+
+/*!
+ * @brief Exponent, logarithm and constant.
+ *
+ * @return Value of function.
+ */
+static double expo
+(
+	double x /*!< [in] argument.                                             */
+)
+{
+	return exp(x) * log(x * x + 1) + M_PI;
+}
+
+/*!
+ * @brief Powers with variable exponents.
+ *
+ * @return Value of function.
+ */
+static double powx
+(
+	double x /*!< [in] argument.                                             */
+)
+{
+	return pow(fabs(x) + 1, x) - pow(2, -x);
+}
+
+/*!
+ * @brief Expression with repeated subexpression.
+ *
+ * @return Value of function.
+ */
+static double same
+(
+	double x /*!< [in] argument.                                             */
+)
+{
+	double u = sin(x) + x;
+	return u * u / (u + 1);
+}
+
+/*!
+ * @brief Checked expressions.
+ */
+static const struct checked_expression EXPRESSIONS[] =
+{
+	{"-x * x * x + 2 * x - 1.5",                       poly},
+	{"sin(2 * x) * cos(x) - tg(x / 4)",                trig},
+	{"ctg(x + 0.5) - 3 / (1 + x ^ 2)",                 cotg},
+	{"e ^ x * ln(x * x + 1) + pi",                     expo},
+	{"((x * x) ^ 0.5 + 1) ^ x - 2 ^ (-x)",             powx},
+	{"(sin(x) + x) * (sin(x) + x) / (sin(x) + x + 1)", same},
+};
+
+/*!
+ * @brief Points where expressions are evaluated.
+ */
+static const double POINTS[] = {-2.5, -1, -0.3, 0, 0.7, 1, 3.25, 10};
+
+
+
+
+/*!
+ * @brief Compare values of bytecode of expression with its function.
+ *
+ * @return Checking result.
+ */
+static bool bytecode_matches_c
+(
+	const struct checked_expression* checked /*!< [in] expression.           */
+)
+{
+	bintree_t   expression = test_parse(checked->str);
+	dag_store_t store      = dag_store_create();
+	dag_t       root       = (expression && store)
+	                         ? dag_from_bintree(store, expression) : DAG_NONE;
+	bytecode_t  tree_code  = (expression) ? bytecode_compile(expression)
+	                                      : NULL;
+	bytecode_t  dag_code   = (root != DAG_NONE)
+	                         ? bytecode_compile_dag(store, root) : NULL;
+	bool        ret        = tree_code && dag_code;
+	for (size_t i = 0; ret && i < sizeof POINTS / sizeof *POINTS; ++i)
+	{
+		double expected = checked->function(POINTS[i]);
+		double values[] = {bytecode_evaluate(tree_code, POINTS[i]),
+		                   bytecode_evaluate(dag_code,  POINTS[i])};
+		for (size_t j = 0; j < sizeof values / sizeof *values; ++j)
+		{
+			if (isnan(expected) && isnan(values[j]))
+				continue;
+
+			if (!(fabs(values[j] - expected)
+			      <= 1e-12 * fmax(1, fabs(expected))))
+			{
+				fprintf(stderr, "Bytecode of %s from %s at %g is %.17g, "
+				                "C gives %.17g\n", checked->str,
+				        (j) ? "store" : "tree", POINTS[i], values[j],
+				        expected);
+				ret = false;
+			}
+		}
+	}
+
+	bytecode_destroy(dag_code);
+	bytecode_destroy(tree_code);
+	dag_store_destroy(store);
+	bintree_destroy(expression);
+	return ret;
+}
+
+
+
+
+int main (void)
+{
+	bool ret = true;
+	for (size_t i = 0; i < sizeof EXPRESSIONS / sizeof *EXPRESSIONS; ++i)
+		ret = bytecode_matches_c(&EXPRESSIONS[i]) && ret;
+
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
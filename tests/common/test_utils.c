@@ -0,0 +1,21 @@
+/*!
+ * @file
+ * @brief Implementation of helpers which are shared by tests.
+ */
+
+#include "test_utils.h"
+#include "../../src/parser/parser.h"
+
+
+
+
+bintree_t test_parse (const char* str)
+{
+	parser_t parser;
+	if (!parser_init(&parser, str))
+		return BINTREE_NULL;
+
+	bintree_t tree = parse_expr(&parser);
+	parser_deinit(&parser);
+	return tree;
+}
@@ -0,0 +1,28 @@
+/*!
+ * @file
+ * @brief Header of helpers which are shared by tests.
+ */
+
+#ifndef TEST_UTILS_H_
+#define TEST_UTILS_H_
+
+#include "../../src/tree/bintree.h"
+
+
+
+/*!
+ * @brief Parse expression.
+ *
+ * @note Don't forget to free memory using bintree_destroy() function.
+ *
+ * @return Expression or NULL if an error occurred.
+ */
+bintree_t test_parse
+(
+	const char* str /*!< [in] expression in text format.                     */
+);
+
+
+
+
+#endif // not defined TEST_UTILS_H_
@@ -0,0 +1,166 @@
+/*!
+ * @file
+ * @brief Regression test of export of derivatives as C source code.
+ *
+ * Exported source is compiled with a small driver by the C compiler and
+ * run at several points. Its values should be the same as values of
+ * bytecode of derivatives.
+ */
+
+#include "common/test_utils.h"
+#include "../src/bytecode/bytecode.h"
+#include "../src/differentiator.h"
+#include "../src/export/export.h"
+#include "../src/parser/symbol.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Exported expression.
+ */
+static const char* const EXPRESSION = "sin(x) * e ^ (2 * x) / (1 + x ^ 2) "
+                                      "- ln(x) + tg(x / 3)";
+
+/*!
+ * @brief Order of the last derivative.
+ */
+enum { ORDER = 3 };
+
+/*!
+ * @brief Points where derivatives are evaluated.
+ */
+static const double POINTS[] = {0.3, 1.1, 2.7};
+
+/*!
+ * @brief Driver which prints derivatives at points from its arguments.
+ */
+static const char* const DRIVER =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"void derivatives (double x, double result[]);\n"
+	"int main (int argc, char* argv[])\n"
+	"{\n"
+	"\tdouble result[64];\n"
+	"\tfor (int i = 1; i < argc; ++i)\n"
+	"\t{\n"
+	"\t\tderivatives(strtod(argv[i], NULL), result);\n"
+	"\t\tfor (int j = 0; j <= %d; ++j)\n"
+	"\t\t\tprintf(\"%%a\\n\", result[j]);\n"
+	"\t}\n"
+	"\treturn 0;\n"
+	"}\n";
+
+
+
+
+/*!
+ * @brief Write exported derivatives and driver to directory.
+ *
+ * @return Success of writing.
+ */
+static bool write_sources
+(
+	const char*      dir,        /*!< [in] directory.                        */
+	const bintree_t* derivatives /*!< [in] derivatives.                      */
+)
+{
+	char  path[256] = "";
+	snprintf(path, sizeof path, "%s/derivatives.c", dir);
+	FILE* output = fopen(path, "w");
+	bool  ret    = output && export_c(output, derivatives, ORDER);
+	if (output && fclose(output))
+		ret = false;
+
+	snprintf(path, sizeof path, "%s/driver.c", dir);
+	output = fopen(path, "w");
+	ret    = output && fprintf(output, DRIVER, ORDER) > 0 && ret;
+	if (output && fclose(output))
+		ret = false;
+
+	return ret;
+}
+
+/*!
+ * @brief Compile exported derivatives, run them and compare with bytecode.
+ *
+ * @return Checking result.
+ */
+static bool exported_matches_bytecode
+(
+	const char*      dir,        /*!< [in] directory of sources.             */
+	const bintree_t* derivatives /*!< [in] derivatives.                      */
+)
+{
+	char command[512] = "";
+	snprintf(command, sizeof command, "cc -std=c11 -o %s/driver "
+	         "%s/driver.c %s/derivatives.c -lm", dir, dir, dir);
+	if (!write_sources(dir, derivatives) || system(command))
+	{
+		fputs("Cannot compile exported derivatives.\n", stderr);
+		return false;
+	}
+
+	int length = snprintf(command, sizeof command, "%s/driver", dir);
+	for (size_t i = 0; i < sizeof POINTS / sizeof *POINTS; ++i)
+		length += snprintf(command + length, sizeof command - (size_t) length,
+		                   " %a", POINTS[i]);
+
+	FILE* values = popen(command, "r");
+	bool  ret    = values;
+	for (size_t i = 0; ret && i < sizeof POINTS / sizeof *POINTS; ++i)
+		for (size_t j = 0; ret && j <= ORDER; ++j)
+		{
+			char       line[64] = "";
+			bytecode_t code     = bytecode_compile(derivatives[j]);
+			double     expected = (code) ? bytecode_evaluate(code, POINTS[i])
+			                             : NAN;
+			double     value    = (fgets(line, sizeof line, values))
+			                      ? strtod(line, NULL) : NAN;
+			bytecode_destroy(code);
+			if (!(fabs(value - expected) <= 1e-12 * fmax(1, fabs(expected))))
+			{
+				fprintf(stderr, "Exported derivative %zu at %g is %.17g, "
+				                "bytecode gives %.17g\n",
+				        j, POINTS[i], value, expected);
+				ret = false;
+			}
+		}
+
+	if (values && pclose(values))
+		ret = false;
+
+	return ret;
+}
+
+
+
+
+int main (void)
+{
+	char      dir[]                  = "/tmp/export_compile_XXXXXX";
+	bintree_t derivatives[ORDER + 1] = {test_parse(EXPRESSION)};
+	for (size_t i = 1; i <= ORDER && derivatives[i - 1]; ++i)
+		derivatives[i] = differentiate(derivatives[i - 1], NULL,
+		                               DIFF_VERBOSITY_NONE);
+
+	bool ret = derivatives[ORDER] && mkdtemp(dir)
+	           && exported_matches_bytecode(dir, derivatives);
+
+	// Directory is removed with everything which was written there.
+	char command[64] = "";
+	snprintf(command, sizeof command, "rm -rf %s", dir);
+	if (strcmp(dir + strlen(dir) - 6, "XXXXXX") && system(command))
+		ret = false;
+
+	for (size_t i = 0; i <= ORDER; ++i)
+		bintree_destroy(derivatives[i]);
+
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/*!
+ * @file
+ * @brief Regression test of native code of expressions.
+ *
+ * Values of compiled expressions should be the same as values of
+ * their bytecode. Expression without numbers has no constant pool,
+ * too deep expression is evaluated by bytecode instead of native code.
+ */
+
+#include "common/test_utils.h"
+#include "../src/bytecode/bytecode.h"
+#include "../src/jit/jit.h"
+#include "../src/parser/symbol.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Points where expressions are evaluated.
+ */
+static const double POINTS[] = {-2.5, -1, -0.3, 0, 0.7, 1, 3.25, 10};
+
+/*!
+ * @brief Depth of expression which has no native code.
+ */
+enum { DEEP_DEPTH = 5000 };
+
+
+
+
+/*!
+ * @brief Compare values of native code and bytecode of expression.
+ *
+ * @return Checking result.
+ */
+static bool jit_matches_bytecode
+(
+	const char* str,   /*!< [in] expression in text format.                  */
+	bool        native /*!< [in] whether native code is expected.            */
+)
+{
+	bintree_t  expression = test_parse(str);
+	jit_t      jit        = (expression) ? jit_compile(expression) : NULL;
+	bytecode_t code       = (expression) ? bytecode_compile(expression)
+	                                     : NULL;
+	bool       ret        = jit && code;
+	if (ret && (jit_function(jit) != NULL) != native)
+	{
+		fprintf(stderr, "Expression %.40s has %snative code.\n",
+		        str, (native) ? "no " : "");
+		ret = false;
+	}
+
+	for (size_t i = 0; ret && i < sizeof POINTS / sizeof *POINTS; ++i)
+	{
+		double expected = bytecode_evaluate(code, POINTS[i]);
+		double value    = jit_evaluate(jit, POINTS[i]);
+		if (isnan(expected) && isnan(value))
+			continue;
+
+		if (!(fabs(value - expected) <= 1e-12 * fmax(1, fabs(expected))))
+		{
+			fprintf(stderr, "Expression %.40s at %g is %.17g, "
+			                "bytecode gives %.17g\n",
+			        str, POINTS[i], value, expected);
+			ret = false;
+		}
+	}
+
+	bytecode_destroy(code);
+	jit_destroy(jit);
+	bintree_destroy(expression);
+	return ret;
+}
+
+/*!
+ * @brief Build expression x - (x - (... - x)) of given depth.
+ *
+ * @return Expression in text format or NULL if an error occurred.
+ */
+static char* deep_expression
+(
+	size_t depth /*!< [in] amount of subtractions.                           */
+)
+{
+	char* str = (char*) malloc(depth * 4 + 2);
+	if (!str)
+		return NULL;
+
+	char* curr = str;
+	for (size_t i = 0; i < depth; ++i, curr += 3)
+		memcpy(curr, "x-(", 3);
+
+	*curr++ = 'x';
+	memset(curr, ')', depth);
+	curr[depth] = '\0';
+	return str;
+}
+
+
+
+
+int main (void)
+{
+	// Native code exists only on x86-64.
+#if defined(__x86_64__) && defined(__unix__)
+	bool native = true;
+#else
+	bool native = false;
+#endif
+
+	bool ret = jit_matches_bytecode("x * x", native)
+	           & jit_matches_bytecode("-x / (x - 3) + x ^ 3", native)
+	           & jit_matches_bytecode("sin(2 * x) * cos(x) - tg(x / 4)",
+	                                  native)
+	           & jit_matches_bytecode("e ^ x * ln(x * x + 1) + pi", native)
+	           & jit_matches_bytecode("2 ^ x - ctg(x + 0.5) / (1 + x * x)",
+	                                  native);
+
+	char* deep = deep_expression(DEEP_DEPTH);
+	ret = deep && jit_matches_bytecode(deep, false) && ret;
+	free(deep);
+
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/*!
+ * @file
+ * @brief Regression test of reading numbers by lexer.
+ *
+ * Short numbers are rounded by one floating-point operation, others
+ * are converted by strtod(). Both ways should give the same number
+ * as strtod() does.
+ */
+
+#include "common/test_utils.h"
+#include "../src/parser/symbol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Numbers in text format.
+ */
+static const char* const NUMBERS[] =
+{
+	"0", "0.0", "7", "0.1", "0.3", "2.5e-3", "1E22", "1e23", "8.5e-1",
+	"9007199254740992", "9007199254740993", "18446744073709551615",
+	"123456789012345678901234567890",
+	"3.14159265358979323846264338327950288419716939937510",
+	"0.30000000000000004441", "0.000000000000000000000000000000001",
+	"1234567890123456789.25e-5", "100000000000000000000000e-24",
+	"1.7976931348623157e308", "1.7976931348623159e308", "1e400",
+	"2.2250738585072014e-308", "4.9406564584124654e-324", "1e-400",
+	"123e-20", "0.000123e+27", "5e+0", "1.e5", "12.5E-07",
+};
+
+
+
+
+int main (void)
+{
+	bool ret = true;
+	for (size_t i = 0; i < sizeof NUMBERS / sizeof *NUMBERS; ++i)
+	{
+		bintree_t tree     = test_parse(NUMBERS[i]);
+		double    expected = strtod(NUMBERS[i], NULL);
+		if (!tree || BINTREE_NODE_VALUE(tree).type != TOKEN_NUMBER)
+		{
+			fprintf(stderr, "%s isn't read as a number.\n", NUMBERS[i]);
+			ret = false;
+		}
+		else if (memcmp(&BINTREE_NODE_VALUE(tree).value.number, &expected,
+		                sizeof expected))
+		{
+			fprintf(stderr, "%s is read as %.17g, strtod() gives %.17g\n",
+			        NUMBERS[i], BINTREE_NODE_VALUE(tree).value.number,
+			        expected);
+			ret = false;
+		}
+
+		bintree_destroy(tree);
+	}
+
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
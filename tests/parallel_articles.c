@@ -0,0 +1,163 @@
+/*!
+ * @file
+ * @brief Regression test of writing articles by several threads at once.
+ *
+ * Every thread selects its own node arena, parses expression, builds
+ * derivatives with their steps in an article and prints the last one.
+ * All threads should get the same derivative. Threads intern their own
+ * symbols meanwhile, so the symbol table grows while it is used.
+ */
+
+#include "common/test_utils.h"
+#include "../src/differentiator.h"
+#include "../src/parser/symbol.h"
+#include "../src/tex/tex.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Differentiated expression.
+ */
+static const char* const EXPRESSION = "a * sin(x) * cos(x) / (1 + x ^ 2) "
+                                      "- ln(b * x)";
+
+/*!
+ * @brief Order of the last derivative.
+ */
+static const size_t ORDER = 3;
+
+/*!
+ * @brief Amount of threads.
+ */
+enum { THREADS = 8 };
+
+/*!
+ * @brief Amount of own symbols of every thread.
+ */
+enum { OWN_SYMBOLS = 200 };
+
+
+
+
+/*!
+ * @brief Intern symbols which only given thread uses and check their names.
+ *
+ * @return Checking result.
+ */
+static bool intern_own_symbols
+(
+	size_t thread /*!< [in] number of thread.                                */
+)
+{
+	symbol_t symbols[OWN_SYMBOLS];
+	char     name[32] = "";
+	for (size_t i = 0; i < OWN_SYMBOLS; ++i)
+	{
+		int len = snprintf(name, sizeof name, "t%zu_%zu", thread, i);
+		symbols[i] = symbol_intern(name, (size_t) len);
+		if (symbols[i] == SYMBOL_NONE)
+			return false;
+	}
+
+	for (size_t i = 0; i < OWN_SYMBOLS; ++i)
+	{
+		snprintf(name, sizeof name, "t%zu_%zu", thread, i);
+		if (strcmp(symbol_name(symbols[i]), name))
+			return false;
+	}
+
+	return true;
+}
+
+/*!
+ * @brief Build derivatives in own arena and print the last one.
+ *
+ * @return The last derivative in tex format or NULL if an error occurred.
+ */
+static void* derivative_text
+(
+	void* arg /*!< [in] number of thread.                                    */
+)
+{
+	if (!intern_own_symbols((size_t) (uintptr_t) arg))
+		return NULL;
+
+	bintree_arena_t arena = bintree_arena_create();
+	if (!arena)
+		return NULL;
+
+	bintree_arena_select(arena);
+	sink_t    article    = sink_create_memory();
+	sink_t    text       = sink_create_memory();
+	bintree_t expression = test_parse(EXPRESSION);
+	tex_t     tex        = (article && expression)
+	                       ? start_article(article, expression, ORDER) : NULL;
+
+	bintree_t derivatives[ORDER + 1];
+	size_t    amount = 0;
+	derivatives[amount++] = expression;
+	while (tex && amount <= ORDER && derivatives[amount - 1])
+	{
+		derivatives[amount] = differentiate(derivatives[amount - 1], tex,
+		                                    DIFF_VERBOSITY_TOP);
+		++amount;
+	}
+
+	char* ret = NULL;
+	if (tex && text && derivatives[amount - 1] && amount == ORDER + 1)
+	{
+		print_expression(derivatives[ORDER], text);
+		if (finish_article(tex, derivatives, ORDER, 0))
+			ret = strdup(sink_data(text, NULL));
+	}
+	else if (tex)
+		abort_article(tex);
+
+	sink_destroy(text);
+	sink_destroy(article);
+	bintree_arena_destroy(arena);
+	return ret;
+}
+
+
+
+
+int main (void)
+{
+	pthread_t threads[THREADS];
+	size_t    started = 0;
+	while (started < THREADS
+	       && !pthread_create(&threads[started], NULL, derivative_text,
+	                          (void*) (uintptr_t) started))
+		++started;
+
+	// Derivatives of all threads are compared with the first one.
+	char* expected = NULL;
+	bool  ret      = started == THREADS;
+	for (size_t i = 0; i < started; ++i)
+	{
+		char* text = NULL;
+		pthread_join(threads[i], (void**) &text);
+		if (!text || (expected && strcmp(text, expected)))
+		{
+			fprintf(stderr, "Thread %zu got another derivative.\n", i);
+			ret = false;
+		}
+
+		if (!expected)
+			expected = text;
+		else
+			free(text);
+	}
+
+	free(expected);
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/*!
+ * @file
+ * @brief Regression test of parsing of input which is read by chunks.
+ *
+ * Expression is written to a pipe, so it can't be mapped and the parser
+ * reads it by chunks. Numbers with exponents and identifiers are split
+ * between chunks at different places. Parsed expression should be
+ * the same as parsed from string.
+ */
+
+#include "common/test_utils.h"
+#include "../src/parser/parser.h"
+#include "../src/parser/symbol.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+
+
+/*!
+ * @brief Terms of parsed expression.
+ */
+static const char* const TERMS[] =
+{
+	"1.25e-3 * x", "2.5E+12", "sin(x) ^ 3", "long_identifier_12345",
+	"\n(7 - x)", "0.000125", "123456789012345678901234567890", "ln(x)",
+};
+
+/*!
+ * @brief Amount of terms in expression.
+ */
+enum { TERMS_AMOUNT = 40000 };
+
+/*!
+ * @brief Size of pieces which expression is written by.
+ */
+enum { PIECE_SIZE = 1000 };
+
+/*!
+ * @brief Expression which is written to pipe.
+ */
+struct pipe_input
+{
+	const char* str; /*!< expression.                                        */
+	int         fd;  /*!< write end of pipe.                                 */
+};
+
+
+
+
+/*!
+ * @brief Write expression to pipe by pieces and close it.
+ *
+ * @return NULL.
+ */
+static void* write_input
+(
+	void* arg /*!< [in] pipe input.                                          */
+)
+{
+	const struct pipe_input* input = (const struct pipe_input*) arg;
+	size_t                   left  = strlen(input->str);
+	for (const char* cur = input->str; left;)
+	{
+		ssize_t written = write(input->fd, cur,
+		                        (left < PIECE_SIZE) ? left : PIECE_SIZE);
+		if (written <= 0)
+			break;
+
+		cur  += written;
+		left -= (size_t) written;
+	}
+
+	close(input->fd);
+	return NULL;
+}
+
+/*!
+ * @brief Build long expression of terms.
+ *
+ * @return Expression in text format or NULL if an error occurred.
+ */
+static char* long_expression (void)
+{
+	size_t size = 1;
+	for (size_t i = 0; i < TERMS_AMOUNT; ++i)
+		size += strlen(TERMS[i % (sizeof TERMS / sizeof *TERMS)]) + 3;
+
+	char* str = (char*) malloc(size);
+	if (!str)
+		return NULL;
+
+	char* cur = str;
+	for (size_t i = 0; i < TERMS_AMOUNT; ++i)
+	{
+		const char* term = TERMS[i % (sizeof TERMS / sizeof *TERMS)];
+		if (i)
+			cur = strcpy(cur, (i % 3) ? " + " : "-") + ((i % 3) ? 3 : 1);
+
+		cur = strcpy(cur, term) + strlen(term);
+	}
+
+	return str;
+}
+
+/*!
+ * @brief Parse expression from pipe.
+ *
+ * @return Expression tree or NULL if an error occurred.
+ */
+static bintree_t parse_pipe
+(
+	const char* str /*!< [in] expression in text format.                     */
+)
+{
+	int fds[2] = {-1, -1};
+	if (pipe(fds))
+		return BINTREE_NULL;
+
+	struct pipe_input input  = {str, fds[1]};
+	pthread_t         writer;
+	FILE*             stream = fdopen(fds[0], "r");
+	if (!stream || pthread_create(&writer, NULL, write_input, &input))
+	{
+		if (stream)
+			fclose(stream);
+		else
+			close(fds[0]);
+
+		close(fds[1]);
+		return BINTREE_NULL;
+	}
+
+	parser_t  parser;
+	bintree_t tree = BINTREE_NULL;
+	if (parser_init_file(&parser, stream))
+	{
+		tree = parse_expr(&parser);
+		parser_deinit(&parser);
+	}
+
+	// Writer is finished even if parsing has failed.
+	char rest[PIECE_SIZE];
+	while (fread(rest, 1, sizeof rest, stream))
+		continue;
+
+	pthread_join(writer, NULL);
+	fclose(stream);
+	return tree;
+}
+
+
+
+
+int main (void)
+{
+	char*     str      = long_expression();
+	bintree_t expected = (str) ? test_parse(str) : BINTREE_NULL;
+	bintree_t parsed   = (expected) ? parse_pipe(str) : BINTREE_NULL;
+	bool      ret      = parsed && bintree_equal(expected, parsed);
+	if (!ret)
+		fputs("Expression from pipe differs from the same string.\n",
+		      stderr);
+
+	bintree_destroy(parsed);
+	bintree_destroy(expected);
+	free(str);
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
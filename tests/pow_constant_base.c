@@ -0,0 +1,69 @@
+/*!
+ * @file
+ * @brief Regression test of differentiation of power with constant base.
+ *
+ * Power with base 0 or 1 is folded to a number while its derivative
+ * is built, the base shouldn't be used after that. Freed nodes are
+ * reused by the arena, so the test is run with -fsanitize=undefined.
+ */
+
+#include "common/test_utils.h"
+#include "../src/differentiator.h"
+#include "../src/parser/symbol.h"
+#include "../src/tex/tex.h"
+#include "../src/utilities/utilities.h"
+
+#include <stdio.h>
+
+
+
+
+/*!
+ * @brief Check derivative of expression to be zero.
+ *
+ * @return Checking result.
+ */
+static bool derivative_is_zero
+(
+	const char* str /*!< [in] expression in text format.                     */
+)
+{
+	// Free list of the arena is filled, so freed nodes are reused.
+	bintree_destroy(test_parse("(x + 1) * (x + 2) * sin(x) / cos(x) ^ x"));
+
+	bintree_t expression = test_parse(str);
+	bintree_t deriv      = (expression)
+	                       ? differentiate(expression, NULL,
+	                                       DIFF_VERBOSITY_NONE)
+	                       : BINTREE_NULL;
+	bool      ret        = deriv
+	                       && BINTREE_NODE_VALUE(deriv).type == TOKEN_NUMBER
+	                       && double_equal(BINTREE_NODE_VALUE(deriv)
+	                                       .value.number, 0);
+	if (!ret)
+	{
+		fprintf(stderr, "Derivative of %s isn't zero: ", str);
+		if (deriv)
+		{
+			sink_t output = sink_create_file(stderr);
+			print_expression(deriv, output);
+			sink_destroy(output);
+		}
+
+		fputc('\n', stderr);
+	}
+
+	bintree_destroy(deriv);
+	bintree_destroy(expression);
+	return ret;
+}
+
+
+
+
+int main (void)
+{
+	bool ret = derivative_is_zero("0 ^ x") & derivative_is_zero("1 ^ x");
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/*!
+ * @file
+ * @brief Regression test of symbolic derivatives of higher orders.
+ *
+ * Derivatives are optimized after every differentiation, so a wrong
+ * simplification rule changes their values. Values of derivatives
+ * are compared with the coefficients of Taylor series.
+ */
+
+#include "common/test_utils.h"
+#include "../src/differentiator.h"
+#include "../src/parser/symbol.h"
+#include "../src/bytecode/bytecode.h"
+#include "../src/taylor/taylor.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define ORDER 5
+
+
+
+
+/*!
+ * @brief Compare symbolic derivatives of expression with Taylor series.
+ *
+ * @return Checking result.
+ */
+static bool derivatives_match
+(
+	const char* str,  /*!< [in] expression in text format.                   */
+	double      point /*!< [in] point of differentiation.                    */
+)
+{
+	bintree_t expression = test_parse(str);
+	if (!expression)
+		return false;
+
+	double coefficients[ORDER + 1] = {0};
+	bool   ret = taylor_coefficients(expression, point, ORDER, coefficients);
+
+	bintree_t current   = expression;
+	double    factorial = 1;
+	for (size_t order = 1; ret && order <= ORDER; ++order)
+	{
+		bintree_t deriv = differentiate(current, NULL, DIFF_VERBOSITY_NONE);
+		if (current != expression)
+			bintree_destroy(current);
+
+		current = deriv;
+		if (!deriv)
+		{
+			ret = false;
+			break;
+		}
+
+		bytecode_t code = bytecode_compile(deriv);
+		if (!code)
+		{
+			ret = false;
+			break;
+		}
+
+		factorial       *= (double) order;
+		double symbolic  = bytecode_evaluate(code, point);
+		double series    = coefficients[order] * factorial;
+		bytecode_destroy(code);
+
+		if (!(fabs(symbolic - series) <= 1e-9 * fmax(1, fabs(series))))
+		{
+			fprintf(stderr, "Derivative %zu of %s at %g is %.17g, "
+			                "Taylor series gives %.17g\n",
+			        order, str, point, symbolic, series);
+			ret = false;
+		}
+	}
+
+	if (current != expression)
+		bintree_destroy(current);
+
+	bintree_destroy(expression);
+	return ret;
+}
+
+
+
+
+int main (void)
+{
+	bool ret = derivatives_match("ctg(x)", 0.3)
+	           & derivatives_match("tg(x)", 0.3)
+	           & derivatives_match("ctg(2 * x + 1)", -0.7)
+	           & derivatives_match("x - tg(x) * (1 - x)", 1.1);
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/*!
+ * @file
+ * @brief Regression test of Taylor series of expressions.
+ *
+ * The first two coefficients of series are value of expression and
+ * value of its derivative. They should be the same as values of
+ * bytecode of expression and of its symbolic derivative.
+ */
+
+#include "common/test_utils.h"
+#include "../src/bytecode/bytecode.h"
+#include "../src/differentiator.h"
+#include "../src/parser/symbol.h"
+#include "../src/taylor/taylor.h"
+
+#include <math.h>
+#include <stdio.h>
+
+
+
+
+/*!
+ * @brief Checked expressions.
+ */
+static const char* const EXPRESSIONS[] =
+{
+	"x ^ 3 - 2 * x + 1",
+	"sin(x) * cos(2 * x) / (1 + x ^ 2)",
+	"tg(x / 2) - ctg(x + 1)",
+	"e ^ (x / 3) * ln(x * x + 1)",
+	"x ^ x + 2 ^ x - x ^ 0.5",
+};
+
+/*!
+ * @brief Points where expressions are evaluated.
+ */
+static const double POINTS[] = {0.2, 0.9, 1.7, 3.1};
+
+
+
+
+/*!
+ * @brief Compare two values.
+ *
+ * @return True if values are close else false.
+ */
+static bool close_values
+(
+	double value,   /*!< [in] checked value.                                 */
+	double expected /*!< [in] expected value.                                */
+)
+{
+	return fabs(value - expected) <= 1e-10 * fmax(1, fabs(expected));
+}
+
+/*!
+ * @brief Compare the first coefficients of series with bytecode.
+ *
+ * @return Checking result.
+ */
+static bool series_matches_bytecode
+(
+	const char* str /*!< [in] expression in text format.                     */
+)
+{
+	bintree_t  expression = test_parse(str);
+	bintree_t  deriv      = (expression)
+	                        ? differentiate(expression, NULL,
+	                                        DIFF_VERBOSITY_NONE)
+	                        : BINTREE_NULL;
+	bytecode_t value      = (deriv) ? bytecode_compile(expression) : NULL;
+	bytecode_t slope      = (deriv) ? bytecode_compile(deriv)      : NULL;
+	bool       ret        = value && slope;
+	for (size_t i = 0; ret && i < sizeof POINTS / sizeof *POINTS; ++i)
+	{
+		double coefficients[2] = {0};
+		double expected[2]     = {bytecode_evaluate(value, POINTS[i]),
+		                          bytecode_evaluate(slope, POINTS[i])};
+		if (!taylor_coefficients(expression, POINTS[i], 1, coefficients)
+		    || !close_values(coefficients[0], expected[0])
+		    || !close_values(coefficients[1], expected[1]))
+		{
+			fprintf(stderr, "Series of %s at %g starts with %.17g %.17g, "
+			                "bytecode gives %.17g %.17g\n",
+			        str, POINTS[i], coefficients[0], coefficients[1],
+			        expected[0], expected[1]);
+			ret = false;
+		}
+	}
+
+	bytecode_destroy(slope);
+	bytecode_destroy(value);
+	bintree_destroy(deriv);
+	bintree_destroy(expression);
+	return ret;
+}
+
+
+
+
+int main (void)
+{
+	bool ret = true;
+	for (size_t i = 0; i < sizeof EXPRESSIONS / sizeof *EXPRESSIONS; ++i)
+		ret = series_matches_bytecode(EXPRESSIONS[i]) && ret;
+
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*!
+ * @file
+ * @brief Regression test of labels of big subexpressions in article.
+ *
+ * Big subexpression is underbraced with a new label at its first
+ * appearance and only its label is printed later. Every label should
+ * be defined once before it is used, and some labels should be used.
+ */
+
+#include "common/test_utils.h"
+#include "../src/differentiator.h"
+#include "../src/parser/symbol.h"
+#include "../src/tex/tex.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Differentiated expression.
+ */
+static const char* const EXPRESSION = "sin(x ^ 2 + 3 * x + 1) "
+                                      "* cos(x ^ 2 + 3 * x + 1) / (1 + x)";
+
+/*!
+ * @brief Order of the last derivative.
+ */
+enum { ORDER = 2 };
+
+
+
+
+/*!
+ * @brief Check labels in the text of article.
+ *
+ * @return Checking result.
+ */
+static bool labels_are_reused
+(
+	const char* text /*!< [in] text of article.                              */
+)
+{
+	size_t reused = 0;
+	for (size_t number = 1; ; ++number)
+	{
+		char definition[32] = "";
+		char use[32]        = "";
+		snprintf(definition, sizeof definition, "}_{u_{%zu}}", number);
+		snprintf(use,        sizeof use,        "u_{%zu} ",    number);
+
+		const char* defined = strstr(text, definition);
+		const char* used    = strstr(text, use);
+		if (!defined)
+		{
+			if (number == 1 || used)
+			{
+				fprintf(stderr, "Label %zu isn't defined.\n", number);
+				return false;
+			}
+
+			break;
+		}
+
+		if (strstr(defined + 1, definition))
+		{
+			fprintf(stderr, "Label %zu is defined twice.\n", number);
+			return false;
+		}
+
+		if (used && used < defined)
+		{
+			fprintf(stderr, "Label %zu is used before definition.\n",
+			        number);
+			return false;
+		}
+
+		reused += used != NULL;
+	}
+
+	if (!reused)
+		fputs("Labels aren't used after definition.\n", stderr);
+
+	return reused;
+}
+
+
+
+
+int main (void)
+{
+	sink_t    article    = sink_create_memory();
+	bintree_t expression = test_parse(EXPRESSION);
+	tex_t     tex        = (article && expression)
+	                       ? start_article(article, expression, ORDER) : NULL;
+
+	bintree_t derivatives[ORDER + 1] = {expression};
+	size_t    amount                 = 1;
+	while (tex && amount <= ORDER && derivatives[amount - 1])
+	{
+		derivatives[amount] = differentiate(derivatives[amount - 1], tex,
+		                                    DIFF_VERBOSITY_FULL);
+		++amount;
+	}
+
+	bool ret = tex && derivatives[ORDER]
+	           && labels_are_reused(sink_data(article, NULL));
+	if (tex && derivatives[amount - 1] && amount == ORDER + 1)
+		ret = finish_article(tex, derivatives, ORDER, 0) && ret;
+	else if (tex)
+		abort_article(tex);
+
+	for (size_t i = 0; i < amount; ++i)
+		bintree_destroy(derivatives[i]);
+
+	sink_destroy(article);
+	symbol_table_destroy();
+	return (ret) ? 0 : 1;
+}
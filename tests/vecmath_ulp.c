@@ -0,0 +1,210 @@
+/*!
+ * @file
+ * @brief Regression test of accuracy of math functions over arrays.
+ *
+ * Vector kernels should stay within a few units in the last place of
+ * functions of the standard library on small, big and tiny arguments.
+ */
+
+#include "../src/vecmath/vecmath.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+
+
+/*!
+ * @brief Amount of checked arguments, it isn't a multiple of vector size.
+ */
+enum { AMOUNT = 20011 };
+
+/*!
+ * @brief Function over array and the same function of standard library.
+ */
+struct checked_function
+{
+	const char* name;                         /*!< name of function.         */
+	void        (*vector) (double*, size_t);  /*!< function over array.      */
+	double      (*scalar) (double);           /*!< standard function.        */
+	double      max_ulps;                     /*!< allowed error.            */
+	bool        positive;                     /*!< only positive arguments
+	                                               are used.                 */
+};
+
+/*!
+ * @brief Cotangent using the standard library.
+ *
+ * @return Cotangent of argument.
+ */
+static double cotangent
+(
+	double x /*!< [in] argument.                                             */
+)
+{
+	return 1 / tan(x);
+}
+
+/*!
+ * @brief Checked functions. Cotangent is compared with 1 / tan(x),
+ * which is rounded twice.
+ */
+static const struct checked_function FUNCTIONS[] =
+{
+	{"sin", vecmath_sin, sin,       2, false},
+	{"cos", vecmath_cos, cos,       2, false},
+	{"tg",  vecmath_tg,  tan,       3, false},
+	{"ctg", vecmath_ctg, cotangent, 4, false},
+	{"ln",  vecmath_ln,  log,       2, true},
+};
+
+
+
+
+/*!
+ * @brief Get the next pseudo-random number in [0, 1).
+ *
+ * @return Pseudo-random number.
+ */
+static double next_random
+(
+	uint64_t* state /*!< [in,out] state of generator.                        */
+)
+{
+	*state = *state * 6364136223846793005u + 1442695040888963407u;
+	return (double) (*state >> 11) / 9007199254740992.0;
+}
+
+/*!
+ * @brief Fill array by arguments of different magnitudes.
+ */
+static void fill_arguments
+(
+	double* args,    /*!< [out] arguments.                                   */
+	bool    positive /*!< [in]  only positive arguments are used.            */
+)
+{
+	uint64_t state = 1;
+	for (size_t i = 0; i < AMOUNT; ++i)
+	{
+		double r = next_random(&state);
+		switch (i % 4)
+		{
+			case 0:  args[i] = (r - 0.5) * 20;                   break;
+			case 1:  args[i] = (r - 0.5) * 2000;                 break;
+			case 2:  args[i] = ldexp(r, (int) (i % 80) - 40);    break;
+			default: args[i] = (r - 0.5) * 1e6;                  break;
+		}
+
+		if (positive)
+			args[i] = fabs(args[i]) + DBL_TRUE_MIN;
+	}
+}
+
+/*!
+ * @brief Get distance between value and exact one in units
+ * in the last place of exact value.
+ *
+ * @return Distance.
+ */
+static double ulps
+(
+	double value, /*!< [in] checked value.                                   */
+	double exact  /*!< [in] exact value.                                     */
+)
+{
+	if (value == exact || (isnan(value) && isnan(exact)))
+		return 0;
+
+	if (!isfinite(value) || !isfinite(exact))
+		return INFINITY;
+
+	int exponent = 0;
+	frexp(exact, &exponent);
+	double ulp = (exact) ? ldexp(1, exponent - DBL_MANT_DIG) : DBL_TRUE_MIN;
+	return fabs(value - exact) / fmax(ulp, DBL_TRUE_MIN);
+}
+
+/*!
+ * @brief Compare function over array with standard function.
+ *
+ * @return Checking result.
+ */
+static bool function_is_accurate
+(
+	const struct checked_function* function /*!< [in] checked function.      */
+)
+{
+	static double args[AMOUNT];
+	static double values[AMOUNT];
+	fill_arguments(args, function->positive);
+	memcpy(values, args, sizeof values);
+	function->vector(values, AMOUNT);
+
+	for (size_t i = 0; i < AMOUNT; ++i)
+	{
+		double exact = function->scalar(args[i]);
+		if (ulps(values[i], exact) > function->max_ulps)
+		{
+			fprintf(stderr, "%s(%.17g) is %.17g, standard library "
+			                "gives %.17g\n",
+			        function->name, args[i], values[i], exact);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * @brief Compare power over arrays with pow().
+ *
+ * @return Checking result.
+ */
+static bool power_is_accurate (void)
+{
+	static double bases[AMOUNT];
+	static double exponents[AMOUNT];
+	static double values[AMOUNT];
+	fill_arguments(bases, true);
+
+	uint64_t state = 2;
+	for (size_t i = 0; i < AMOUNT; ++i)
+	{
+		bases[i]     /= 1000;
+		exponents[i]  = (i % 5) ? (next_random(&state) - 0.5) * 40
+		                        : (double) (int) (i % 21) - 10;
+	}
+
+	memcpy(values, bases, sizeof values);
+	vecmath_pow(values, exponents, AMOUNT);
+	for (size_t i = 0; i < AMOUNT; ++i)
+	{
+		double exact = pow(bases[i], exponents[i]);
+		if (ulps(values[i], exact) > 2)
+		{
+			fprintf(stderr, "%.17g ^ %.17g is %.17g, standard library "
+			                "gives %.17g\n",
+			        bases[i], exponents[i], values[i], exact);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+
+int main (void)
+{
+	bool ret = power_is_accurate();
+	for (size_t i = 0; i < sizeof FUNCTIONS / sizeof *FUNCTIONS; ++i)
+		ret = function_is_accurate(&FUNCTIONS[i]) && ret;
+
+	return (ret) ? 0 : 1;
+}